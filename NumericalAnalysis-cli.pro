@@ -0,0 +1,15 @@
+CONFIG += console thread
+CONFIG -= app_bundle qt
+
+TARGET = NumericalAnalysis-cli
+TEMPLATE = app
+
+include(NumericalAnalysis-core.pri)
+
+SOURCES += \
+        src/cli.cpp \
+        src/job.cpp
+
+HEADERS += \
+        include/job.hpp \
+        include/job_queue.hpp
@@ -0,0 +1,68 @@
+# Numerical core shared by GUI and command line applications.
+# It doesn't depend on Qt.
+
+# Bulk evaluation of muParser spreads points over threads.
+DEFINES += MUP_USE_OPENMP
+msvc {
+    QMAKE_CXXFLAGS += -openmp
+} else {
+    QMAKE_CXXFLAGS += -fopenmp
+    QMAKE_LFLAGS += -fopenmp
+}
+
+INCLUDEPATH += \
+            $$PWD/include/ \
+            $$PWD/include/muParser
+
+SOURCES += \
+        $$PWD/src/analysis.cpp \
+        $$PWD/src/checkpoint.cpp \
+        $$PWD/src/incremental.cpp \
+        $$PWD/src/methods.cpp \
+        $$PWD/src/objective.cpp \
+        $$PWD/src/parser.cpp \
+        $$PWD/src/result.cpp \
+        $$PWD/src/tools.cpp \
+        $$PWD/src/matrix.cpp \
+        $$PWD/src/sparse_cholesky.cpp \
+        $$PWD/src/sparse_matrix.cpp \
+        $$PWD/src/muParser/muParser.cpp \
+        $$PWD/src/muParser/muParserBase.cpp \
+        $$PWD/src/muParser/muParserBytecode.cpp \
+        $$PWD/src/muParser/muParserCallback.cpp \
+        $$PWD/src/muParser/muParserDLL.cpp \
+        $$PWD/src/muParser/muParserError.cpp \
+        $$PWD/src/muParser/muParserInt.cpp \
+        $$PWD/src/muParser/muParserTest.cpp \
+        $$PWD/src/muParser/muParserTokenReader.cpp \
+        $$PWD/src/muParser/muParserVecMath.cpp
+
+HEADERS += \
+        $$PWD/include/analysis.hpp \
+        $$PWD/include/checkpoint.hpp \
+        $$PWD/include/incremental.hpp \
+        $$PWD/include/methods.hpp \
+        $$PWD/include/objective.hpp \
+        $$PWD/include/workspace.hpp \
+        $$PWD/include/parser.hpp \
+        $$PWD/include/result.hpp \
+        $$PWD/include/tools.hpp \
+        $$PWD/include/matrix.hpp \
+        $$PWD/include/sparse_cholesky.hpp \
+        $$PWD/include/sparse_matrix.hpp \
+        $$PWD/include/muParser/muParser.h \
+        $$PWD/include/muParser/muParserBase.h \
+        $$PWD/include/muParser/muParserBytecode.h \
+        $$PWD/include/muParser/muParserCallback.h \
+        $$PWD/include/muParser/muParserDef.h \
+        $$PWD/include/muParser/muParserDLL.h \
+        $$PWD/include/muParser/muParserError.h \
+        $$PWD/include/muParser/muParserFixes.h \
+        $$PWD/include/muParser/muParserFlatMap.h \
+        $$PWD/include/muParser/muParserInt.h \
+        $$PWD/include/muParser/muParserStack.h \
+        $$PWD/include/muParser/muParserTemplateMagic.h \
+        $$PWD/include/muParser/muParserTest.h \
+        $$PWD/include/muParser/muParserToken.h \
+        $$PWD/include/muParser/muParserTokenReader.h \
+        $$PWD/include/muParser/muParserVecMath.h
@@ -0,0 +1,23 @@
+#ifndef ANALYSIS_HPP
+#define ANALYSIS_HPP
+
+#include <vector>
+
+#include "muParser.h"
+
+namespace Analysis
+{
+// Degree of expressions which aren't polynomials along line.
+const int NOT_POLYNOMIAL = -1;
+// Polynomials of higher degree aren't told from other expressions.
+const int MAX_POLYNOMIAL_DEGREE = 64;
+
+std::vector<std::vector<int>> find_hessian_pattern(const mu::ParserBase& parser,
+                                                   const double* variables,
+                                                   unsigned variablesCount);
+int find_line_degree(const mu::ParserBase& parser, const double* variables,
+                     unsigned variablesCount,
+                     const std::vector<double>& direction);
+}
+
+#endif // ANALYSIS_HPP
@@ -0,0 +1,82 @@
+#ifndef CHECKPOINT_HPP
+#define CHECKPOINT_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * State of iterative method saved between its iterations: current point,
+ * count of completed iterations and rows of method specific data
+ * (matrix of quasi-Newton method, set of directions of Powell's method).
+ * Method given the state continues from it instead of starting over.
+ *
+ * State is tagged with hash of expression of objective. State of another
+ * objective isn't continued, method starts over seeding its rows from it.
+ *
+ * Binary file holds magic, format version, method, objective hash,
+ * iterations, variables count, point and rows, all in native byte order.
+ */
+class Checkpoint
+{
+public:
+    enum Method
+    {
+        NONE,
+        QUASINEWTON_PEARSON_TWO,
+        POWELL_TWO
+    };
+
+    static const unsigned VERSION = 2;
+
+    Checkpoint() :
+        mObjective(0),
+        mMethod(NONE),
+        mStateObjective(0),
+        mIterations(0) {}
+    Checkpoint(const std::string& path) :
+        mPath(path),
+        mObjective(0),
+        mMethod(NONE),
+        mStateObjective(0),
+        mIterations(0) {}
+
+    std::string getPath() const;
+    void setPath(const std::string& path);
+
+    void setObjective(const std::string& expression);
+    bool holdsObjective() const;
+
+    Method getMethod() const;
+    void setMethod(Method method);
+
+    unsigned getIterations() const;
+    void setIterations(unsigned iterations);
+
+    const std::vector<double>& getPoint() const;
+    void setPoint(const std::vector<double>& point);
+
+    const std::vector<std::vector<double>>& getRows() const;
+    std::vector<std::vector<double>>& getRows();
+
+    bool holds(Method method, unsigned variablesCount) const;
+    void clear();
+
+    bool save() const;
+    bool load();
+
+private:
+    std::string mPath;
+    // Hash of objective being minimized.
+    uint64_t mObjective;
+
+    Method mMethod;
+    // Hash of objective of state.
+    uint64_t mStateObjective;
+    unsigned mIterations;
+
+    std::vector<double> mPoint;
+    std::vector<std::vector<double>> mRows;
+};
+
+#endif // CHECKPOINT_HPP
@@ -0,0 +1,91 @@
+#ifndef INCREMENTAL_HPP
+#define INCREMENTAL_HPP
+
+#include <vector>
+
+#include "muParser.h"
+
+/*
+ * Evaluator of expression compiled by parser at points differing from the
+ * previous one in a few coordinates, as points of finite differences and
+ * of line searches along axes do. Bytecode is turned into a tree whose
+ * nodes keep their values at the previous point, and only nodes depending
+ * on changed coordinates are computed again. Results are the same as
+ * results of parser, bit for bit.
+ *
+ * Along a line the evaluator compiles bytecode of its own: subtrees not
+ * depending on coordinates moving with step are folded into constants, so
+ * a step costs the moving part of function only.
+ *
+ * Bytecode with if-then-else, assignments, loops, arrays, bulk or string
+ * functions, functions of more than three arguments or several results
+ * isn't supported; isSupported() tells whether the parser should be used
+ * instead.
+ */
+class IncrementalEvaluator
+{
+public:
+    // Evaluators with more dependencies fall back to parser.
+    static const unsigned MAX_DEPENDENCIES = 1 << 20;
+
+    IncrementalEvaluator() :
+        mIsSupported(false),
+        mIsValid(false) {}
+
+    void configure(const mu::ParserBase& parser, const double* variables,
+                   unsigned variablesCount);
+    bool isSupported() const;
+    void invalidate();
+
+    double evaluate(const std::vector<double>& x);
+    double evaluateLine(const std::vector<double>& position,
+                        const std::vector<double>& direction,
+                        const double alpha);
+
+private:
+    void configureLine(const std::vector<double>& position,
+                       const std::vector<double>& direction);
+    void compileLineNode(unsigned node, mu::ParserByteCode& byteCode);
+    double computeNode(unsigned node, const std::vector<double>& x);
+    void computeNodes(const std::vector<unsigned>& nodes,
+                      const std::vector<double>& x);
+
+    bool mIsSupported;
+    bool mIsValid;
+
+    // Tokens of nodes in order of bytecode, children before parents.
+    std::vector<mu::SToken> mTokens;
+    // Children of node i are mChildren[mFirstChild[i]] and on.
+    std::vector<unsigned> mFirstChild;
+    std::vector<unsigned> mChildren;
+    std::vector<unsigned> mParents;
+    // Coordinate read by node, -1 for nodes reading none.
+    std::vector<int> mVariables;
+    // Sorted nodes depending on each coordinate.
+    std::vector<std::vector<unsigned>> mDependents;
+    std::vector<unsigned> mAllNodes;
+
+    std::vector<double> mValues;
+    std::vector<double> mPoint;
+
+    // Line of the program, coordinates moving with step and their values
+    // read by the program.
+    std::vector<double> mLinePosition;
+    std::vector<double> mLineDirection;
+    std::vector<unsigned> mLineVariables;
+    std::vector<double> mLinePoint;
+    mu::Parser mLineParser;
+
+    // Scratch storage of line compilation, sized once per expression.
+    std::vector<char> mIsMoving;
+    std::vector<char> mIsDependent;
+    mu::ParserByteCode mLineByteCode;
+
+    // Scratch storage of evaluation.
+    std::vector<unsigned> mChanged;
+    std::vector<unsigned> mDirty;
+    std::vector<unsigned> mMerged;
+    std::vector<double> mArguments;
+};
+
+#endif // INCREMENTAL_HPP
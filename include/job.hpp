@@ -0,0 +1,38 @@
+#ifndef JOB_HPP
+#define JOB_HPP
+
+#include <string>
+#include <vector>
+
+/*
+ * Single minimization of batch runner: function, start point, method
+ * and precision, numbered by position in input.
+ */
+struct Job
+{
+    unsigned long index;
+
+    std::string expression;
+    unsigned variablesCount;
+    std::vector<double> start;
+
+    std::string method;
+    double epsilon;
+};
+
+namespace Jobs
+{
+const double DEFAULT_EPSILON = 1E-3;
+const char START_SEPARATOR = ';';
+// Jobs with more variables are rejected.
+const unsigned MAX_VARIABLES_COUNT = 1 << 20;
+
+Job parse_json(const std::string& line, unsigned long index);
+Job parse_csv(const std::string& line, unsigned long index);
+bool is_csv_header(const std::string& line);
+
+std::string run(const Job& job);
+std::string format_error(unsigned long index, const std::string& message);
+}
+
+#endif // JOB_HPP
@@ -0,0 +1,75 @@
+#ifndef JOB_QUEUE_HPP
+#define JOB_QUEUE_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+/*
+ * Queue of limited capacity between producing and consuming threads.
+ * Producer waits while queue is full, so memory doesn't grow with input.
+ */
+template <typename T>
+class JobQueue
+{
+public:
+    JobQueue(unsigned capacity) :
+        mCapacity(capacity > 0 ? capacity : 1),
+        mIsClosed(false) {}
+
+    /*
+     * Adds @item, waiting for free place.
+     */
+    void push(T item)
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+
+        mNotFull.wait(lock, [this] { return mItems.size() < mCapacity; });
+        mItems.push_back(std::move(item));
+
+        mNotEmpty.notify_one();
+    }
+
+    /*
+     * Takes next item to @item, waiting for one. Returns false once queue
+     * is closed and empty.
+     */
+    bool pop(T& item)
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+
+        mNotEmpty.wait(lock, [this] { return !mItems.empty() || mIsClosed; });
+        if (mItems.empty())
+            return false;
+
+        item = std::move(mItems.front());
+        mItems.pop_front();
+
+        mNotFull.notify_one();
+
+        return true;
+    }
+
+    /*
+     * Tells consumers that no more items come.
+     */
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        mIsClosed = true;
+        mNotEmpty.notify_all();
+    }
+
+private:
+    const size_t mCapacity;
+    bool mIsClosed;
+
+    std::deque<T> mItems;
+
+    std::mutex mMutex;
+    std::condition_variable mNotFull;
+    std::condition_variable mNotEmpty;
+};
+
+#endif // JOB_QUEUE_HPP
@@ -30,7 +30,7 @@ private:
 
     constexpr static const char* VARIABLES_COUNT_LABEL = "Variables:";
     static const unsigned VARIABLES_COUNT_MIN = 1;
-    static const unsigned VARIABLES_COUNT_MAX = 10;
+    static const unsigned VARIABLES_COUNT_MAX = 10000;
     static const unsigned VARIABLES_COUNT_DEFAULT = VARIABLES_COUNT_MIN;
 
     static const unsigned VARIABLES_VALUES_TEXT_HEIGHT = 24;
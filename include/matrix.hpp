@@ -29,9 +29,17 @@ public:
     matrix transpose();
     matrix inverse();
 
+    bool modified_cholesky();
+    void cholesky_solve(const std::vector<double>& b,
+                        std::vector<double>& x) const;
+
     int get_rows() const;
     int get_cols() const;
 
+    void multiply(const std::vector<double>& vec,
+                  std::vector<double>& dst) const;
+    void fill(double value);
+
     void set_name(const char* name);
     const char* get_name() const;
 
@@ -1,17 +1,55 @@
 #ifndef METHODS
 #define METHODS
 
-#include "mainwindow.hpp"
+#include <vector>
+
+#include "checkpoint.hpp"
 #include "result.hpp"
 
 namespace Methods
 {
 const double INITIAL_ALPHA = 0.01;
 const double NEWTON_BETA_FACTOR = 2.0;
+const double NEWTON_ARMIJO_FACTOR = 1E-4;
 const unsigned MAX_ITERATIONS = 30;
+// Line searches of polynomials of degree up to this one are solved in
+// closed form.
+const int MAX_CLOSED_FORM_DEGREE = 4;
+const unsigned CLOSED_FORM_PASSES = 3;
+
+const double TRUST_REGION_RADIUS = 1.0;
+const double TRUST_REGION_MAX_RADIUS = 1E3;
+const double TRUST_REGION_ETA = 0.1;
+
+const unsigned SIMPLEX_MAX_ITERATIONS = 1000;
+
+const double LEVENBERG_MARQUARDT_DAMPING = 1E-3;
+const unsigned LEAST_SQUARES_MAX_ITERATIONS = 100;
+
+const unsigned LBFGS_MEMORY = 5;
+
+const double AUGMENTED_PENALTY = 10.0;
+const double AUGMENTED_PENALTY_FACTOR = 10.0;
+const unsigned AUGMENTED_MAX_ITERATIONS = 20;
+
+const double EVOLUTION_INITIAL_SIGMA = 0.5;
+const unsigned EVOLUTION_MAX_GENERATIONS = 1000;
+const unsigned EVOLUTION_SEED = 1;
+// Coarse evaluation ranks generations while values of parents spread
+// over more than this fraction of the best value.
+const double EVOLUTION_COARSE_SPREAD = 1E-3;
+
+enum TrustRegionSubproblem
+{
+    DOGLEG,
+    STEIHAUG_CG
+};
 
 void sven_value(double (*f)(const double), const double initial,
                 double& left_bound, double& right_bound);
+void sven_value(double (*f)(const double), const double initial,
+                const double lower, const double upper,
+                double& left_bound, double& right_bound);
 void sven_derivative(double (*df)(const double), const double initial,
                      double& left_bound, double& right_bound);
 
@@ -36,6 +74,9 @@ double fibonacci_two(double (*f)(const double),
                      double& left_bound, double& right_bound,
                      const double epsilon);
 
+void set_line_degree(double (*f)(const double), int (*fDegree)());
+double line_search(double (*f)(const double), const double epsilon);
+
 double newton(double (*df)(const double), double (*ddf)(const double),
               const double initial, const double epsilon);
 double linear_interpolation(double (*df)(const double),
@@ -67,12 +108,77 @@ Result step_adjusting_newton(double (*fMono)(const double alpha),
                              std::vector<double>& direction,
                              const double epsilon);
 
+Result sparse_newton(double (*fMono)(const double alpha),
+                     double (*fMulti)(const std::vector<double>&),
+                     const std::vector<std::vector<int>>& pattern,
+                     std::vector<double>& variables,
+                     std::vector<double>& initial,
+                     std::vector<double>& direction,
+                     const double epsilon);
+
+Result trust_region_newton(double (*fMono)(const double alpha),
+                           double (*fMulti)(const std::vector<double>&),
+                           std::vector<double>& variables,
+                           std::vector<double>& initial,
+                           std::vector<double>& direction,
+                           const double epsilon,
+                           const TrustRegionSubproblem subproblem = DOGLEG);
+
+Result gauss_newton(double (*fMono)(const double alpha),
+                    double (*fMulti)(const std::vector<double>&),
+                    void (*fResiduals)(const std::vector<std::vector<double>>&,
+                                       std::vector<std::vector<double>>&),
+                    std::vector<double>& variables,
+                    std::vector<double>& initial,
+                    std::vector<double>& direction,
+                    const double epsilon);
+
+Result levenberg_marquardt(double (*fMono)(const double alpha),
+                           double (*fMulti)(const std::vector<double>&),
+                           void (*fResiduals)(const std::vector<std::vector<double>>&,
+                                              std::vector<std::vector<double>>&),
+                           std::vector<double>& variables,
+                           std::vector<double>& initial,
+                           std::vector<double>& direction,
+                           const double epsilon);
+
+Result projected_lbfgs(double (*fMono)(const double alpha),
+                       double (*fMulti)(const std::vector<double>&),
+                       const std::vector<double>& lower,
+                       const std::vector<double>& upper,
+                       std::vector<double>& variables,
+                       std::vector<double>& initial,
+                       std::vector<double>& direction,
+                       const double epsilon);
+
+Result augmented_lagrangian(void (*fConstrained)(const std::vector<double>&,
+                                                 std::vector<double>&),
+                            unsigned equalitiesCount,
+                            Result (*method)(double (*)(const double),
+                                             double (*)(const std::vector<double>&),
+                                             std::vector<double>&,
+                                             std::vector<double>&,
+                                             std::vector<double>&,
+                                             const double),
+                            std::vector<double>& variables,
+                            std::vector<double>& initial,
+                            std::vector<double>& direction,
+                            const double epsilon);
+
 Result quasinewton_pearson_two(double (*fMono)(const double alpha),
                                double (*fMulti)(const std::vector<double>&),
                                std::vector<double>& variables,
                                std::vector<double>& initial,
                                std::vector<double>& direction,
                                const double epsilon);
+Result quasinewton_pearson_two(double (*fMono)(const double alpha),
+                               double (*fMulti)(const std::vector<double>&),
+                               std::vector<double>& variables,
+                               std::vector<double>& initial,
+                               std::vector<double>& direction,
+                               const double epsilon,
+                               Checkpoint& checkpoint,
+                               const unsigned checkpointInterval);
 
 Result mcg_daniel(double (*fMono)(const double alpha),
                   double (*fMulti)(const std::vector<double>&),
@@ -81,12 +187,41 @@ Result mcg_daniel(double (*fMono)(const double alpha),
                   std::vector<double>& direction,
                   const double epsilon);
 
+Result nelder_mead(double (*fMono)(const double alpha),
+                   double (*fMulti)(const std::vector<double>&),
+                   void (*fBatch)(const std::vector<std::vector<double>>&,
+                                  std::vector<double>&),
+                   std::vector<double>& variables,
+                   std::vector<double>& initial,
+                   std::vector<double>& direction,
+                   const double epsilon,
+                   const unsigned parallelVertices = 1);
+
+Result cma_es(double (*fMono)(const double alpha),
+              double (*fMulti)(const std::vector<double>&),
+              void (*fBatch)(const std::vector<std::vector<double>>&,
+                             std::vector<double>&),
+              std::vector<double>& variables,
+              std::vector<double>& initial,
+              std::vector<double>& direction,
+              const double epsilon,
+              void (*fCoarseBatch)(const std::vector<std::vector<double>>&,
+                                   std::vector<double>&) = nullptr);
+
 Result powell_two(double (*fMono)(const double alpha),
                   double (*fMulti)(const std::vector<double>&),
                   std::vector<double>& variables,
                   std::vector<double>& initial,
                   std::vector<double>& direction,
                   const double epsilon);
+Result powell_two(double (*fMono)(const double alpha),
+                  double (*fMulti)(const std::vector<double>&),
+                  std::vector<double>& variables,
+                  std::vector<double>& initial,
+                  std::vector<double>& direction,
+                  const double epsilon,
+                  Checkpoint& checkpoint,
+                  const unsigned checkpointInterval);
 }
 
 #endif
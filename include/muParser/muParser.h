@@ -110,6 +110,7 @@ namespace mu
     static value_type Max(const value_type*, int);  // maximum
 
     static int IsVal(const char_type* a_szExpr, int *a_iPos, value_type *a_fVal);
+    static int IsValStream(const char_type* a_szExpr, int *a_iPos, value_type *a_fVal);
   };
 } // namespace mu
 
@@ -87,8 +87,11 @@ private:
     /** \brief Type used for parser tokens. */
     typedef ParserToken<value_type, string_type> token_type;
 
-    /** \brief Maximum number of threads spawned by OpenMP when using the bulk mode. */
-    static const int s_MaxNumOpenMPThreads = 16;
+    /** \brief Maximum number of points of a chunk of a bulk evaluated by one thread at once. */
+    static const int s_BulkChunkSize = 1024;
+
+    /** \brief Number of points evaluated together when the bytecode allows it in bulk mode. */
+    static const int s_BulkBlockSize = 64;
 
  public:
 
@@ -109,6 +112,9 @@ private:
 	  value_type  Eval() const;
     value_type* Eval(int &nStackSize) const;
     void Eval(value_type *results, int nBulkSize);
+    void EvalBulk(value_type *results, int nOffset, int nCount, value_type *pStack, int nWorkerID = 0) const;
+    std::size_t GetBulkStackSize() const;
+    static int GetBulkChunkSize(int nBulkSize, int nWorkers);
 
     int GetNumResults() const;
 
@@ -121,6 +127,8 @@ private:
 
     void EnableOptimizer(bool a_bIsOn=true);
     void EnableBuiltInOprt(bool a_bIsOn=true);
+    void SetMathAccuracy(EMathAccuracy a_eAccuracy);
+    EMathAccuracy GetMathAccuracy() const;
 
     bool HasBuiltInOprt() const;
     void AddValIdent(identfun_type a_pCallback);
@@ -137,6 +145,17 @@ private:
       AddCallback( a_strName, ParserCallback(a_pFun, a_bAllowOpt), m_FunDef, ValidNameChars() );
     }
 
+    /** \brief Define a parser function of one argument with a kernel for blocks of values.
+        \param a_strName Name of the function
+        \param a_pFun Pointer to the callback function
+        \param a_pVecFun Kernel applying the function to a block of values in bulk mode
+        \param a_bAllowOpt A flag indicating this function may be optimized
+    */
+    void DefineFun(const string_type &a_strName, fun_type1 a_pFun, vecfun_type1 a_pVecFun, bool a_bAllowOpt = true)
+    {
+      AddCallback( a_strName, ParserCallback(a_pFun, a_pVecFun, a_bAllowOpt), m_FunDef, ValidNameChars() );
+    }
+
     void DefineOprt(const string_type &a_strName, 
                     fun_type2 a_pFun, 
                     unsigned a_iPri=0, 
@@ -145,6 +164,7 @@ private:
     void DefineConst(const string_type &a_sName, value_type a_fVal);
     void DefineStrConst(const string_type &a_sName, const string_type &a_strVal);
     void DefineVar(const string_type &a_sName, value_type *a_fVar);
+    void DefineArray(const string_type &a_sName, value_type *a_pVar, int a_iSize, int a_iStride=1);
     void DefinePostfixOprt(const string_type &a_strFun, fun_type1 a_pOprt, bool a_bAllowOpt=true);
     void DefineInfixOprt(const string_type &a_strName, fun_type1 a_pOprt, int a_iPrec=prINFIX, bool a_bAllowOpt=true);
 
@@ -162,6 +182,9 @@ private:
     const valmap_type& GetConst() const;
     const string_type& GetExpr() const;
     const funmap_type& GetFunDef() const;
+    const funmap_type& GetInfixOprtDef() const;
+    const ParserByteCode& GetByteCode() const;
+    void SetByteCode(const ParserByteCode &a_ByteCode, int a_nNumResults);
     string_type GetVersion(EParserVersionInfo eInfo = pviFULL) const;
 
     const char_type ** GetOprtDef() const;
@@ -261,6 +284,15 @@ private:
                    ParserStack<token_type> &a_stVal, 
                    int iArgCount) const; 
 
+    void ApplyArray(ParserStack<token_type> &a_stOpt,
+                    ParserStack<token_type> &a_stVal, 
+                    int a_iArgCount) const;
+
+    void ApplyLoop(ParserStack<token_type> &a_stOpt,
+                   ParserStack<token_type> &a_stVal, 
+                   std::vector<int> &a_vLoopPos,
+                   int a_iArgCount) const;
+
     token_type ApplyStrFunc(const token_type &a_FunTok,
                             const std::vector<token_type> &a_vArg) const;
 
@@ -271,7 +303,9 @@ private:
 
     value_type ParseString() const; 
     value_type ParseCmdCode() const;
-    value_type ParseCmdCodeBulk(int nOffset, int nThreadID) const;
+    value_type ParseCmdCodeBulk(int nOffset, int nWorkerID, value_type *Stack) const;
+    template<typename TStack>
+    void ParseCmdCodeBlock(int nOffset, int nCount, TStack *Stack, value_type *pResults) const;
 
     void  CheckName(const string_type &a_strName, const string_type &a_CharSet) const;
     void  CheckOprt(const string_type &a_sName,
@@ -299,8 +333,10 @@ private:
     valmap_type  m_ConstDef;       ///< user constants.
     strmap_type  m_StrVarDef;      ///< user defined string constants
     varmap_type  m_VarDef;         ///< user defind variables.
+    arrmap_type  m_ArrDef;         ///< user defined array variables.
 
     bool m_bBuiltInOp;             ///< Flag that can be used for switching built in operators on and off
+    EMathAccuracy m_eMathAccuracy; ///< Accuracy of block kernels of functions in bulk mode
 
     string_type m_sNameChars;      ///< Charset for names
     string_type m_sOprtChars;      ///< Charset for postfix/ binary operator tokens
@@ -310,6 +346,7 @@ private:
 
     // items merely used for caching state information
     mutable valbuf_type m_vStackBuffer; ///< This is merely a buffer used for the stack in the cmd parsing routine
+    std::vector<valbuf_type> m_vBulkStacks; ///< Stacks of bulk evaluation, one per thread
     mutable int m_nFinalResultIdx;
 };
 
@@ -66,6 +66,7 @@ namespace mu
         generic_fun_type ptr;
         int   argc;
         int   idx;
+        vecfun_type1 vec;   // block kernel of a function with one argument, or 0
       } Fun;
 
       struct //SOprtData
@@ -73,6 +74,21 @@ namespace mu
         value_type *ptr;
         int offset;
       } Oprt;
+
+      struct //SArrData
+      {
+        value_type *ptr;
+        int size;
+        int stride;
+        int pos;        // stack position of the loop index (cmVARIDX_LOOP only)
+      } Arr;
+
+      struct //SLoopData
+      {
+        int pos;        // stack position of the loop index, followed by its bound and the accumulator
+        int offset;
+        ECmdCode red;   // cmADD or cmMUL
+      } Loop;
     };
   };
   
@@ -111,25 +127,36 @@ private:
 
 public:
 
+    /** \brief Maximum number of arguments of a function taking any number of them 
+               when the bytecode is evaluated over blocks of points. */
+    static const int s_MaxBlockArgCount = 16;
+
     ParserByteCode();
     ParserByteCode(const ParserByteCode &a_ByteCode);
     ParserByteCode& operator=(const ParserByteCode &a_ByteCode);
     void Assign(const ParserByteCode &a_ByteCode);
 
     void AddVar(value_type *a_pVar);
+    void AddOptimizedVar(const SToken &a_Tok, value_type *a_pVar);
     void AddVal(value_type a_fVal);
     void AddOp(ECmdCode a_Oprt);
     void AddIfElse(ECmdCode a_Oprt);
     void AddAssignOp(value_type *a_pVar);
-    void AddFun(generic_fun_type a_pFun, int a_iArgc);
+    void AddFun(generic_fun_type a_pFun, int a_iArgc, vecfun_type1 a_pVecFun = 0);
     void AddBulkFun(generic_fun_type a_pFun, int a_iArgc);
     void AddStrFun(generic_fun_type a_pFun, int a_iArgc, int a_iIdx);
+    void AddArrayVar(value_type *a_pVar, int a_iSize, int a_iStride);
+    int AddLoop(ECmdCode a_Reduction);
+    void AddLoopVar(int a_iPos);
+    void AddLoopEnd(int a_iPos, ECmdCode a_Reduction);
 
     void EnableOptimizer(bool bStat);
+    void RebaseVar(const value_type *a_pOldBase, value_type *a_pNewBase, std::size_t a_iCount);
 
-    void Finalize();
+    void Finalize(bool a_bShrink = true);
     void clear();
     std::size_t GetMaxStackSize() const;
+    bool CanEvalBlocks() const;
     std::size_t GetSize() const;
 
     const SToken* GetBase() const;
@@ -54,6 +54,7 @@ class ParserCallback
 public:
     ParserCallback(fun_type0  a_pFun, bool a_bAllowOpti);
     ParserCallback(fun_type1  a_pFun, bool a_bAllowOpti, int a_iPrec = -1, ECmdCode a_iCode=cmFUNC);
+    ParserCallback(fun_type1  a_pFun, vecfun_type1 a_pVecFun, bool a_bAllowOpti);
     ParserCallback(fun_type2  a_pFun, bool a_bAllowOpti, int a_iPrec, EOprtAssociativity a_eAssociativity);
     ParserCallback(fun_type2  a_pFun, bool a_bAllowOpti);
     ParserCallback(fun_type3  a_pFun, bool a_bAllowOpti);
@@ -88,6 +89,7 @@ public:
 
     bool  IsOptimizable() const;
     void* GetAddr() const;
+    vecfun_type1 GetVecAddr() const;
     ECmdCode  GetCode() const;
     ETypeCode GetType() const;
     int GetPri()  const;
@@ -108,11 +110,12 @@ private:
     ECmdCode  m_iCode;
     ETypeCode m_iType;
     bool  m_bAllowOpti;             ///< Flag indication optimizeability 
+    vecfun_type1 m_pVecFun;         ///< Kernel applying the function to a block of values, or 0
 };
 
 //------------------------------------------------------------------------------
 /** \brief Container for Callback objects. */
-typedef std::map<string_type, ParserCallback> funmap_type; 
+typedef ParserFlatMap<string_type, ParserCallback> funmap_type; 
 
 } // namespace mu
 
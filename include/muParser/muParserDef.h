@@ -33,6 +33,7 @@
 #include <map>
 
 #include "muParserFixes.h"
+#include "muParserFlatMap.h"
 
 /** \file
     \brief This file contains standard definitions used by the parser.
@@ -59,6 +60,17 @@
 */
 //#define MUP_USE_OPENMP
 
+/** \brief Let the compiler vectorize the following loop.
+
+  Loops of the block evaluation in bulk mode have no dependencies
+  between points. Without OpenMP the compiler decides on its own.
+*/
+#if defined(_OPENMP)
+  #define MUP_SIMD _Pragma("omp simd")
+#else
+  #define MUP_SIMD
+#endif
+
 #if defined(_UNICODE)
   /** \brief Definition of the basic parser string type. */
   #define MUP_STRING_TYPE std::wstring
@@ -183,6 +195,14 @@ namespace mu
     cmVARMUL,
     cmPOW2,
 
+    // array variables and loops
+    cmVARIDX,              ///< Array element, the index is taken from the stack
+    cmVARIDX_LOOP,         ///< Array element indexed by a loop index
+    cmLOOP,                ///< Reduction over a loop index such as sum(i, 0, n, x[i])
+    cmLOOP_BEGIN,          ///< Start of a loop body
+    cmLOOP_END,            ///< End of a loop body
+    cmLOOPVAR,             ///< Loop index
+
     // operators and functions
     cmFUNC,                ///< Code for a generic function item
     cmFUNC_STR,            ///< Code for a function with a string parameter
@@ -239,6 +259,15 @@ namespace mu
     prPOSTFIX = 6  ///< Postfix operator priority (currently unused)
   };
 
+  //------------------------------------------------------------------------------
+  /** \brief Accuracy of built-in functions evaluated over blocks in bulk mode. */
+  enum EMathAccuracy
+  {
+    maULP1 = 1,              ///< Results within 1 ulp of the exact value
+    maULP4 = 4,              ///< Faster kernels, results within 4 ulp
+    maSingle = 1 << 29       ///< Blocks evaluated in single precision, faster kernels
+  };
+
   //------------------------------------------------------------------------------
   // basic types
 
@@ -268,13 +297,24 @@ namespace mu
   // Data container types
 
   /** \brief Type used for storing variables. */
-  typedef std::map<string_type, value_type*> varmap_type;
+  typedef ParserFlatMap<string_type, value_type*> varmap_type;
   
   /** \brief Type used for storing constants. */
-  typedef std::map<string_type, value_type> valmap_type;
+  typedef ParserFlatMap<string_type, value_type> valmap_type;
   
   /** \brief Type for assigning a string name to an index in the internal string table. */
-  typedef std::map<string_type, std::size_t> strmap_type;
+  typedef ParserFlatMap<string_type, std::size_t> strmap_type;
+
+  /** \brief Array variable of #size values, each #stride values after the previous one. */
+  struct SArrayVar
+  {
+    value_type *ptr;
+    int size;
+    int stride;
+  };
+
+  /** \brief Type used for storing array variables. */
+  typedef ParserFlatMap<string_type, SArrayVar> arrmap_type;
 
   // Parser callbacks
   
@@ -314,7 +354,11 @@ namespace mu
   /** \brief Callback type used for functions with five arguments. */
   typedef value_type (*fun_type10)(value_type, value_type, value_type, value_type, value_type, value_type, value_type, value_type, value_type, value_type);
 
-  /** \brief Callback type used for functions without arguments. */
+  /** \brief Callback type used for functions without arguments. 
+  
+      Bulk functions take the index of the point and the worker id given to
+      ParserBase::EvalBulk() before their arguments.
+  */
   typedef value_type (*bulkfun_type0)(int, int);
 
   /** \brief Callback type used for functions with a single arguments. */
@@ -350,6 +394,9 @@ namespace mu
   /** \brief Callback type used for functions with a variable argument list. */
   typedef value_type (*multfun_type)(const value_type*, int);
 
+  /** \brief Kernel of a function with one argument applied in place to a block of values. */
+  typedef void (*vecfun_type1)(value_type*, int, EMathAccuracy);
+
   /** \brief Callback type used for functions taking a string as an argument. */
   typedef value_type (*strfun_type1)(const char_type*);
 
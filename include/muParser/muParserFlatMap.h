@@ -0,0 +1,145 @@
+#ifndef MU_PARSER_FLAT_MAP_H
+#define MU_PARSER_FLAT_MAP_H
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <vector>
+
+/** \file
+    \brief This file defines the container of the parser symbol tables.
+*/
+
+namespace mu
+{
+
+  /** \brief Sorted associative container with shared storage.
+
+      Items are kept sorted by key in a single vector, so a lookup is a
+      binary search over contiguous memory and items are iterated in the
+      same order as in a std::map. Copies share the vector until one of them
+      is modified; the modified copy takes its own vector first. Copying
+      a parser, and with it all of its symbol tables, copies no items.
+
+      Items can't be changed through iterators, use operator[] instead.
+      Modifying a map invalidates iterators of that map only.
+  */
+  template<typename TKey, typename TValue>
+  class ParserFlatMap
+  {
+  public:
+
+    typedef TKey key_type;
+    typedef TValue mapped_type;
+    typedef std::pair<TKey, TValue> value_type;
+    typedef std::vector<value_type> storage_type;
+    typedef typename storage_type::size_type size_type;
+    typedef typename storage_type::const_iterator const_iterator;
+    typedef typename storage_type::const_reverse_iterator const_reverse_iterator;
+    typedef const_iterator iterator;
+    typedef const_reverse_iterator reverse_iterator;
+
+    ParserFlatMap()
+      :m_pItems(std::make_shared<storage_type>())
+    {}
+
+    ParserFlatMap(const ParserFlatMap &a_Map)
+      :m_pItems(a_Map.m_pItems)
+    {}
+
+    ParserFlatMap& operator=(const ParserFlatMap &a_Map)
+    {
+      m_pItems = a_Map.m_pItems;
+      return *this;
+    }
+
+    const_iterator begin() const { return m_pItems->begin(); }
+    const_iterator end() const { return m_pItems->end(); }
+    const_reverse_iterator rbegin() const { return m_pItems->rbegin(); }
+    const_reverse_iterator rend() const { return m_pItems->rend(); }
+
+    size_type size() const { return m_pItems->size(); }
+    bool empty() const { return m_pItems->empty(); }
+
+    const_iterator find(const TKey &a_Key) const
+    {
+      const_iterator item = std::lower_bound(begin(), end(), a_Key, KeyLess());
+      return (item!=end() && !(a_Key<item->first)) ? item : end();
+    }
+
+    size_type count(const TKey &a_Key) const
+    {
+      return find(a_Key)!=end() ? 1 : 0;
+    }
+
+    TValue& operator[](const TKey &a_Key)
+    {
+      Detach();
+
+      typename storage_type::iterator item =
+        std::lower_bound(m_pItems->begin(), m_pItems->end(), a_Key, KeyLess());
+
+      if (item==m_pItems->end() || a_Key<item->first)
+        item = m_pItems->insert(item, value_type(a_Key, TValue()));
+
+      return item->second;
+    }
+
+    void erase(const_iterator a_Item)
+    {
+      size_type iIdx = a_Item - begin();
+
+      Detach();
+      m_pItems->erase(m_pItems->begin() + iIdx);
+    }
+
+    size_type erase(const TKey &a_Key)
+    {
+      const_iterator item = find(a_Key);
+      if (item==end())
+        return 0;
+
+      erase(item);
+      return 1;
+    }
+
+    void clear()
+    {
+      if (m_pItems.use_count()!=1)
+        m_pItems = std::make_shared<storage_type>();
+      else
+        m_pItems->clear();
+    }
+
+  private:
+
+    struct KeyLess
+    {
+      bool operator()(const value_type &a_Item, const TKey &a_Key) const
+      {
+        return a_Item.first<a_Key;
+      }
+    };
+
+    /** \brief Make sure no other map shares the items before they are modified. */
+    void Detach()
+    {
+      if (m_pItems.use_count()!=1)
+      {
+        m_pItems = std::make_shared<storage_type>(*m_pItems);
+      }
+      else
+      {
+        // The last other owner may have released the items just now,
+        // its reads must not be reordered after our writes.
+        std::atomic_thread_fence(std::memory_order_acquire);
+      }
+    }
+
+    std::shared_ptr<storage_type> m_pItems;
+  };
+
+} // namespace mu
+
+#endif
@@ -218,6 +218,45 @@ namespace mu
         return *this;
       }
 
+      //------------------------------------------------------------------------------
+      /** \brief Make this token an array element token. 
+
+          The element index is given by the expression in square brackets following 
+          the token.
+          \param a_pArr The array, it must stay valid until the bytecode is created.
+          \throw nothrow
+      */
+      ParserToken& SetArray(const SArrayVar *a_pArr, const TString &a_strTok)
+      {
+        m_iCode = cmVARIDX;
+        m_iType = tpDBL;
+        m_strTok = a_strTok;
+        m_iIdx = -1;
+        m_pTok = (void*)a_pArr;
+        m_pCallback.reset(0);
+        return *this;
+      }
+
+      //------------------------------------------------------------------------------
+      /** \brief Make this token a loop token (cmLOOP) or a loop index token (cmLOOPVAR). 
+
+          \param a_iIdx For loops the operator code of the reduction (cmADD or cmMUL), 
+                        for loop indices the nesting level of their loop.
+          \throw nothrow
+      */
+      ParserToken& SetLoop(ECmdCode a_iType, int a_iIdx, const TString &a_strTok)
+      {
+        assert(a_iType==cmLOOP || a_iType==cmLOOPVAR);
+
+        m_iCode = a_iType;
+        m_iType = tpDBL;
+        m_strTok = a_strTok;
+        m_iIdx = a_iIdx;
+        m_pTok = 0;
+        m_pCallback.reset(0);
+        return *this;
+      }
+
       //------------------------------------------------------------------------------
       /** \brief Make this token a variable token. 
       
@@ -255,13 +294,15 @@ namespace mu
       /** \brief Return Index associated with the token related data. 
       
           In cmSTRFUNC - This is the index to a string table in the main parser.
+          In cmLOOP - This is the operator code of the reduction.
+          In cmLOOPVAR - This is the nesting level of the loop.
 
-          \throw exception_type if #m_iIdx<0 or #m_iType!=cmSTRING
+          \throw exception_type if #m_iIdx<0 or #m_iType is none of cmSTRING, cmLOOP, cmLOOPVAR
           \return The index the result will take in the Bytecode calculatin array (#m_iIdx).
       */
       int GetIdx() const
       {
-        if (m_iIdx<0 || m_iCode!=cmSTRING )
+        if (m_iIdx<0 || (m_iCode!=cmSTRING && m_iCode!=cmLOOP && m_iCode!=cmLOOPVAR))
           throw ParserError(ecINTERNAL_ERROR);
 
         return m_iIdx;
@@ -339,6 +380,13 @@ namespace mu
         return (m_pCallback.get()) ? (generic_fun_type)m_pCallback->GetAddr() : 0;
       }
 
+      //------------------------------------------------------------------------------
+      /** \brief Return the kernel applying the function to a block of values, 0 if there is none. */
+      vecfun_type1 GetVecFuncAddr() const
+      {
+        return (m_pCallback.get()) ? m_pCallback->GetVecAddr() : 0;
+      }
+
       //------------------------------------------------------------------------------
       /** \biref Get value of the token.
         
@@ -369,6 +417,20 @@ namespace mu
         return (TBase*)m_pTok;
       }
 
+      //------------------------------------------------------------------------------
+      /** \brief Get the array of an array element token.
+
+        Valid only if m_iType==cmVARIDX.
+        \throw exception_type if token is no array element token.
+      */
+      const SArrayVar* GetArray() const
+      {
+        if (m_iCode!=cmVARIDX)
+	        throw ParserError(ecINTERNAL_ERROR);
+
+        return (const SArrayVar*)m_pTok;
+      }
+
       //------------------------------------------------------------------------------
       /** \brief Return the number of function arguments. 
 
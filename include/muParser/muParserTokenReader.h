@@ -36,6 +36,7 @@
 #include <memory>
 #include <stack>
 #include <string>
+#include <vector>
 
 #include "muParserDef.h"
 #include "muParserToken.h"
@@ -115,6 +116,7 @@ namespace mu
                        string_type &a_strTok, 
                        int a_iPos) const;
       int ExtractOperatorToken(string_type &a_sTok, int a_iPos) const;
+      int ExtractName(string_type &a_sTok, int a_iPos);
 
       bool IsBuiltIn(token_type &a_Tok);
       bool IsArgSep(token_type &a_Tok);
@@ -127,6 +129,10 @@ namespace mu
       bool IsVarTok(token_type &a_Tok);
       bool IsStrVarTok(token_type &a_Tok);
       bool IsUndefVarTok(token_type &a_Tok);
+      bool IsArrayTok(token_type &a_Tok);
+      bool IsLoopTok(token_type &a_Tok);
+      bool IsLoopVarTok(token_type &a_Tok);
+      bool IsKnownName(const string_type &a_sName) const;
       bool IsString(token_type &a_Tok);
       void Error(EErrorCodes a_iErrc, 
                  int a_iPos = -1, 
@@ -134,6 +140,14 @@ namespace mu
 
       token_type& SaveBeforeReturn(const token_type &tok);
 
+      /** \brief Loop whose index is known in the loop body. */
+      struct SLoopScope
+      {
+        string_type sIdx;    ///< Name of the loop index
+        std::size_t iDepth;  ///< Number of open brackets including the one of the loop
+        int iArg;            ///< Loop argument being read: 1 lower bound, 2 upper bound, 3 body
+      };
+
       ParserBase *m_pParser;
       string_type m_strFormula;
       int  m_iPos;
@@ -147,14 +161,19 @@ namespace mu
       const valmap_type *m_pConstDef;
       const strmap_type *m_pStrVarDef;
       varmap_type *m_pVarDef;  ///< The only non const pointer to parser internals
+      const arrmap_type *m_pArrDef;
       facfun_type m_pFactory;
       void *m_pFactoryData;
       std::list<identfun_type> m_vIdentFun; ///< Value token identification function
       varmap_type m_UsedVar;
       value_type m_fZero;      ///< Dummy value of zero, referenced by undefined variables
-      int m_iBrackets;
+      string_type m_sBrackets; ///< Opening brackets which are not closed yet
+      std::vector<SLoopScope> m_vLoops; ///< Loops which are not closed yet
       token_type m_lastTok;
       char_type m_cArgSep;     ///< The character used for separating function arguments
+      int m_iNamePos;          ///< Position of the last extracted name
+      int m_iNameEnd;          ///< Position after the last extracted name
+      string_type m_sName;     ///< The last extracted name
   };
 } // namespace mu
 
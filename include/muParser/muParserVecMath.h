@@ -0,0 +1,41 @@
+#ifndef MU_PARSER_VEC_MATH_H
+#define MU_PARSER_VEC_MATH_H
+
+#include "muParserDef.h"
+
+/** \file
+    \brief This file defines the block kernels of the built-in functions.
+*/
+
+namespace mu
+{
+
+  /** \brief Built-in functions applied in place to blocks of values.
+
+      Bulk mode evaluates the bytecode over blocks of points, so a function
+      token is one call over a whole block instead of one call per point.
+      The kernels have no branches depending on the values and are written
+      to be vectorized by the compiler.
+
+      With #maULP1 results are within 1 ulp of the exact value, with #maULP4
+      and #maSingle cheaper polynomials and argument reductions are used and
+      results are within 4 ulp. Functions without a cheaper variant use the accurate one
+      in both modes. Special values (zeros, infinities, NaN, negative
+      arguments of logarithms) give the same results as the C library.
+  */
+  class ParserVecMath
+  {
+  public:
+    static void Sin(value_type *a_pVal, int a_iCount, EMathAccuracy a_eAccuracy);
+    static void Cos(value_type *a_pVal, int a_iCount, EMathAccuracy a_eAccuracy);
+    static void Exp(value_type *a_pVal, int a_iCount, EMathAccuracy a_eAccuracy);
+    static void Ln(value_type *a_pVal, int a_iCount, EMathAccuracy a_eAccuracy);
+    static void Log2(value_type *a_pVal, int a_iCount, EMathAccuracy a_eAccuracy);
+    static void Log10(value_type *a_pVal, int a_iCount, EMathAccuracy a_eAccuracy);
+    static void Sqrt(value_type *a_pVal, int a_iCount, EMathAccuracy a_eAccuracy);
+    static void Abs(value_type *a_pVal, int a_iCount, EMathAccuracy a_eAccuracy);
+  };
+
+} // namespace mu
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef OBJECTIVE_HPP
+#define OBJECTIVE_HPP
+
+#include <vector>
+
+#include "workspace.hpp"
+
+/*
+ * Wraps multidimensional function and remembers value and gradient
+ * computed at the last requested point, so methods asking for f and
+ * its gradient at the same point several times pay for them once.
+ */
+class Objective
+{
+public:
+    Objective(double (*f)(const std::vector<double>&), Workspace& workspace) :
+        mFunction(f),
+        mWorkspace(workspace),
+        mHasValue(false),
+        mHasGradient(false),
+        mValue(0.0),
+        mPoint(workspace.size()),
+        mGradient(workspace.size()) {}
+
+    double value(const std::vector<double>& x);
+    void gradient(const std::vector<double>& x, std::vector<double>& g);
+    double value_and_gradient(const std::vector<double>& x,
+                              std::vector<double>& g);
+
+    void reset();
+
+private:
+    double (*mFunction)(const std::vector<double>&);
+    Workspace& mWorkspace;
+
+    bool mHasValue;
+    bool mHasGradient;
+
+    double mValue;
+    std::vector<double> mPoint;
+    std::vector<double> mGradient;
+
+    void move_to(const std::vector<double>& x);
+};
+
+#endif // OBJECTIVE_HPP
@@ -3,20 +3,66 @@
 
 #include "muParser.h"
 
+/*
+ * Parsers and variables are per thread, so each thread may configure and
+ * evaluate its own function.
+ */
 class Parser
 {
 public:
-    static mu::Parser sParser;
+    // Number of compiled functions kept by each thread.
+    static const unsigned CACHE_CAPACITY = 64;
 
-    static std::vector<double> sVariables;
-    static std::vector<double> sPosition;
-    static std::vector<double> sDirection;
+    static thread_local mu::Parser sParser;
+    static thread_local mu::Parser sBulkParser;
 
-    static void configureParser(const std::wstring& expression,
+    // Bulk parsers of residuals of least squares problem.
+    static thread_local std::vector<mu::Parser> sResidualParsers;
+
+    // Function followed by constraints, as comma separated expressions.
+    static thread_local mu::Parser sConstraintsParser;
+
+    static thread_local std::vector<double> sVariables;
+    static thread_local std::vector<double> sPosition;
+    static thread_local std::vector<double> sDirection;
+
+    // Values of variables of bulk parser, variable after variable.
+    static thread_local std::vector<double> sBulkVariables;
+
+    static void configureParser(const std::string& expression,
                                 unsigned variablesCount);
+    static void configureResiduals(const std::vector<std::string>& residuals,
+                                   unsigned variablesCount);
+    static void configureConstraints(const std::string& expression,
+                                     const std::vector<std::string>& equalities,
+                                     const std::vector<std::string>& inequalities,
+                                     unsigned variablesCount);
 
     static double evaluateFunctionMono(const double alpha);
     static double evaluateFunctionMulti(const std::vector<double>& x);
+    static void evaluateFunctionBatch(
+            const std::vector<std::vector<double>>& points,
+            std::vector<double>& values);
+    static void evaluateFunctionBatchCoarse(
+            const std::vector<std::vector<double>>& points,
+            std::vector<double>& values);
+    static void evaluateConstrained(const std::vector<double>& x,
+                                    std::vector<double>& values);
+    static void evaluateResidualsBatch(
+            const std::vector<std::vector<double>>& points,
+            std::vector<std::vector<double>>& values);
+
+    static std::vector<std::vector<int>> findHessianPattern();
+    static int findLineDegree();
+
+    static unsigned long getCacheHits();
+    static unsigned long getCacheMisses();
+
+private:
+    static void bindBulkVariables(const std::vector<std::vector<double>>& points);
+    static void evaluateBatch(const std::vector<std::vector<double>>& points,
+                              std::vector<double>& values,
+                              mu::EMathAccuracy accuracy);
 };
 
 #endif // PARSER_HPP
@@ -1,7 +1,8 @@
 #ifndef RESULT_HPP
 #define RESULT_HPP
 
-#include <QString>
+#include <string>
+#include <vector>
 
 class Result
 {
@@ -9,15 +10,27 @@ public:
     Result(const std::vector<double>& vector) :
         mNormalItrs(-1),
         mAccelerationItrs(-1),
+        mAcceptedSteps(-1),
+        mRejectedSteps(-1),
+        mGenerations(-1),
+        mEvaluations(-1),
         mVector(vector) {}
     Result(int normalItrs, const std::vector<double>& vector) :
         mNormalItrs(normalItrs),
         mAccelerationItrs(-1),
+        mAcceptedSteps(-1),
+        mRejectedSteps(-1),
+        mGenerations(-1),
+        mEvaluations(-1),
         mVector(vector) {}
     Result(int normalItrs, int accelerationItrs,
            const std::vector<double>& vector) :
         mNormalItrs(normalItrs),
         mAccelerationItrs(accelerationItrs),
+        mAcceptedSteps(-1),
+        mRejectedSteps(-1),
+        mGenerations(-1),
+        mEvaluations(-1),
         mVector(vector) {}
 
     int getNormalItrs() const;
@@ -26,15 +39,33 @@ public:
     int getAccelerationItrs() const;
     void setAccelerationItrs(int iterations);
 
+    int getAcceptedSteps() const;
+    void setAcceptedSteps(int steps);
+
+    int getRejectedSteps() const;
+    void setRejectedSteps(int steps);
+
+    int getGenerations() const;
+    void setGenerations(int generations);
+
+    int getEvaluations() const;
+    void setEvaluations(int evaluations);
+
     std::vector<double> getVector() const;
     void setVector(const std::vector<double>& vector);
 
-    QString getMessage() const;
+    std::string getMessage() const;
 
 private:
     int mNormalItrs;
     int mAccelerationItrs;
 
+    int mAcceptedSteps;
+    int mRejectedSteps;
+
+    int mGenerations;
+    int mEvaluations;
+
     std::vector<double> mVector;
 };
 
@@ -0,0 +1,52 @@
+#ifndef SPARSE_CHOLESKY_HPP
+#define SPARSE_CHOLESKY_HPP
+
+#include <utility>
+#include <vector>
+
+#include "sparse_matrix.hpp"
+
+/*
+ * Modified Cholesky factorization P (A + E) P^T = L L^T of symmetric sparse
+ * matrix A. Rows are reordered by minimum degree to limit fill of L, and
+ * diagonal shift E is chosen as by Gill and Murray, so L exists even for
+ * indefinite A and E is zero for well conditioned positive definite A.
+ *
+ * Ordering and nonzero pattern of L depend only on pattern of A, so they
+ * are computed once and reused for every matrix of that pattern.
+ */
+class sparse_cholesky
+{
+private:
+    int m_size;
+
+    // Original index of row at each position and position of each row.
+    std::vector<int> m_permutation;
+    std::vector<int> m_order;
+
+    // L by columns (CSC) in permuted indices, diagonal entry first.
+    std::vector<int> m_col_offsets;
+    std::vector<int> m_row_indices;
+    std::vector<double> m_values;
+
+    // Nonzeros left of diagonal in each row of L: (column, index in values).
+    std::vector<std::vector<std::pair<int, int>>> m_rows;
+
+    std::vector<double> m_work;
+
+    bool m_is_modified;
+
+public:
+    sparse_cholesky() = delete;
+    sparse_cholesky(const std::vector<std::vector<int>>& pattern);
+
+    bool factorize(const sparse_matrix& a);
+    void solve(const std::vector<double>& b, std::vector<double>& x);
+
+    int get_size() const;
+    int get_nonzeros() const;
+    bool is_modified() const;
+    const std::vector<int>& get_permutation() const;
+};
+
+#endif // SPARSE_CHOLESKY_HPP
@@ -0,0 +1,44 @@
+#ifndef SPARSE_MATRIX_HPP
+#define SPARSE_MATRIX_HPP
+
+#include <vector>
+
+#include "matrix.hpp"
+
+/*
+ * Matrix in compressed sparse row (CSR) format. Nonzeros of row @r are
+ * m_values[m_row_offsets[r] .. m_row_offsets[r + 1]) with columns taken
+ * from m_col_indices at the same positions, sorted within row.
+ * Compressed sparse column (CSC) form of a matrix is CSR of its transpose.
+ */
+class sparse_matrix
+{
+private:
+    int m_rows;
+    int m_cols;
+
+public:
+    std::vector<int> m_row_offsets;
+    std::vector<int> m_col_indices;
+    std::vector<double> m_values;
+
+    sparse_matrix() = delete;
+    sparse_matrix(int rows, int cols);
+    sparse_matrix(int cols, const std::vector<std::vector<int>>& pattern);
+
+    int get_rows() const;
+    int get_cols() const;
+    int get_nonzeros() const;
+
+    double get(int row, int col) const;
+    double* find(int row, int col);
+
+    sparse_matrix transpose() const;
+    matrix to_dense() const;
+
+    void multiply(const std::vector<double>& vec,
+                  std::vector<double>& dst) const;
+    std::vector<double> operator*(const std::vector<double>& vec) const;
+};
+
+#endif // SPARSE_MATRIX_HPP
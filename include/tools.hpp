@@ -2,26 +2,88 @@
 #define FUNCTIONS
 
 #include "matrix.hpp"
+#include "sparse_matrix.hpp"
+#include "workspace.hpp"
 
 namespace Tools
 {
-const double EPSILON = 1E-5;
+const unsigned NOISE_POINTS = 8;
+const double NOISE_STEP = 1E-6;
+
+enum DifferenceScheme
+{
+    FORWARD_DIFFERENCE,
+    CENTRAL_DIFFERENCE,
+    FOURTH_ORDER_DIFFERENCE,
+    EXTRAPOLATED_DIFFERENCE
+};
+
+void set_difference_scheme(const DifferenceScheme scheme);
+DifferenceScheme get_difference_scheme();
+void set_function_noise(const double noise);
+double get_function_noise();
+unsigned evaluations_per_gradient(unsigned variablesCount);
+double find_step(const double value, const unsigned order);
+double estimate_noise(double (*f)(const std::vector<double>&),
+                      const std::vector<double>& x);
 
 double first_derivative(double (*f)(const std::vector<double>&),
                         const std::vector<double>& x, int variableCount);
+double first_derivative(double (*f)(const std::vector<double>&),
+                        const std::vector<double>& x, int variableCount,
+                        const double fx);
+double perturbed_derivative(double (*f)(const std::vector<double>&),
+                            std::vector<double>& x, int variableCount,
+                            const double fx);
 double second_derivative(double (*f)(const std::vector<double>&),
                          const std::vector<double>& x,
                          int alphaVariableCount, int betaVariableCount);
+double perturbed_second_derivative(double (*f)(const std::vector<double>&),
+                                   std::vector<double>& x,
+                                   int alphaVariableCount,
+                                   int betaVariableCount);
 
 std::vector<double> find_gradient(double (*f)(const std::vector<double>&),
     const std::vector<double>& x);
 std::vector<double> find_antigradient(double (*f)(const std::vector<double>&),
     const std::vector<double>& x);
+void find_gradient(double (*f)(const std::vector<double>&),
+    const std::vector<double>& x, std::vector<double>& gradient,
+    Workspace& workspace);
+void find_gradient(double (*f)(const std::vector<double>&),
+    const std::vector<double>& x, const double fx,
+    std::vector<double>& gradient, Workspace& workspace);
+void find_antigradient(double (*f)(const std::vector<double>&),
+    const std::vector<double>& x, std::vector<double>& antigradient,
+    Workspace& workspace);
 matrix find_hessian(double (*f)(const std::vector<double>&),
                     const std::vector<double>& x);
+void find_hessian(double (*f)(const std::vector<double>&),
+                  const std::vector<double>& x, matrix& hessian,
+                  Workspace& workspace);
+std::vector<int> color_columns(const std::vector<std::vector<int>>& pattern,
+                               unsigned& colorsCount);
+sparse_matrix find_sparse_hessian(double (*f)(const std::vector<double>&),
+                                  const std::vector<double>& x,
+                                  const std::vector<std::vector<int>>& pattern,
+                                  const std::vector<int>& colors,
+                                  unsigned colorsCount);
+void find_sparse_hessian(double (*f)(const std::vector<double>&),
+                         const std::vector<double>& x,
+                         const std::vector<std::vector<int>>& pattern,
+                         const std::vector<int>& colors, unsigned colorsCount,
+                         sparse_matrix& hessian, Workspace& workspace);
+void find_jacobian(void (*f)(const std::vector<std::vector<double>>&,
+                             std::vector<std::vector<double>>&),
+                   const std::vector<double>& x,
+                   std::vector<double>& residuals, matrix& jacobian);
 double find_norm(const std::vector<double>& x);
+double find_dot_product(const std::vector<double>& x,
+                        const std::vector<double>& y);
 
 void normalize(std::vector<double>& x);
+void project(std::vector<double>& x, const std::vector<double>& lower,
+             const std::vector<double>& upper);
 void convert_dimensions(const double alpha,
     const std::vector<double>& initial, const std::vector<double>& direction,
     std::vector<double>& dst);
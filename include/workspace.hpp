@@ -0,0 +1,35 @@
+#ifndef WORKSPACE_HPP
+#define WORKSPACE_HPP
+
+#include <vector>
+
+/*
+ * Scratch vectors of multidimensional methods. All of them are sized once
+ * from variables count, so iterations reuse their storage instead of
+ * allocating temporaries.
+ */
+class Workspace
+{
+public:
+    Workspace(unsigned variablesCount) :
+        auxiliary(variablesCount),
+        gradient(variablesCount),
+        antigradient(variablesCount),
+        product(variablesCount) {}
+
+    unsigned size() const
+    {
+        return auxiliary.size();
+    }
+
+    // Perturbed point of finite differences.
+    std::vector<double> auxiliary;
+
+    std::vector<double> gradient;
+    std::vector<double> antigradient;
+
+    // Result of matrix by vector multiplication.
+    std::vector<double> product;
+};
+
+#endif // WORKSPACE_HPP
@@ -0,0 +1,550 @@
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+#include "analysis.hpp"
+
+namespace
+{
+/*
+ * Subexpression of bytecode: variables it depends on and whether it is
+ * affine in them.
+ */
+struct Term
+{
+    std::vector<int> variables;
+    bool linear;
+};
+
+Term constant_term()
+{
+    Term term;
+    term.linear = true;
+
+    return term;
+}
+
+void merge_variables(Term& dst, const Term& src)
+{
+    std::vector<int> merged;
+
+    std::set_union(dst.variables.begin(), dst.variables.end(),
+                   src.variables.begin(), src.variables.end(),
+                   std::back_inserter(merged));
+    dst.variables.swap(merged);
+}
+
+/*
+ * Marks every variable of @alpha as interacting with every variable
+ * of @beta.
+ */
+void add_interactions(std::vector<std::vector<int>>& pattern,
+                      const std::vector<int>& alpha,
+                      const std::vector<int>& beta)
+{
+    for (int row : alpha)
+        pattern[row].insert(pattern[row].end(), beta.begin(), beta.end());
+
+    for (int row : beta)
+        pattern[row].insert(pattern[row].end(), alpha.begin(), alpha.end());
+}
+
+void make_dense(std::vector<std::vector<int>>& pattern)
+{
+    for (unsigned row = 0; row < pattern.size(); ++row)
+    {
+        pattern[row].resize(pattern.size());
+
+        for (unsigned col = 0; col < pattern.size(); ++col)
+            pattern[row][col] = col;
+    }
+}
+
+bool is_linear_function(const mu::ParserBase& parser, mu::generic_fun_type f)
+{
+    static const mu::char_type* LINEAR_INFIX[] = { _T("-"), _T("+") };
+    static const mu::char_type* LINEAR_FUNCTIONS[] = { _T("sum") };
+
+    for (const mu::char_type* name : LINEAR_INFIX)
+    {
+        auto item = parser.GetInfixOprtDef().find(name);
+
+        if (item != parser.GetInfixOprtDef().end() &&
+            item->second.GetAddr() == (void*)f)
+            return true;
+    }
+
+    for (const mu::char_type* name : LINEAR_FUNCTIONS)
+    {
+        auto item = parser.GetFunDef().find(name);
+
+        if (item != parser.GetFunDef().end() &&
+            item->second.GetAddr() == (void*)f)
+            return true;
+    }
+
+    return false;
+}
+
+/*
+ * Subexpression of bytecode restricted to line: its degree in step and
+ * value, if it is a literal.
+ */
+struct LineTerm
+{
+    int degree;
+    bool isValue;
+    double value;
+};
+
+LineTerm line_term(int degree)
+{
+    LineTerm term;
+    term.degree = degree;
+    term.isValue = false;
+    term.value = 0.0;
+
+    return term;
+}
+
+/*
+ * Returns degree of product of terms of degrees @alpha and @beta.
+ */
+int multiply_degrees(int alpha, int beta)
+{
+    if (alpha == Analysis::NOT_POLYNOMIAL || beta == Analysis::NOT_POLYNOMIAL ||
+        alpha + beta > Analysis::MAX_POLYNOMIAL_DEGREE)
+        return Analysis::NOT_POLYNOMIAL;
+
+    return alpha + beta;
+}
+
+/*
+ * Returns degree of @base raised to power @exponent.
+ */
+int power_degree(const LineTerm& base, const LineTerm& exponent)
+{
+    if (base.degree == 0 && exponent.degree == 0)
+        return 0;
+
+    if (base.degree == Analysis::NOT_POLYNOMIAL || !exponent.isValue ||
+        exponent.value != std::floor(exponent.value) || exponent.value < 0.0 ||
+        base.degree * exponent.value > Analysis::MAX_POLYNOMIAL_DEGREE)
+        return Analysis::NOT_POLYNOMIAL;
+
+    return base.degree * (int)exponent.value;
+}
+
+/*
+ * Loop of bytecode with literal bounds: stack position of its index, first
+ * value of index and count of iterations.
+ */
+struct LineLoop
+{
+    int position;
+    double lower;
+    double count;
+};
+
+/*
+ * Returns degree of elements of @array at indices @first .. @last, which
+ * are variables stored at @variables if they are among them.
+ */
+int array_degree(const mu::SToken& array, double first, double last,
+                 const double* variables, unsigned variablesCount,
+                 const std::vector<double>& direction)
+{
+    first = std::max(std::floor(first), 0.0);
+    last = std::min(std::floor(last), (double)array.Arr.size - 1.0);
+
+    for (double element = first; element <= last; ++element)
+    {
+        std::ptrdiff_t idx = array.Arr.ptr +
+                (std::ptrdiff_t)element * array.Arr.stride - variables;
+
+        if (idx >= 0 && idx < (std::ptrdiff_t)variablesCount &&
+            direction[idx] != 0.0)
+            return 1;
+    }
+
+    return 0;
+}
+}
+
+/*
+ * Returns sparsity pattern of Hessian of expression compiled by @parser
+ * with respect to @variablesCount variables stored at @variables.
+ * Row i lists sorted columns j where second derivative by x_i and x_j
+ * may be nonzero, diagonal included. Comparisons are treated as piecewise
+ * constant. Expressions with if-then-else, assignments, loops or array
+ * elements indexed by variables give dense pattern.
+ */
+std::vector<std::vector<int>> Analysis::find_hessian_pattern(
+        const mu::ParserBase& parser, const double* variables,
+        unsigned variablesCount)
+{
+    std::vector<std::vector<int>> pattern(variablesCount);
+    std::vector<Term> stack;
+
+    const mu::SToken* token = parser.GetByteCode().GetBase();
+    bool isDense = false;
+
+    for (; token->Cmd != mu::cmEND && !isDense; ++token)
+    {
+        switch (token->Cmd)
+        {
+        case mu::cmVAL:
+            stack.push_back(constant_term());
+            break;
+
+        case mu::cmVAR:
+        case mu::cmVARMUL:
+        case mu::cmVARPOW2:
+        case mu::cmVARPOW3:
+        case mu::cmVARPOW4:
+        {
+            Term term = constant_term();
+            std::ptrdiff_t idx = token->Val.ptr - variables;
+
+            if (idx >= 0 && idx < (std::ptrdiff_t)variablesCount)
+            {
+                term.variables.push_back(idx);
+                term.linear = token->Cmd == mu::cmVAR ||
+                        token->Cmd == mu::cmVARMUL;
+            }
+
+            stack.push_back(term);
+            break;
+        }
+
+        case mu::cmADD:
+        case mu::cmSUB:
+        case mu::cmMUL:
+        case mu::cmDIV:
+        case mu::cmPOW:
+        {
+            Term right = stack.back();
+            stack.pop_back();
+            Term& left = stack.back();
+
+            bool isLeftConstant = left.variables.empty();
+            bool isRightConstant = right.variables.empty();
+
+            if (token->Cmd == mu::cmADD || token->Cmd == mu::cmSUB)
+            {
+                left.linear = left.linear && right.linear;
+            }
+            else if (isLeftConstant && isRightConstant)
+            {
+                // Constant stays constant.
+            }
+            else if (token->Cmd == mu::cmMUL &&
+                     (isLeftConstant || isRightConstant))
+            {
+                left.linear = isLeftConstant ? right.linear : left.linear;
+            }
+            else if (token->Cmd == mu::cmDIV && isRightConstant)
+            {
+                // Division by constant keeps structure of numerator.
+            }
+            else if (token->Cmd == mu::cmMUL)
+            {
+                add_interactions(pattern, left.variables, right.variables);
+                left.linear = false;
+            }
+            else if (token->Cmd == mu::cmDIV)
+            {
+                add_interactions(pattern, left.variables, right.variables);
+                add_interactions(pattern, right.variables, right.variables);
+                left.linear = false;
+            }
+            else
+            {
+                merge_variables(left, right);
+                add_interactions(pattern, left.variables, left.variables);
+                left.linear = false;
+                break;
+            }
+
+            merge_variables(left, right);
+            break;
+        }
+
+        case mu::cmLE:
+        case mu::cmGE:
+        case mu::cmNEQ:
+        case mu::cmEQ:
+        case mu::cmLT:
+        case mu::cmGT:
+        case mu::cmLAND:
+        case mu::cmLOR:
+            stack.pop_back();
+            stack.back() = constant_term();
+            break;
+
+        case mu::cmFUNC:
+        case mu::cmFUNC_BULK:
+        case mu::cmFUNC_STR:
+        {
+            int argc = token->Fun.argc;
+
+            if (argc < 0)
+                argc = -argc;
+
+            Term term = constant_term();
+            for (int count = 0; count < argc; ++count)
+            {
+                merge_variables(term, stack.back());
+                term.linear = term.linear && stack.back().linear;
+                stack.pop_back();
+            }
+
+            if (token->Cmd != mu::cmFUNC ||
+                !is_linear_function(parser, token->Fun.ptr))
+            {
+                add_interactions(pattern, term.variables, term.variables);
+                term.linear = term.variables.empty();
+            }
+
+            stack.push_back(term);
+            break;
+        }
+
+        default:
+            isDense = true;
+            break;
+        }
+    }
+
+    if (isDense)
+    {
+        make_dense(pattern);
+        return pattern;
+    }
+
+    for (unsigned row = 0; row < variablesCount; ++row)
+    {
+        pattern[row].push_back(row);
+        std::sort(pattern[row].begin(), pattern[row].end());
+        pattern[row].erase(std::unique(pattern[row].begin(),
+                                       pattern[row].end()),
+                           pattern[row].end());
+    }
+
+    return pattern;
+}
+
+/*
+ * Returns degree of expression compiled by @parser as polynomial in step
+ * along @direction from any point, where @variablesCount variables are
+ * stored at @variables. Coordinates with zero direction are constants.
+ * Sums and products over loops are analyzed if their bounds are literals;
+ * array elements indexed by terms constant along line count as moving if
+ * any element they may refer to moves.
+ * Returns NOT_POLYNOMIAL if expression has functions or comparisons of
+ * moving terms, divisions by them, powers of them with exponent other than
+ * nonnegative integer literal, loops with bounds other than literals
+ * (nested loops bounded by outer index included), array elements indexed
+ * by moving terms, or tokens not analyzed.
+ */
+int Analysis::find_line_degree(const mu::ParserBase& parser,
+                               const double* variables,
+                               unsigned variablesCount,
+                               const std::vector<double>& direction)
+{
+    // Stacks are kept between calls, so lines reuse their storage.
+    static thread_local std::vector<LineTerm> stack;
+    static thread_local std::vector<LineLoop> loops;
+    const mu::SToken* token = parser.GetByteCode().GetBase();
+
+    stack.clear();
+    loops.clear();
+
+    for (; token->Cmd != mu::cmEND; ++token)
+    {
+        switch (token->Cmd)
+        {
+        case mu::cmVAL:
+        {
+            LineTerm term = line_term(0);
+            term.isValue = true;
+            term.value = token->Val.data2;
+
+            stack.push_back(term);
+            break;
+        }
+
+        case mu::cmVAR:
+        case mu::cmVARMUL:
+        case mu::cmVARPOW2:
+        case mu::cmVARPOW3:
+        case mu::cmVARPOW4:
+        {
+            std::ptrdiff_t idx = token->Val.ptr - variables;
+            int degree = 0;
+
+            if (idx >= 0 && idx < (std::ptrdiff_t)variablesCount &&
+                direction[idx] != 0.0)
+                degree = token->Cmd == mu::cmVARPOW2 ? 2 :
+                         token->Cmd == mu::cmVARPOW3 ? 3 :
+                         token->Cmd == mu::cmVARPOW4 ? 4 : 1;
+
+            stack.push_back(line_term(degree));
+            break;
+        }
+
+        case mu::cmADD:
+        case mu::cmSUB:
+        case mu::cmMUL:
+        case mu::cmDIV:
+        case mu::cmPOW:
+        case mu::cmLE:
+        case mu::cmGE:
+        case mu::cmNEQ:
+        case mu::cmEQ:
+        case mu::cmLT:
+        case mu::cmGT:
+        case mu::cmLAND:
+        case mu::cmLOR:
+        {
+            LineTerm right = stack.back();
+            stack.pop_back();
+            LineTerm left = stack.back();
+
+            int degree;
+
+            if (token->Cmd == mu::cmADD || token->Cmd == mu::cmSUB)
+                degree = left.degree == NOT_POLYNOMIAL ||
+                         right.degree == NOT_POLYNOMIAL ?
+                            NOT_POLYNOMIAL : std::max(left.degree, right.degree);
+            else if (token->Cmd == mu::cmMUL)
+                degree = multiply_degrees(left.degree, right.degree);
+            else if (token->Cmd == mu::cmDIV)
+                degree = right.degree == 0 ? left.degree : NOT_POLYNOMIAL;
+            else if (token->Cmd == mu::cmPOW)
+                degree = power_degree(left, right);
+            else
+                degree = left.degree == 0 && right.degree == 0 ?
+                            0 : NOT_POLYNOMIAL;
+
+            stack.back() = line_term(degree);
+            break;
+        }
+
+        case mu::cmFUNC:
+        case mu::cmFUNC_BULK:
+        case mu::cmFUNC_STR:
+        {
+            int argc = token->Fun.argc;
+
+            if (argc < 0)
+                argc = -argc;
+
+            int degree = 0;
+            for (int count = 0; count < argc; ++count)
+            {
+                if (stack.back().degree == NOT_POLYNOMIAL)
+                    degree = NOT_POLYNOMIAL;
+                else if (degree != NOT_POLYNOMIAL)
+                    degree = std::max(degree, stack.back().degree);
+
+                stack.pop_back();
+            }
+
+            if (degree > 0 && (token->Cmd != mu::cmFUNC ||
+                               !is_linear_function(parser, token->Fun.ptr)))
+                degree = NOT_POLYNOMIAL;
+
+            stack.push_back(line_term(degree));
+            break;
+        }
+
+        case mu::cmVARIDX:
+        {
+            // Index is replaced by element on top of stack.
+            const LineTerm& index = stack.back();
+
+            if (index.degree != 0)
+                return NOT_POLYNOMIAL;
+
+            double first = index.isValue ? index.value : 0.0;
+            double last = index.isValue ? index.value : token->Arr.size - 1.0;
+
+            stack.back() = line_term(array_degree(*token, first, last,
+                                                  variables, variablesCount,
+                                                  direction));
+            break;
+        }
+
+        case mu::cmVARIDX_LOOP:
+        {
+            const LineLoop* loop = nullptr;
+            for (const LineLoop& item : loops)
+                if (item.position == token->Arr.pos)
+                    loop = &item;
+
+            if (!loop)
+                return NOT_POLYNOMIAL;
+
+            double last = loop->lower + loop->count - 1.0;
+
+            stack.push_back(line_term(array_degree(*token, loop->lower, last,
+                                                   variables, variablesCount,
+                                                   direction)));
+            break;
+        }
+
+        case mu::cmLOOPVAR:
+            stack.push_back(line_term(0));
+            break;
+
+        case mu::cmLOOP_BEGIN:
+        {
+            LineTerm upper = stack.back();
+            stack.pop_back();
+            LineTerm lower = stack.back();
+            stack.pop_back();
+
+            if (!lower.isValue || !upper.isValue)
+                return NOT_POLYNOMIAL;
+
+            LineLoop loop;
+            loop.position = token->Loop.pos;
+            loop.lower = lower.value;
+            loop.count = lower.value < upper.value ?
+                        std::ceil(upper.value - lower.value) : 0.0;
+
+            loops.push_back(loop);
+            break;
+        }
+
+        case mu::cmLOOP_END:
+        {
+            LineTerm body = stack.back();
+            stack.pop_back();
+
+            double count = loops.back().count;
+            int degree = body.degree;
+
+            if (count == 0.0)
+                degree = 0;
+            else if (token->Loop.red == mu::cmMUL && degree > 0)
+                degree = degree * count > MAX_POLYNOMIAL_DEGREE ?
+                            NOT_POLYNOMIAL : degree * (int)count;
+
+            loops.pop_back();
+            stack.push_back(line_term(degree));
+            break;
+        }
+
+        default:
+            return NOT_POLYNOMIAL;
+        }
+    }
+
+    // Several results or none.
+    if (stack.size() != 1)
+        return NOT_POLYNOMIAL;
+
+    return stack.back().degree;
+}
@@ -0,0 +1,238 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+
+#include "checkpoint.hpp"
+
+static const char MAGIC[4] = { 'N', 'A', 'C', 'P' };
+
+std::string Checkpoint::getPath() const
+{
+    return mPath;
+}
+
+void Checkpoint::setPath(const std::string& path)
+{
+    mPath = path;
+}
+
+/*
+ * Sets objective being minimized by its @expression. State saved from now
+ * on is tagged with it.
+ */
+void Checkpoint::setObjective(const std::string& expression)
+{
+    // FNV-1a, so hashes are the same across builds.
+    uint64_t hash = 14695981039346656037ULL;
+
+    for (unsigned char symbol : expression)
+        hash = (hash ^ symbol) * 1099511628211ULL;
+
+    mObjective = hash;
+}
+
+/*
+ * Returns true if state is of objective being minimized.
+ */
+bool Checkpoint::holdsObjective() const
+{
+    return mStateObjective == mObjective;
+}
+
+Checkpoint::Method Checkpoint::getMethod() const
+{
+    return mMethod;
+}
+
+/*
+ * Sets @method of state, which is then state of objective being minimized.
+ */
+void Checkpoint::setMethod(Method method)
+{
+    mMethod = method;
+    mStateObjective = mObjective;
+}
+
+unsigned Checkpoint::getIterations() const
+{
+    return mIterations;
+}
+
+void Checkpoint::setIterations(unsigned iterations)
+{
+    mIterations = iterations;
+}
+
+const std::vector<double>& Checkpoint::getPoint() const
+{
+    return mPoint;
+}
+
+void Checkpoint::setPoint(const std::vector<double>& point)
+{
+    mPoint = point;
+}
+
+const std::vector<std::vector<double>>& Checkpoint::getRows() const
+{
+    return mRows;
+}
+
+std::vector<std::vector<double>>& Checkpoint::getRows()
+{
+    return mRows;
+}
+
+/*
+ * Returns true if checkpoint holds state of @method for @variablesCount
+ * variables, so that method may continue from it.
+ */
+bool Checkpoint::holds(Method method, unsigned variablesCount) const
+{
+    if (mMethod != method || mPoint.size() != variablesCount)
+        return false;
+
+    for (const std::vector<double>& row : mRows)
+        if (row.size() != variablesCount)
+            return false;
+
+    return true;
+}
+
+/*
+ * Drops saved state, keeping path and objective.
+ */
+void Checkpoint::clear()
+{
+    mMethod = NONE;
+    mStateObjective = mObjective;
+    mIterations = 0;
+    mPoint.clear();
+    mRows.clear();
+}
+
+static void write_unsigned(std::ofstream& stream, uint32_t value)
+{
+    stream.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+static void write_hash(std::ofstream& stream, uint64_t value)
+{
+    stream.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+static void write_values(std::ofstream& stream, const std::vector<double>& values)
+{
+    stream.write(reinterpret_cast<const char*>(values.data()),
+                 values.size() * sizeof(double));
+}
+
+/*
+ * Writes state to file at path. Returns false if path is empty or file
+ * can't be written.
+ */
+bool Checkpoint::save() const
+{
+    if (mPath.empty())
+        return false;
+
+    // Complete file replaces previous one, so interrupted save keeps it.
+    std::string temporary = mPath + ".tmp";
+    std::ofstream stream(temporary, std::ios::binary | std::ios::trunc);
+    if (!stream)
+        return false;
+
+    stream.write(MAGIC, sizeof(MAGIC));
+    write_unsigned(stream, VERSION);
+    write_unsigned(stream, mMethod);
+    write_hash(stream, mStateObjective);
+    write_unsigned(stream, mIterations);
+    write_unsigned(stream, mPoint.size());
+    write_values(stream, mPoint);
+    write_unsigned(stream, mRows.size());
+    for (const std::vector<double>& row : mRows)
+        write_values(stream, row);
+
+    stream.close();
+    if (!stream)
+        return false;
+
+    std::remove(mPath.c_str());
+
+    return std::rename(temporary.c_str(), mPath.c_str()) == 0;
+}
+
+static bool read_unsigned(std::ifstream& stream, uint32_t& value)
+{
+    return static_cast<bool>(stream.read(reinterpret_cast<char*>(&value),
+                                         sizeof(value)));
+}
+
+static bool read_hash(std::ifstream& stream, uint64_t& value)
+{
+    return static_cast<bool>(stream.read(reinterpret_cast<char*>(&value),
+                                         sizeof(value)));
+}
+
+static bool read_values(std::ifstream& stream, std::vector<double>& values,
+                        uint32_t count, std::streamoff remaining)
+{
+    if (static_cast<std::streamoff>(count * sizeof(double)) > remaining)
+        return false;
+
+    values.resize(count);
+
+    return static_cast<bool>(stream.read(reinterpret_cast<char*>(values.data()),
+                                         count * sizeof(double)));
+}
+
+/*
+ * Reads state from file at path. Returns false, leaving state untouched,
+ * if file is missing, truncated or of another format version.
+ */
+bool Checkpoint::load()
+{
+    std::ifstream stream(mPath, std::ios::binary | std::ios::ate);
+    if (!stream)
+        return false;
+
+    std::streamoff size = stream.tellg();
+    stream.seekg(0);
+
+    char magic[sizeof(MAGIC)];
+    uint32_t version, method, iterations, variablesCount, rowsCount;
+    uint64_t objective;
+
+    if (!stream.read(magic, sizeof(magic)) ||
+        !std::equal(magic, magic + sizeof(magic), MAGIC) ||
+        !read_unsigned(stream, version) || version != VERSION ||
+        !read_unsigned(stream, method) || method > POWELL_TWO ||
+        !read_hash(stream, objective) ||
+        !read_unsigned(stream, iterations) ||
+        !read_unsigned(stream, variablesCount))
+        return false;
+
+    std::vector<double> point;
+    if (!read_values(stream, point, variablesCount, size - stream.tellg()) ||
+        !read_unsigned(stream, rowsCount))
+        return false;
+
+    // Rows count is checked against file size before allocating them.
+    if (variablesCount > 0 && static_cast<std::streamoff>(rowsCount) >
+            (size - stream.tellg()) / std::streamoff(variablesCount * sizeof(double)))
+        return false;
+
+    std::vector<std::vector<double>> rows(rowsCount);
+    for (std::vector<double>& row : rows)
+        if (!read_values(stream, row, variablesCount, size - stream.tellg()))
+            return false;
+
+    mMethod = static_cast<Method>(method);
+    mStateObjective = objective;
+    mIterations = iterations;
+    mPoint.swap(point);
+    mRows.swap(rows);
+
+    return true;
+}
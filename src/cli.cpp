@@ -0,0 +1,165 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef MUP_USE_OPENMP
+#include <omp.h>
+#endif
+
+#include "job.hpp"
+#include "job_queue.hpp"
+#include "parser.hpp"
+
+static const unsigned QUEUE_CAPACITY_PER_WORKER = 4;
+
+static void print_usage(const char* program)
+{
+    std::cerr << "Usage: " << program
+              << " [--threads N] [--queue N] [--format jsonl|csv] [--stats] [INPUT]\n"
+                 "Reads jobs from INPUT (standard input if missing or \"-\"),\n"
+                 "one JSON object or CSV line per job, and writes result of\n"
+                 "each job as JSON line as soon as it is ready.\n"
+                 "With --stats, prints hits and misses of cache of compiled\n"
+                 "functions to standard error at the end.\n";
+}
+
+/*
+ * Headless batch runner. Main thread reads and parses jobs, workers solve
+ * them and write results in order of completion; records carry index of
+ * job in input. Queue between them is bounded, so input of any size is
+ * processed in constant memory.
+ */
+int main(int argc, char* argv[])
+{
+    unsigned threadsCount = std::thread::hardware_concurrency(),
+            queueCapacity = 0;
+    std::string inputPath = "-", format;
+    bool printStats = false;
+
+    for (int idx = 1; idx < argc; ++idx)
+    {
+        std::string argument = argv[idx];
+
+        if ((argument == "--threads" || argument == "--queue" ||
+             argument == "--format") && idx + 1 < argc)
+        {
+            std::string value = argv[++idx];
+
+            if (argument == "--threads")
+                threadsCount = strtoul(value.c_str(), nullptr, 10);
+            else if (argument == "--queue")
+                queueCapacity = strtoul(value.c_str(), nullptr, 10);
+            else
+                format = value;
+        }
+        else if (argument == "--stats")
+            printStats = true;
+        else if (argument == "--help" || argument == "-h")
+        {
+            print_usage(argv[0]);
+            return 0;
+        }
+        else if (argument[0] == '-' && argument != "-")
+        {
+            print_usage(argv[0]);
+            return 2;
+        }
+        else
+            inputPath = argument;
+    }
+
+    if (threadsCount == 0)
+        threadsCount = 1;
+    if (queueCapacity == 0)
+        queueCapacity = QUEUE_CAPACITY_PER_WORKER * threadsCount;
+
+    if (format.empty())
+        format = inputPath.size() > 4 &&
+                inputPath.compare(inputPath.size() - 4, 4, ".csv") == 0 ?
+                    "csv" : "jsonl";
+    if (format != "csv" && format != "jsonl")
+    {
+        print_usage(argv[0]);
+        return 2;
+    }
+
+    std::ifstream file;
+    if (inputPath != "-")
+    {
+        file.open(inputPath);
+        if (!file)
+        {
+            std::cerr << "Can't open " << inputPath << "\n";
+            return 1;
+        }
+    }
+    std::istream& input = inputPath != "-" ? file : std::cin;
+
+    std::ios::sync_with_stdio(false);
+
+    std::mutex outputMutex;
+    auto write = [&outputMutex](const std::string& record)
+    {
+        std::lock_guard<std::mutex> lock(outputMutex);
+        std::cout << record << '\n' << std::flush;
+    };
+
+    JobQueue<Job> queue(queueCapacity);
+    std::vector<std::thread> workers;
+
+    for (unsigned idx = 0; idx < threadsCount; ++idx)
+        workers.emplace_back([&queue, &write, threadsCount]
+        {
+#ifdef MUP_USE_OPENMP
+            // Jobs already share cores, so bulk evaluation of each one
+            // stays in its worker.
+            if (threadsCount > 1)
+                omp_set_num_threads(1);
+#endif
+
+            Job job;
+            while (queue.pop(job))
+                write(Jobs::run(job));
+        });
+
+    std::string line;
+    unsigned long index = 0;
+    bool isCsv = format == "csv";
+
+    while (std::getline(input, line))
+    {
+        if (line.empty() || line[0] == '#' ||
+            (isCsv && index == 0 && Jobs::is_csv_header(line)))
+            continue;
+
+        try
+        {
+            queue.push(isCsv ? Jobs::parse_csv(line, index) :
+                               Jobs::parse_json(line, index));
+        }
+        catch (std::exception& exc)
+        {
+            write(Jobs::format_error(index, exc.what()));
+        }
+
+        ++index;
+    }
+
+    queue.close();
+    for (std::thread& worker : workers)
+        worker.join();
+
+    if (printStats)
+        std::cerr << "Compiled functions cache: "
+                  << Parser::getCacheHits() << " hits, "
+                  << Parser::getCacheMisses() << " misses\n";
+
+    return 0;
+}
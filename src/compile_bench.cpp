@@ -0,0 +1,202 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "muParser.h"
+#include "parser.hpp"
+
+static const unsigned DEFAULT_EXPRESSIONS_COUNT = 20000;
+static const unsigned DEFAULT_VARIABLES_COUNT = 10;
+static const unsigned MAX_DEPTH = 6;
+
+static void print_usage(const char* program)
+{
+    std::cerr << "Usage: " << program
+              << " [--expressions N] [--variables N]\n"
+                 "Compiles N generated expressions and prints how many\n"
+                 "expressions and characters are compiled per second.\n";
+}
+
+/*
+ * Appends random expression of depth up to @depth over @variablesCount
+ * variables to @expression.
+ */
+static void generate_expression(std::mt19937& random, unsigned depth,
+                                unsigned variablesCount,
+                                std::string& expression)
+{
+    static const char* const OPERATORS[] = { "+", "-", "*", "/", "^" };
+    static const char* const FUNCTIONS[] = { "sin", "cos", "exp", "sqrt",
+                                             "log", "abs", "tanh" };
+
+    unsigned kind = depth == 0 ? random() % 2 : random() % 5;
+
+    if (kind == 0)
+    {
+        expression += "x" + std::to_string(random() % variablesCount);
+    }
+    else if (kind == 1)
+    {
+        static const char* const VALUES[] = { "2", "0.5", "3.25", "1e-3",
+                                              "100", "_pi", "1.5E2" };
+        expression += VALUES[random() % 7];
+    }
+    else if (kind == 2)
+    {
+        expression += FUNCTIONS[random() % 7];
+        expression += "(";
+        generate_expression(random, depth - 1, variablesCount, expression);
+        expression += ")";
+    }
+    else
+    {
+        const char* oprt = OPERATORS[random() % 5];
+
+        expression += "(";
+        generate_expression(random, depth - 1, variablesCount, expression);
+        expression += std::string(" ") + oprt + " ";
+        if (oprt[0] == '^')
+            expression += std::to_string(random() % 4 + 1);
+        else
+            generate_expression(random, depth - 1, variablesCount, expression);
+        expression += ")";
+    }
+}
+
+static double seconds_since(std::chrono::steady_clock::time_point begin)
+{
+    return std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - begin).count();
+}
+
+static void print_throughput(const char* title, unsigned count,
+                             unsigned long characters, double seconds)
+{
+    std::cout << title << ": " << count << " expressions in "
+              << seconds << " s, " << count / seconds << " expressions/s, "
+              << characters / seconds / 1E6 << " MB/s\n";
+}
+
+/*
+ * Compile throughput benchmark. Expressions are compiled by muParser
+ * directly, then configured by Parser, and at last a few of them are
+ * configured over and over, so they are served by cache of compiled
+ * functions.
+ */
+int main(int argc, char* argv[])
+{
+    unsigned expressionsCount = DEFAULT_EXPRESSIONS_COUNT,
+            variablesCount = DEFAULT_VARIABLES_COUNT;
+
+    for (int idx = 1; idx < argc; ++idx)
+    {
+        std::string argument = argv[idx];
+
+        if (argument == "--expressions" && idx + 1 < argc)
+            expressionsCount = strtoul(argv[++idx], nullptr, 10);
+        else if (argument == "--variables" && idx + 1 < argc)
+            variablesCount = strtoul(argv[++idx], nullptr, 10);
+        else
+        {
+            print_usage(argv[0]);
+            return argument == "--help" || argument == "-h" ? 0 : 2;
+        }
+    }
+
+    if (expressionsCount == 0 || variablesCount == 0)
+    {
+        print_usage(argv[0]);
+        return 2;
+    }
+
+    std::mt19937 random(1);
+    std::vector<std::string> expressions(expressionsCount);
+    unsigned long characters = 0;
+
+    for (std::string& expression : expressions)
+    {
+        generate_expression(random, MAX_DEPTH, variablesCount, expression);
+        characters += expression.size();
+    }
+
+    std::vector<double> variables(variablesCount);
+    mu::Parser parser;
+
+    for (unsigned idx = 0; idx < variablesCount; ++idx)
+    {
+        mu::stringstream_type name;
+
+        name << _T("x") << idx;
+        parser.DefineVar(name.str(), &variables[idx]);
+    }
+
+    std::size_t bytecodeSize = 0;
+    auto begin = std::chrono::steady_clock::now();
+
+    try
+    {
+        for (const std::string& expression : expressions)
+        {
+            parser.SetExpr(mu::string_type(expression.begin(),
+                                           expression.end()));
+            bytecodeSize += parser.GetByteCode().GetSize();
+        }
+    }
+    catch (mu::Parser::exception_type&)
+    {
+        std::cerr << "Can't compile expression\n";
+        return 1;
+    }
+
+    print_throughput("muParser", expressionsCount, characters,
+                     seconds_since(begin));
+
+    begin = std::chrono::steady_clock::now();
+
+    for (const std::string& expression : expressions)
+        Parser::configureParser(expression, variablesCount);
+
+    print_throughput("Parser", expressionsCount, characters,
+                     seconds_since(begin));
+
+    // Working set fits cache, as with jobs repeating a few functions.
+    unsigned workingSetSize = std::min(Parser::CACHE_CAPACITY, expressionsCount);
+    unsigned long workingSetCharacters = 0;
+
+    begin = std::chrono::steady_clock::now();
+
+    for (unsigned idx = 0; idx < expressionsCount; ++idx)
+    {
+        const std::string& expression = expressions[idx % workingSetSize];
+
+        Parser::configureParser(expression, variablesCount);
+        workingSetCharacters += expression.size();
+    }
+
+    print_throughput("Parser, repeated", expressionsCount,
+                     workingSetCharacters, seconds_since(begin));
+
+    // Parsers of threads are copies of a configured one.
+    begin = std::chrono::steady_clock::now();
+    for (unsigned idx = 0; idx < expressionsCount; ++idx)
+        mu::Parser constructed;
+    double constructSeconds = seconds_since(begin);
+
+    begin = std::chrono::steady_clock::now();
+    for (unsigned idx = 0; idx < expressionsCount; ++idx)
+        mu::Parser copied(parser);
+    double copySeconds = seconds_since(begin);
+
+    std::cout << "Parser construction: " << constructSeconds / expressionsCount * 1E6
+              << " us, copy: " << copySeconds / expressionsCount * 1E6 << " us\n";
+
+    std::cout << "Bytecode tokens: " << bytecodeSize
+              << ", cache: " << Parser::getCacheHits() << " hits, "
+              << Parser::getCacheMisses() << " misses\n";
+
+    return 0;
+}
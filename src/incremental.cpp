@@ -0,0 +1,444 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+
+#include "incremental.hpp"
+
+/*
+ * Returns callback @f of parser as function of type @Function. Cast goes
+ * through void (*)(), the type GCC takes as generic function pointer.
+ */
+template <typename Function>
+static Function function_cast(mu::generic_fun_type f)
+{
+    return reinterpret_cast<Function>(reinterpret_cast<void (*)()>(f));
+}
+
+/*
+ * Builds tree of bytecode compiled by @parser for @variablesCount variables
+ * stored at @variables. Values of nodes are computed on the first
+ * evaluation. Leaves evaluator unsupported if bytecode has tokens it
+ * can't evaluate.
+ */
+void IncrementalEvaluator::configure(const mu::ParserBase& parser,
+                                     const double* variables,
+                                     unsigned variablesCount)
+{
+    mIsSupported = false;
+    mIsValid = false;
+
+    mTokens.clear();
+    mFirstChild.clear();
+    mChildren.clear();
+    mVariables.clear();
+    mDependents.assign(variablesCount, std::vector<unsigned>());
+    mPoint.assign(variablesCount, 0.0);
+    mLinePoint.assign(variablesCount, 0.0);
+    mLinePosition.clear();
+    mLineDirection.clear();
+    mIsMoving.assign(variablesCount, false);
+    mLineVariables.clear();
+    mLineVariables.reserve(variablesCount);
+
+    std::vector<unsigned> stack;
+    const mu::SToken* token = parser.GetByteCode().GetBase();
+
+    for (; token->Cmd != mu::cmEND; ++token)
+    {
+        unsigned argc = 0;
+        int variable = -1;
+
+        switch (token->Cmd)
+        {
+        case mu::cmVAR:
+        case mu::cmVARMUL:
+        case mu::cmVARPOW2:
+        case mu::cmVARPOW3:
+        case mu::cmVARPOW4:
+        {
+            std::ptrdiff_t idx = token->Val.ptr - variables;
+
+            if (idx >= 0 && idx < (std::ptrdiff_t)variablesCount)
+                variable = idx;
+            break;
+        }
+
+        case mu::cmVAL:
+            break;
+
+        case mu::cmLE:
+        case mu::cmGE:
+        case mu::cmNEQ:
+        case mu::cmEQ:
+        case mu::cmLT:
+        case mu::cmGT:
+        case mu::cmADD:
+        case mu::cmSUB:
+        case mu::cmMUL:
+        case mu::cmDIV:
+        case mu::cmPOW:
+        case mu::cmLAND:
+        case mu::cmLOR:
+            argc = 2;
+            break;
+
+        case mu::cmFUNC:
+            if (token->Fun.argc > 3)
+                return;
+
+            argc = std::abs(token->Fun.argc);
+            break;
+
+        default:
+            return;
+        }
+
+        if (stack.size() < argc)
+            return;
+
+        mFirstChild.push_back(mChildren.size());
+        mChildren.insert(mChildren.end(), stack.end() - argc, stack.end());
+        stack.resize(stack.size() - argc);
+
+        stack.push_back(mTokens.size());
+        mTokens.push_back(*token);
+        mVariables.push_back(variable);
+    }
+
+    // Several results or none.
+    if (stack.size() != 1)
+        return;
+
+    unsigned nodesCount = mTokens.size();
+    std::vector<unsigned>& parents = mParents;
+
+    parents.assign(nodesCount, nodesCount);
+
+    for (unsigned node = 0; node < nodesCount; ++node)
+    {
+        unsigned end = node + 1 < nodesCount ?
+                    mFirstChild[node + 1] : mChildren.size();
+
+        for (unsigned child = mFirstChild[node]; child < end; ++child)
+            parents[mChildren[child]] = node;
+    }
+
+    // Nodes depending on coordinate are paths from its leaves to root.
+    std::vector<unsigned> marks(nodesCount, variablesCount);
+    unsigned long dependenciesCount = 0;
+
+    for (unsigned node = 0; node < nodesCount; ++node)
+    {
+        int variable = mVariables[node];
+
+        if (variable < 0)
+            continue;
+
+        std::vector<unsigned>& dependents = mDependents[variable];
+        for (unsigned path = node;
+             path < nodesCount && marks[path] != unsigned(variable);
+             path = parents[path])
+        {
+            marks[path] = variable;
+            dependents.push_back(path);
+        }
+    }
+
+    for (std::vector<unsigned>& dependents : mDependents)
+    {
+        std::sort(dependents.begin(), dependents.end());
+        dependenciesCount += dependents.size();
+    }
+
+    if (dependenciesCount > MAX_DEPENDENCIES)
+        return;
+
+    mAllNodes.resize(nodesCount);
+    for (unsigned node = 0; node < nodesCount; ++node)
+        mAllNodes[node] = node;
+
+    mValues.assign(nodesCount, 0.0);
+    mIsDependent.assign(nodesCount, false);
+    mLineByteCode.EnableOptimizer(false);
+    mIsSupported = true;
+}
+
+bool IncrementalEvaluator::isSupported() const
+{
+    return mIsSupported;
+}
+
+/*
+ * Forgets values of nodes, so the next evaluation computes all of them.
+ */
+void IncrementalEvaluator::invalidate()
+{
+    mIsValid = false;
+    mLinePosition.clear();
+}
+
+/*
+ * Returns value of expression at @x. Computes again only nodes depending
+ * on coordinates of @x differing from the previous point, unless they
+ * are more than all nodes together.
+ */
+double IncrementalEvaluator::evaluate(const std::vector<double>& x)
+{
+    if (!mIsValid)
+    {
+        mPoint = x;
+        computeNodes(mAllNodes, x);
+        mIsValid = true;
+
+        return mValues.back();
+    }
+
+    unsigned long dirtyCount = 0;
+
+    // Bits are compared, so zero changing sign is a change as well.
+    mChanged.clear();
+    for (unsigned idx = 0; idx < mPoint.size(); ++idx)
+        if (std::memcmp(&x[idx], &mPoint[idx], sizeof(double)) != 0)
+        {
+            mChanged.push_back(idx);
+            dirtyCount += mDependents[idx].size();
+            mPoint[idx] = x[idx];
+        }
+
+    if (mChanged.empty())
+        return mValues.back();
+
+    if (dirtyCount >= mTokens.size())
+    {
+        computeNodes(mAllNodes, x);
+    }
+    else if (mChanged.size() == 1)
+    {
+        computeNodes(mDependents[mChanged[0]], x);
+    }
+    else
+    {
+        mDirty.clear();
+        for (unsigned idx : mChanged)
+        {
+            const std::vector<unsigned>& dependents = mDependents[idx];
+
+            mMerged.clear();
+            std::set_union(mDirty.begin(), mDirty.end(),
+                           dependents.begin(), dependents.end(),
+                           std::back_inserter(mMerged));
+            mDirty.swap(mMerged);
+        }
+
+        computeNodes(mDirty, x);
+    }
+
+    return mValues.back();
+}
+
+/*
+ * Returns value of expression at @position + @alpha * @direction, the same
+ * as evaluate() at point computed by Tools::convert_dimensions(). Program
+ * of the line is compiled when @position or @direction differ from the
+ * previous ones.
+ */
+double IncrementalEvaluator::evaluateLine(const std::vector<double>& position,
+                                          const std::vector<double>& direction,
+                                          const double alpha)
+{
+    if (!std::isfinite(alpha) || position.size() != mPoint.size() ||
+        direction.size() != mPoint.size())
+    {
+        std::vector<double> x(position.size());
+        for (unsigned idx = 0; idx < position.size(); ++idx)
+            x[idx] = position[idx] + alpha * direction[idx];
+
+        return evaluate(x);
+    }
+
+    std::size_t size = position.size() * sizeof(double);
+    if (mLinePosition.size() != position.size() ||
+        std::memcmp(mLinePosition.data(), position.data(), size) != 0 ||
+        std::memcmp(mLineDirection.data(), direction.data(), size) != 0)
+        configureLine(position, direction);
+
+    for (unsigned idx : mLineVariables)
+        mLinePoint[idx] = mLinePosition[idx] + alpha * mLineDirection[idx];
+
+    return mLineParser.Eval();
+}
+
+/*
+ * Evaluates expression at @position and compiles program of coordinates
+ * moving along @direction. Coordinate stays fixed only if its direction is
+ * zero and position isn't, since adding signed zero step to zero may
+ * change its sign. Fixed subtrees are replaced by their values, the rest
+ * is compiled in order of bytecode without optimizations, so operations
+ * are the same as parser does.
+ */
+void IncrementalEvaluator::configureLine(const std::vector<double>& position,
+                                         const std::vector<double>& direction)
+{
+    evaluate(position);
+
+    mLinePosition = position;
+    mLineDirection = direction;
+
+    std::vector<char>& isMoving = mIsMoving;
+    std::vector<char>& isDependent = mIsDependent;
+
+    mLineVariables.clear();
+    for (unsigned idx = 0; idx < mPoint.size(); ++idx)
+    {
+        isMoving[idx] = direction[idx] != 0.0 || position[idx] == 0.0 ||
+                std::isnan(position[idx]);
+
+        if (isMoving[idx])
+            mLineVariables.push_back(idx);
+    }
+
+    // Children precede parents, so dependence flows in one pass.
+    unsigned nodesCount = mTokens.size();
+
+    for (unsigned node = 0; node < nodesCount; ++node)
+    {
+        unsigned end = node + 1 < nodesCount ?
+                    mFirstChild[node + 1] : mChildren.size();
+        bool dependent = mVariables[node] >= 0 && isMoving[mVariables[node]];
+
+        for (unsigned child = mFirstChild[node]; child < end && !dependent;
+             ++child)
+            dependent = isDependent[mChildren[child]];
+
+        isDependent[node] = dependent;
+    }
+
+    // Bytecode keeps its storage, so lines after the first allocate nothing.
+    mu::ParserByteCode& byteCode = mLineByteCode;
+    byteCode.clear();
+
+    // Fixed subtree is a constant where its root is an argument of moving
+    // node, or where it is the whole expression.
+    for (unsigned node = 0; node < nodesCount; ++node)
+    {
+        if (isDependent[node])
+            compileLineNode(node, byteCode);
+        else if (mParents[node] == nodesCount || isDependent[mParents[node]])
+            byteCode.AddVal(mValues[node]);
+    }
+
+    byteCode.Finalize(false);
+    mLineParser.SetByteCode(byteCode, 1);
+}
+
+/*
+ * Appends moving @node to @byteCode, variables reading values of line.
+ */
+void IncrementalEvaluator::compileLineNode(unsigned node,
+                                           mu::ParserByteCode& byteCode)
+{
+    const mu::SToken& token = mTokens[node];
+
+    switch (token.Cmd)
+    {
+    case mu::cmVAR:
+    case mu::cmVARMUL:
+    case mu::cmVARPOW2:
+    case mu::cmVARPOW3:
+    case mu::cmVARPOW4:
+        byteCode.AddOptimizedVar(token, &mLinePoint[mVariables[node]]);
+        break;
+
+    case mu::cmFUNC:
+        byteCode.AddFun(token.Fun.ptr, token.Fun.argc, token.Fun.vec);
+        break;
+
+    default:
+        byteCode.AddOp(token.Cmd);
+        break;
+    }
+}
+
+void IncrementalEvaluator::computeNodes(const std::vector<unsigned>& nodes,
+                                        const std::vector<double>& x)
+{
+    for (unsigned node : nodes)
+        mValues[node] = computeNode(node, x);
+}
+
+/*
+ * Returns value of @node at @x from values of its children. Operations are
+ * the same as parser does, so are results.
+ */
+double IncrementalEvaluator::computeNode(unsigned node,
+                                         const std::vector<double>& x)
+{
+    const mu::SToken& token = mTokens[node];
+    const unsigned* children = mChildren.data() + mFirstChild[node];
+    const double* values = mValues.data();
+
+    switch (token.Cmd)
+    {
+    case mu::cmLE:   return values[children[0]] <= values[children[1]];
+    case mu::cmGE:   return values[children[0]] >= values[children[1]];
+    case mu::cmNEQ:  return values[children[0]] != values[children[1]];
+    case mu::cmEQ:   return values[children[0]] == values[children[1]];
+    case mu::cmLT:   return values[children[0]] < values[children[1]];
+    case mu::cmGT:   return values[children[0]] > values[children[1]];
+    case mu::cmADD:  return values[children[0]] + values[children[1]];
+    case mu::cmSUB:  return values[children[0]] - values[children[1]];
+    case mu::cmMUL:  return values[children[0]] * values[children[1]];
+    case mu::cmDIV:  return values[children[0]] / values[children[1]];
+    case mu::cmLAND: return values[children[0]] && values[children[1]];
+    case mu::cmLOR:  return values[children[0]] || values[children[1]];
+    case mu::cmPOW:
+        return std::pow(values[children[0]], values[children[1]]);
+
+    case mu::cmVAL:
+        return token.Val.data2;
+
+    case mu::cmFUNC:
+        switch (token.Fun.argc)
+        {
+        case 0:
+            return function_cast<mu::fun_type0>(token.Fun.ptr)();
+        case 1:
+            return function_cast<mu::fun_type1>(token.Fun.ptr)(
+                        values[children[0]]);
+        case 2:
+            return function_cast<mu::fun_type2>(token.Fun.ptr)(
+                        values[children[0]], values[children[1]]);
+        case 3:
+            return function_cast<mu::fun_type3>(token.Fun.ptr)(
+                        values[children[0]], values[children[1]],
+                        values[children[2]]);
+        default:
+        {
+            int argc = -token.Fun.argc;
+
+            mArguments.resize(argc);
+            for (int idx = 0; idx < argc; ++idx)
+                mArguments[idx] = values[children[idx]];
+
+            return function_cast<mu::multfun_type>(token.Fun.ptr)(
+                        mArguments.data(), argc);
+        }
+        }
+
+    default:
+        break;
+    }
+
+    // Variables, the only tokens left.
+    double value = mVariables[node] >= 0 ? x[mVariables[node]] : *token.Val.ptr;
+
+    switch (token.Cmd)
+    {
+    case mu::cmVARPOW2: return value * value;
+    case mu::cmVARPOW3: return value * value * value;
+    case mu::cmVARPOW4: return value * value * value * value;
+    case mu::cmVARMUL:  return value * token.Val.data + token.Val.data2;
+    default:            return value;
+    }
+}
@@ -0,0 +1,517 @@
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+
+#include "job.hpp"
+#include "methods.hpp"
+#include "parser.hpp"
+
+/*
+ * Reader of single flat JSON object: strings, numbers and arrays of numbers.
+ */
+class JsonReader
+{
+public:
+    JsonReader(const std::string& text) :
+        mText(text),
+        mPosition(0) {}
+
+    void expect(char symbol)
+    {
+        skip_spaces();
+
+        if (mPosition >= mText.size() || mText[mPosition] != symbol)
+            throw std::invalid_argument(std::string("Expected '") + symbol +
+                                        "' in JSON.");
+        ++mPosition;
+    }
+
+    bool accept(char symbol)
+    {
+        skip_spaces();
+
+        if (mPosition < mText.size() && mText[mPosition] == symbol)
+        {
+            ++mPosition;
+            return true;
+        }
+
+        return false;
+    }
+
+    char peek()
+    {
+        skip_spaces();
+
+        return mPosition < mText.size() ? mText[mPosition] : '\0';
+    }
+
+    std::string read_string()
+    {
+        std::string value;
+
+        expect('"');
+        while (mPosition < mText.size() && mText[mPosition] != '"')
+        {
+            char symbol = mText[mPosition++];
+
+            if (symbol == '\\' && mPosition < mText.size())
+            {
+                symbol = mText[mPosition++];
+
+                switch (symbol)
+                {
+                case 'n':
+                    symbol = '\n';
+                    break;
+                case 't':
+                    symbol = '\t';
+                    break;
+                case 'r':
+                    symbol = '\r';
+                    break;
+                case 'u':
+                    // Expressions are ASCII, other characters are rejected
+                    // by parser anyway.
+                    mPosition = std::min(mPosition + 4, mText.size());
+                    symbol = '?';
+                    break;
+                default:
+                    break;
+                }
+            }
+
+            value += symbol;
+        }
+        expect('"');
+
+        return value;
+    }
+
+    double read_number()
+    {
+        skip_spaces();
+
+        const char* begin = mText.c_str() + mPosition;
+        char* end;
+        double value = strtod(begin, &end);
+
+        if (end == begin)
+            throw std::invalid_argument("Expected number in JSON.");
+        mPosition += end - begin;
+
+        return value;
+    }
+
+    std::vector<double> read_numbers()
+    {
+        std::vector<double> values;
+
+        expect('[');
+        if (accept(']'))
+            return values;
+
+        do
+            values.push_back(read_number());
+        while (accept(','));
+        expect(']');
+
+        return values;
+    }
+
+    void skip_value()
+    {
+        char symbol = peek();
+
+        if (symbol == '"')
+            read_string();
+        else if (symbol == '[')
+            read_numbers();
+        else if (symbol == 't' || symbol == 'f' || symbol == 'n')
+            while (mPosition < mText.size() && isalpha(mText[mPosition]))
+                ++mPosition;
+        else
+            read_number();
+    }
+
+    bool at_end()
+    {
+        skip_spaces();
+
+        return mPosition >= mText.size();
+    }
+
+private:
+    const std::string& mText;
+    size_t mPosition;
+
+    void skip_spaces()
+    {
+        while (mPosition < mText.size() && isspace(mText[mPosition]))
+            ++mPosition;
+    }
+};
+
+/*
+ * Returns variables count given by @value, which must be a positive
+ * integer not above MAX_VARIABLES_COUNT.
+ */
+static unsigned to_variables_count(double value)
+{
+    if (!(value >= 1.0 && value <= Jobs::MAX_VARIABLES_COUNT) ||
+        value != std::floor(value))
+        throw std::invalid_argument("Variables count must be an integer "
+                                    "from 1 to " +
+                                    std::to_string(Jobs::MAX_VARIABLES_COUNT) +
+                                    ".");
+
+    return unsigned(value);
+}
+
+/*
+ * Fills missing fields of @job and checks it.
+ */
+static void complete_job(Job& job, bool hasVariablesCount)
+{
+    if (job.expression.empty())
+        throw std::invalid_argument("Expression is missing.");
+
+    if (!hasVariablesCount)
+        job.variablesCount = job.start.empty() ?
+                    0 : to_variables_count(job.start.size());
+
+    if (job.variablesCount == 0)
+        throw std::invalid_argument("Variables count is missing.");
+
+    if (job.start.empty())
+        job.start = std::vector<double>(job.variablesCount, 0.0);
+    else if (job.start.size() != job.variablesCount)
+        throw std::invalid_argument("Variables counts aren't matched.");
+
+    if (job.method.empty())
+        throw std::invalid_argument("Method is missing.");
+}
+
+/*
+ * Returns job described by JSON object @line, e.g.
+ * {"expression": "x0^2+x1^2", "start": [1, 2], "method": "powell_two"}.
+ * Variables count defaults to size of start and start defaults to zeros.
+ */
+Job Jobs::parse_json(const std::string& line, unsigned long index)
+{
+    Job job = { index, "", 0, {}, "", DEFAULT_EPSILON };
+    bool hasVariablesCount = false;
+    JsonReader reader(line);
+
+    reader.expect('{');
+    if (!reader.accept('}'))
+    {
+        do
+        {
+            std::string key = reader.read_string();
+            reader.expect(':');
+
+            if (key == "expression")
+                job.expression = reader.read_string();
+            else if (key == "method")
+                job.method = reader.read_string();
+            else if (key == "variables")
+            {
+                job.variablesCount = to_variables_count(reader.read_number());
+                hasVariablesCount = true;
+            }
+            else if (key == "start")
+                job.start = reader.read_numbers();
+            else if (key == "epsilon")
+                job.epsilon = reader.read_number();
+            else
+                reader.skip_value();
+        }
+        while (reader.accept(','));
+        reader.expect('}');
+    }
+
+    if (!reader.at_end())
+        throw std::invalid_argument("Unexpected text after JSON object.");
+
+    complete_job(job, hasVariablesCount);
+
+    return job;
+}
+
+/*
+ * Splits CSV @line to fields. Quoted fields may hold commas and
+ * doubled quotes.
+ */
+static std::vector<std::string> split_csv(const std::string& line)
+{
+    std::vector<std::string> fields(1);
+    bool isQuoted = false;
+
+    for (size_t idx = 0; idx < line.size(); ++idx)
+    {
+        char symbol = line[idx];
+
+        if (isQuoted)
+        {
+            if (symbol == '"' && idx + 1 < line.size() && line[idx + 1] == '"')
+                fields.back() += line[++idx];
+            else if (symbol == '"')
+                isQuoted = false;
+            else
+                fields.back() += symbol;
+        }
+        else if (symbol == '"')
+            isQuoted = true;
+        else if (symbol == ',')
+            fields.push_back("");
+        else if (symbol != '\r')
+            fields.back() += symbol;
+    }
+
+    return fields;
+}
+
+static double parse_double(const std::string& text)
+{
+    const char* begin = text.c_str();
+    char* end;
+    double value = strtod(begin, &end);
+
+    while (*end != '\0' && isspace(*end))
+        ++end;
+
+    if (end == begin || *end != '\0')
+        throw std::invalid_argument("Number \"" + text + "\" is incorrect.");
+
+    return value;
+}
+
+/*
+ * Returns job described by CSV @line with fields expression, variables,
+ * start, method and epsilon. Values of start are separated by semicolons;
+ * empty variables, start and epsilon take defaults as in JSON.
+ */
+Job Jobs::parse_csv(const std::string& line, unsigned long index)
+{
+    std::vector<std::string> fields = split_csv(line);
+    Job job = { index, "", 0, {}, "", DEFAULT_EPSILON };
+
+    if (fields.size() != 5)
+        throw std::invalid_argument("Expected 5 fields in CSV line.");
+
+    job.expression = fields[0];
+
+    bool hasVariablesCount = !fields[1].empty();
+    if (hasVariablesCount)
+        job.variablesCount = to_variables_count(parse_double(fields[1]));
+
+    size_t begin = 0;
+    while (!fields[2].empty() && begin <= fields[2].size())
+    {
+        size_t end = fields[2].find(START_SEPARATOR, begin);
+        if (end == std::string::npos)
+            end = fields[2].size();
+
+        job.start.push_back(parse_double(fields[2].substr(begin, end - begin)));
+        begin = end + 1;
+    }
+
+    job.method = fields[3];
+    if (!fields[4].empty())
+        job.epsilon = parse_double(fields[4]);
+
+    complete_job(job, hasVariablesCount);
+
+    return job;
+}
+
+/*
+ * Returns true if CSV @line is header naming fields.
+ */
+bool Jobs::is_csv_header(const std::string& line)
+{
+    return line.compare(0, 10, "expression") == 0;
+}
+
+static Result solve(const Job& job)
+{
+    double (*fMono)(const double) = Parser::evaluateFunctionMono;
+    double (*fMulti)(const std::vector<double>&) = Parser::evaluateFunctionMulti;
+    std::vector<double>& variables = Parser::sVariables;
+    std::vector<double>& initial = Parser::sPosition;
+    std::vector<double>& direction = Parser::sDirection;
+
+    initial = job.start;
+
+    // Polynomials are minimized along lines in closed form.
+    Methods::set_line_degree(fMono, Parser::findLineDegree);
+
+    if (job.method == "partan_two")
+        return Methods::partan_two(fMono, fMulti, variables, initial,
+                                   direction, job.epsilon);
+    if (job.method == "step_adjusting_newton")
+        return Methods::step_adjusting_newton(fMono, fMulti, variables,
+                                              initial, direction, job.epsilon);
+    if (job.method == "sparse_newton")
+        return Methods::sparse_newton(fMono, fMulti,
+                                      Parser::findHessianPattern(), variables,
+                                      initial, direction, job.epsilon);
+    if (job.method == "trust_region_newton")
+        return Methods::trust_region_newton(fMono, fMulti, variables, initial,
+                                            direction, job.epsilon,
+                                            Methods::DOGLEG);
+    if (job.method == "trust_region_steihaug_cg")
+        return Methods::trust_region_newton(fMono, fMulti, variables, initial,
+                                            direction, job.epsilon,
+                                            Methods::STEIHAUG_CG);
+    if (job.method == "quasinewton_pearson_two")
+        return Methods::quasinewton_pearson_two(fMono, fMulti, variables,
+                                                initial, direction,
+                                                job.epsilon);
+    if (job.method == "mcg_daniel")
+        return Methods::mcg_daniel(fMono, fMulti, variables, initial,
+                                   direction, job.epsilon);
+    if (job.method == "nelder_mead")
+        return Methods::nelder_mead(fMono, fMulti,
+                                    Parser::evaluateFunctionBatch, variables,
+                                    initial, direction, job.epsilon);
+    if (job.method == "cma_es")
+        return Methods::cma_es(fMono, fMulti, Parser::evaluateFunctionBatch,
+                               variables, initial, direction, job.epsilon,
+                               Parser::evaluateFunctionBatchCoarse);
+    if (job.method == "powell_two")
+        return Methods::powell_two(fMono, fMulti, variables, initial,
+                                   direction, job.epsilon);
+
+    throw std::invalid_argument("Method \"" + job.method + "\" is unknown.");
+}
+
+static void append_number(std::string& record, double value)
+{
+    char buffer[32];
+
+    // JSON has no infinities and NaNs.
+    if (std::isfinite(value))
+        snprintf(buffer, sizeof(buffer), "%.17g", value);
+    else
+        snprintf(buffer, sizeof(buffer), "null");
+
+    record += buffer;
+}
+
+static void append_string(std::string& record, const std::string& value)
+{
+    record += '"';
+    for (char symbol : value)
+    {
+        if (symbol == '"' || symbol == '\\')
+            record += '\\';
+
+        if (symbol == '\n')
+            record += "\\n";
+        else if (static_cast<unsigned char>(symbol) < 0x20)
+            record += ' ';
+        else
+            record += symbol;
+    }
+    record += '"';
+}
+
+static void append_count(std::string& record, const char* name, int value)
+{
+    if (value < 0)
+        return;
+
+    record += ",\"";
+    record += name;
+    record += "\":";
+    record += std::to_string(value);
+}
+
+/*
+ * Minimizes function of @job and returns JSON record of result or error.
+ * Function stays compiled in calling thread, so jobs of the same function
+ * running one after another in that thread don't compile it again.
+ */
+std::string Jobs::run(const Job& job)
+{
+    static thread_local std::string sExpression;
+    static thread_local unsigned sVariablesCount = 0;
+
+    try
+    {
+        if (job.expression != sExpression ||
+            job.variablesCount != sVariablesCount)
+        {
+            sExpression.clear();
+
+            Parser::configureParser(job.expression, job.variablesCount);
+            Parser::sParser.Eval();
+
+            sExpression = job.expression;
+            sVariablesCount = job.variablesCount;
+        }
+
+        auto begin = std::chrono::steady_clock::now();
+        Result result = solve(job);
+        std::chrono::duration<double> elapsed =
+                std::chrono::steady_clock::now() - begin;
+
+        std::vector<double> point = result.getVector();
+
+        std::string record = "{\"index\":" + std::to_string(job.index) +
+                ",\"status\":\"ok\",\"method\":";
+        append_string(record, job.method);
+        append_count(record, "iterations", result.getNormalItrs());
+        append_count(record, "accepted_steps", result.getAcceptedSteps());
+        append_count(record, "rejected_steps", result.getRejectedSteps());
+        append_count(record, "generations", result.getGenerations());
+        append_count(record, "evaluations", result.getEvaluations());
+
+        record += ",\"value\":";
+        append_number(record, Parser::evaluateFunctionMulti(point));
+
+        record += ",\"point\":[";
+        for (unsigned idx = 0; idx < point.size(); ++idx)
+        {
+            if (idx > 0)
+                record += ',';
+            append_number(record, point[idx]);
+        }
+
+        record += "],\"seconds\":";
+        append_number(record, elapsed.count());
+        record += '}';
+
+        return record;
+    }
+    catch (mu::Parser::exception_type& exc)
+    {
+        mu::string_type message = exc.GetMsg();
+
+        return format_error(job.index,
+                            std::string(message.begin(), message.end()));
+    }
+    catch (std::exception& exc)
+    {
+        return format_error(job.index, exc.what());
+    }
+}
+
+/*
+ * Returns JSON record of failed job.
+ */
+std::string Jobs::format_error(unsigned long index, const std::string& message)
+{
+    std::string record = "{\"index\":" + std::to_string(index) +
+            ",\"status\":\"error\",\"message\":";
+    append_string(record, message);
+    record += '}';
+
+    return record;
+}
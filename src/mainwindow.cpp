@@ -103,7 +103,7 @@ void MainWindow::configureWindow()
 
 void MainWindow::setFunctionButtonCallback()
 {
-    Parser::configureParser(mFunctionText.toPlainText().toStdWString(),
+    Parser::configureParser(mFunctionText.toPlainText().toStdString(),
                             mVariablesCount);
 
     try
@@ -122,7 +122,11 @@ void MainWindow::setFunctionButtonCallback()
     }
     catch (mu::Parser::exception_type& exc)
     {
-        mLogText.append(ERROR_MSG + QString::fromWCharArray(exc.GetMsg().c_str()));
+        mu::string_type message = exc.GetMsg();
+
+        mLogText.append(ERROR_MSG +
+                        QString::fromStdString(std::string(message.begin(),
+                                                           message.end())));
     }
 }
 
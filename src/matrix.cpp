@@ -1,5 +1,8 @@
-#include <iostream>
+#include <algorithm>
+#include <cmath>
 #include <cstring>
+#include <iostream>
+#include <limits>
 
 #include "matrix.hpp"
 
@@ -366,6 +369,88 @@ matrix matrix::inverse()
     return inv;
 }
 
+/*
+ * Replaces symmetric matrix A with lower triangular L, such that
+ * L * L^T = A + E, where E is nonnegative diagonal chosen as by
+ * Gill and Murray: zero for well conditioned positive definite A and
+ * just large enough to keep L bounded otherwise. Takes n^3 / 6
+ * multiplications. Returns true if E isn't zero.
+ */
+bool matrix::modified_cholesky()
+{
+    double machineEpsilon = std::numeric_limits<double>::epsilon();
+    double maxDiagonal = 0.0, maxOffDiagonal = 0.0;
+    bool isModified = false;
+
+    for (int alpha = 0; alpha < m_rows; alpha++)
+        for (int beta = 0; beta < m_cols; beta++)
+            if (alpha == beta)
+                maxDiagonal = std::max(maxDiagonal,
+                                       fabs(m_data[alpha][beta]));
+            else
+                maxOffDiagonal = std::max(maxOffDiagonal,
+                                          fabs(m_data[alpha][beta]));
+
+    double betaSquared = std::max(std::max(maxDiagonal, machineEpsilon),
+            (m_rows > 1) ?
+            maxOffDiagonal / sqrt((double)m_rows * m_rows - 1.0) : 0.0);
+    double delta = machineEpsilon *
+            std::max(maxDiagonal + maxOffDiagonal, 1.0);
+
+    for (int beta = 0; beta < m_cols; beta++)
+    {
+        // Column of A reduced by previous columns of L.
+        for (int alpha = beta; alpha < m_rows; alpha++)
+            for (int gamma = 0; gamma < beta; gamma++)
+                m_data[alpha][beta] -= m_data[alpha][gamma] * m_data[beta][gamma];
+
+        double theta = 0.0;
+        for (int alpha = beta + 1; alpha < m_rows; alpha++)
+            theta = std::max(theta, fabs(m_data[alpha][beta]));
+
+        double pivot = std::max(std::max(fabs(m_data[beta][beta]), delta),
+                                theta * theta / betaSquared);
+        if (pivot != m_data[beta][beta])
+            isModified = true;
+
+        m_data[beta][beta] = sqrt(pivot);
+        for (int alpha = beta + 1; alpha < m_rows; alpha++)
+        {
+            m_data[alpha][beta] /= m_data[beta][beta];
+            m_data[beta][alpha] = 0.0;
+        }
+    }
+
+    return isModified;
+}
+
+/*
+ * Solves L * L^T * @x = @b, where matrix holds L after modified_cholesky().
+ */
+void matrix::cholesky_solve(const std::vector<double>& b,
+                            std::vector<double>& x) const
+{
+    for (int alpha = 0; alpha < m_rows; alpha++)
+    {
+        double sum = b[alpha];
+
+        for (int beta = 0; beta < alpha; beta++)
+            sum -= m_data[alpha][beta] * x[beta];
+
+        x[alpha] = sum / m_data[alpha][alpha];
+    }
+
+    for (int alpha = m_rows - 1; alpha >= 0; alpha--)
+    {
+        double sum = x[alpha];
+
+        for (int beta = alpha + 1; beta < m_rows; beta++)
+            sum -= m_data[beta][alpha] * x[beta];
+
+        x[alpha] = sum / m_data[alpha][alpha];
+    }
+}
+
 int matrix::get_rows() const
 {
     return m_rows;
@@ -393,20 +478,12 @@ matrix& matrix::operator=(const matrix& other)
                                  "with by changing the number of rows "
                                  "and columns of the matrix");
 
-    for (int idx = 0; idx < m_rows; idx++)
-        delete[] m_data[idx];
-    delete[] m_data;
+    if (this == &other)
+        return *this;
 
+    // Dimensions are equal, so storage is reused.
     strcpy(m_name, other.m_name);
 
-    m_rows = other.m_rows;
-    m_cols = other.m_cols;
-
-    m_data = new double*[m_rows];
-
-    for (int idx = 0; idx < m_rows; idx++)
-        m_data[idx] = new double[m_cols];
-
     for (int alpha = 0; alpha < m_rows; alpha++)
         for (int beta = 0; beta < m_cols; beta++)
             m_data[alpha][beta] = other.m_data[alpha][beta];
@@ -504,6 +581,27 @@ std::vector<double> matrix::operator*(const std::vector<double>& vec) const
     return result;
 }
 
+void matrix::multiply(const std::vector<double>& vec,
+                      std::vector<double>& dst) const
+{
+    for (int alpha = 0; alpha < m_rows; alpha++)
+    {
+        double sum = 0.0;
+
+        for (int beta = 0; beta < m_cols; beta++)
+            sum += m_data[alpha][beta] * vec[beta];
+
+        dst[alpha] = sum;
+    }
+}
+
+void matrix::fill(double value)
+{
+    for (int alpha = 0; alpha < m_rows; alpha++)
+        for (int beta = 0; beta < m_cols; beta++)
+            m_data[alpha][beta] = value;
+}
+
 bool matrix::operator==(const matrix& other) const
 {
     if (this->m_rows != other.m_rows || this->m_cols != other.m_cols)
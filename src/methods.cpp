@@ -1,8 +1,15 @@
+#include <algorithm>
+#include <cfloat>
 #include <cmath>
+#include <random>
+#include <stdexcept>
 
 #include "methods.hpp"
+#include "objective.hpp"
 #include "result.hpp"
+#include "sparse_cholesky.hpp"
 #include "tools.hpp"
+#include "workspace.hpp"
 
 void Methods::sven_value(double (*f)(const double), const double initial,
                          double& left_bound, double& right_bound)
@@ -42,6 +49,51 @@ void Methods::sven_value(double (*f)(const double), const double initial,
     }
 }
 
+/*
+ * Sven's method restricted to [@lower, @upper], which contains @initial.
+ * Steps are cut at the ends of the interval, so the bracket never leaves it;
+ * if function still decreases at an end, the bracket ends there.
+ */
+void Methods::sven_value(double (*f)(const double), const double initial,
+                         const double lower, const double upper,
+                         double& left_bound, double& right_bound)
+{
+    double step;
+    double prev, curr, next;
+
+    step = 0.01;
+
+    if (initial != 0.0)
+        step *= fabs(initial);
+
+    next = std::min(initial + step, upper);
+    if (next == initial || f(next) > f(initial))
+        step = -step;
+
+    prev = curr = initial;
+    next = std::min(std::max(initial + step, lower), upper);
+
+    while (next != curr && f(curr) > f(next))
+    {
+        step *= 2.0;
+
+        prev = curr;
+        curr = next;
+        next = std::min(std::max(next + step, lower), upper);
+    }
+
+    if (prev < next)
+    {
+        left_bound = prev;
+        right_bound = next;
+    }
+    else
+    {
+        left_bound = next;
+        right_bound = prev;
+    }
+}
+
 void Methods::sven_derivative(double (*df)(const double), const double initial,
                               double& left_bound, double& right_bound)
 {
@@ -313,6 +365,250 @@ double Methods::fibonacci_two(double (*f)(const double),
     return sym_pnt;
 }
 
+static thread_local double (*sLineFunction)(const double) = nullptr;
+static thread_local int (*sLineDegree)() = nullptr;
+
+/*
+ * Registers @fDegree as degree of @f as polynomial of alpha along its
+ * current line, negative if @f isn't polynomial. Line searches of other
+ * functions don't use it.
+ */
+void Methods::set_line_degree(double (*f)(const double), int (*fDegree)())
+{
+    sLineFunction = f;
+    sLineDegree = fDegree;
+}
+
+/*
+ * Returns value of polynomial of @degree with @coefficients at @x.
+ */
+static double evaluate_polynomial(const double* coefficients, int degree,
+                                  const double x)
+{
+    double value = coefficients[degree];
+
+    for (int power = degree - 1; power >= 0; --power)
+        value = value * x + coefficients[power];
+
+    return value;
+}
+
+/*
+ * Finds real roots of polynomial of @degree up to 3 with @coefficients and
+ * nonzero leading one. Returns count of roots stored to @roots.
+ */
+static int find_real_roots(const double* coefficients, int degree,
+                           double* roots)
+{
+    if (degree == 1)
+    {
+        roots[0] = -coefficients[0] / coefficients[1];
+        return 1;
+    }
+
+    if (degree == 2)
+    {
+        double a = coefficients[2], b = coefficients[1], c = coefficients[0];
+        double discriminant = b * b - 4.0 * a * c;
+
+        if (discriminant < 0.0)
+            return 0;
+
+        // Roots are computed without cancellation.
+        double q = -0.5 * (b + copysign(sqrt(discriminant), b));
+        if (q == 0.0)
+        {
+            roots[0] = 0.0;
+            return 1;
+        }
+
+        roots[0] = q / a;
+        roots[1] = c / q;
+        return 2;
+    }
+
+    // Depressed cubic t^3 + p * t + q, where x = t - b / 3.
+    double b = coefficients[2] / coefficients[3],
+            c = coefficients[1] / coefficients[3],
+            d = coefficients[0] / coefficients[3];
+    double shift = b / 3.0;
+    double p = c - b * shift;
+    double q = 2.0 * shift * shift * shift - c * shift + d;
+    double discriminant = q * q / 4.0 + p * p * p / 27.0;
+    int count;
+
+    if (discriminant > 0.0)
+    {
+        double root = sqrt(discriminant);
+
+        roots[0] = cbrt(-q / 2.0 + root) + cbrt(-q / 2.0 - root);
+        count = 1;
+    }
+    else if (p == 0.0)
+    {
+        roots[0] = 0.0;
+        count = 1;
+    }
+    else
+    {
+        double thirdTurn = 2.0 * acos(-1.0) / 3.0;
+        double radius = 2.0 * sqrt(-p / 3.0);
+        double angle = acos(std::min(1.0, std::max(-1.0,
+                                     3.0 * q / (p * radius)))) / 3.0;
+
+        for (count = 0; count < 3; ++count)
+            roots[count] = radius * cos(angle - thirdTurn * count);
+    }
+
+    for (int idx = 0; idx < count; ++idx)
+        roots[idx] -= shift;
+
+    return count;
+}
+
+/*
+ * Finds minimum of @f, polynomial of @degree from 2 to
+ * MAX_CLOSED_FORM_DEGREE, interpolated from values at @degree + 1 multiples
+ * of @step around zero. Value at zero is stored to @zeroValue. Returns false
+ * if leading coefficient doesn't make a minimum.
+ */
+static bool interpolate_minimum(double (*f)(const double), int degree,
+                                const double step, double& alpha,
+                                double& zeroValue)
+{
+    double nodes[Methods::MAX_CLOSED_FORM_DEGREE + 1];
+    double values[Methods::MAX_CLOSED_FORM_DEGREE + 1];
+    double coefficients[Methods::MAX_CLOSED_FORM_DEGREE + 1];
+    double scale = 0.0;
+
+    for (int idx = 0; idx <= degree; ++idx)
+    {
+        nodes[idx] = idx - degree / 2;
+        values[idx] = f(nodes[idx] * step);
+
+        if (!std::isfinite(values[idx]))
+            return false;
+
+        scale = std::max(scale, fabs(values[idx]));
+    }
+
+    zeroValue = values[degree / 2];
+
+    // Newton's divided differences turned into coefficients of powers.
+    for (int order = 1; order <= degree; ++order)
+        for (int idx = degree; idx >= order; --idx)
+            values[idx] = (values[idx] - values[idx - 1]) /
+                (nodes[idx] - nodes[idx - order]);
+
+    std::fill(coefficients, coefficients + degree + 1, 0.0);
+    coefficients[0] = values[degree];
+
+    for (int idx = degree - 1; idx >= 0; --idx)
+    {
+        for (int power = degree - idx; power > 0; --power)
+            coefficients[power] = coefficients[power - 1] -
+                nodes[idx] * coefficients[power];
+        coefficients[0] = values[idx] - nodes[idx] * coefficients[0];
+    }
+
+    // Terms cancelled along line leave rounding errors only.
+    while (degree > 0 &&
+           fabs(coefficients[degree]) <= 64.0 * DBL_EPSILON * scale)
+        --degree;
+
+    if (degree < 2 || (degree % 2 == 0 && coefficients[degree] < 0.0))
+        return false;
+
+    double derivative[Methods::MAX_CLOSED_FORM_DEGREE];
+    double curvature[Methods::MAX_CLOSED_FORM_DEGREE - 1];
+    double roots[Methods::MAX_CLOSED_FORM_DEGREE - 1];
+
+    for (int power = 1; power <= degree; ++power)
+        derivative[power - 1] = power * coefficients[power];
+    for (int power = 1; power < degree; ++power)
+        curvature[power - 1] = power * derivative[power];
+
+    int count = find_real_roots(derivative, degree - 1, roots);
+    double minimum = 0.0;
+    bool isFound = false;
+
+    for (int idx = 0; idx < count; ++idx)
+    {
+        double root = roots[idx];
+
+        // Newton's steps polish roots of cubic formula.
+        for (int step = 0; step < 2 && degree == 4; ++step)
+        {
+            double slope = evaluate_polynomial(curvature, degree - 2, root);
+
+            if (slope != 0.0)
+                root -= evaluate_polynomial(derivative, degree - 1, root) /
+                    slope;
+        }
+
+        if (!std::isfinite(root) ||
+            evaluate_polynomial(curvature, degree - 2, root) <= 0.0)
+            continue;
+
+        double candidate = evaluate_polynomial(coefficients, degree, root);
+        if (!isFound || candidate < minimum)
+        {
+            alpha = root * step;
+            minimum = candidate;
+            isFound = true;
+        }
+    }
+
+    return isFound;
+}
+
+/*
+ * Minimizes @f, polynomial of @degree from 2 to MAX_CLOSED_FORM_DEGREE,
+ * in closed form. Samples spread as far as the minimum interpolate it
+ * best, so they are spread again as far as the minimum found, unless it
+ * is close to their spread. Returns false if no step decreasing @f is
+ * found.
+ */
+static bool minimize_polynomial(double (*f)(const double), int degree,
+                                double& alpha)
+{
+    double step = 1.0, zeroValue;
+
+    for (unsigned pass = 0; pass < Methods::CLOSED_FORM_PASSES; ++pass)
+    {
+        if (!interpolate_minimum(f, degree, step, alpha, zeroValue) ||
+            !std::isfinite(alpha) || alpha == 0.0)
+            return false;
+
+        if (fabs(alpha) >= step / 4.0 && fabs(alpha) <= step * 4.0)
+            break;
+
+        step = fabs(alpha);
+    }
+
+    return f(alpha) < zeroValue;
+}
+
+/*
+ * Returns step minimizing @f along line. Polynomials of registered degree
+ * up to MAX_CLOSED_FORM_DEGREE are minimized in closed form, other
+ * functions are bracketed by Sven's method and searched by Fibonacci's
+ * method to @epsilon.
+ */
+double Methods::line_search(double (*f)(const double), const double epsilon)
+{
+    double alpha = 0.0, leftBound, rightBound;
+    int degree = f == sLineFunction && sLineDegree ? sLineDegree() : -1;
+
+    if (degree >= 2 && degree <= MAX_CLOSED_FORM_DEGREE &&
+        minimize_polynomial(f, degree, alpha))
+        return alpha;
+
+    sven_value(f, INITIAL_ALPHA, leftBound, rightBound);
+
+    return fibonacci_two(f, leftBound, rightBound, epsilon);
+}
+
 double Methods::newton(double (*df)(const double), double (*ddf)(const double),
                        const double initial, const double epsilon)
 {
@@ -572,19 +868,20 @@ Result Methods::partan_two(double (*fMono)(const double alpha),
     unsigned methodItrs = 0, accelerationItrs = 0;
     unsigned variablesCount = variables.size();
 
-    double alpha, beta, leftBound, rightBound;
+    double alpha, beta;
 
     std::vector<double> xOne = initial, xTwo(variablesCount),
             xThree(variablesCount), xFour(variablesCount),
             accelerationDirection(variablesCount);
 
+    Workspace workspace(variablesCount);
+
     do
     {
         // Antigradient move from xOne to xTwo.
         initial = xOne;
-        direction = Tools::find_antigradient(fMulti, initial);
-        Methods::sven_value(fMono, INITIAL_ALPHA, leftBound, rightBound);
-        alpha = Methods::fibonacci_two(fMono, leftBound, rightBound, epsilon);
+        Tools::find_antigradient(fMulti, initial, direction, workspace);
+        alpha = Methods::line_search(fMono, epsilon);
         Tools::convert_dimensions(alpha, initial, direction, xTwo);
         ++methodItrs;
 
@@ -592,9 +889,8 @@ Result Methods::partan_two(double (*fMono)(const double alpha),
         {
             // Antigradient move from xTwo to xThree.
             initial = xTwo;
-            direction = Tools::find_antigradient(fMulti, initial);
-            Methods::sven_value(fMono, INITIAL_ALPHA, leftBound, rightBound);
-            alpha = Methods::fibonacci_two(fMono, leftBound, rightBound, epsilon);
+            Tools::find_antigradient(fMulti, initial, direction, workspace);
+            alpha = Methods::line_search(fMono, epsilon);
             Tools::convert_dimensions(alpha, initial, direction, xThree);
             ++methodItrs;
 
@@ -604,8 +900,7 @@ Result Methods::partan_two(double (*fMono)(const double alpha),
             // Move along acceleration direction from xThree to xFour.
             initial = xThree;
             direction = accelerationDirection;
-            Methods::sven_value(fMono, INITIAL_ALPHA, leftBound, rightBound);
-            beta = Methods::fibonacci_two(fMono, leftBound, rightBound, epsilon);
+            beta = Methods::line_search(fMono, epsilon);
             Tools::convert_dimensions(beta, initial, direction, xFour);
             ++accelerationItrs;
 
@@ -626,221 +921,1525 @@ Result Methods::step_adjusting_newton(double (*fMono)(const double),
                                       std::vector<double>& direction,
                                       const double epsilon)
 {
-    double alpha;
-    unsigned iterations = 0, variablesCount = variables.size();
+    double alpha, value, slope;
+    unsigned iterations = 0, halvings, variablesCount = variables.size();
     std::vector<double> xOne(initial), xTwo(variablesCount),
-            xDelta(variablesCount);
+            xDelta(variablesCount), gradient(variablesCount),
+            antigradient(variablesCount);
+
+    matrix hessian("HESSIAN", variablesCount, variablesCount);
+
+    Workspace workspace(variablesCount);
+    Objective objective(fMulti, workspace);
 
     do
     {
-        std::vector<double> antigradient =
-                Tools::find_antigradient(fMulti, xOne);
-        matrix hessian = Tools::find_hessian(fMulti, xOne);
+        value = objective.value_and_gradient(xOne, gradient);
+        for (unsigned idx = 0; idx < variablesCount; ++idx)
+            antigradient[idx] = -gradient[idx];
+
+        // Modified factor is positive definite even for indefinite Hessian,
+        // so Newton step is a descent direction.
+        Tools::find_hessian(fMulti, xOne, hessian, workspace);
+        hessian.modified_cholesky();
+        hessian.cholesky_solve(antigradient, xDelta);
 
-        xDelta = hessian.inverse() * antigradient;
-        Tools::normalize(xDelta);
+        slope = 0.0;
+        for (unsigned idx = 0; idx < variablesCount; ++idx)
+            slope += gradient[idx] * xDelta[idx];
 
         alpha = 1.0;
+        halvings = 0;
         initial = xOne;
         direction = xDelta;
-        while (fMono(alpha) > fMulti(initial) + epsilon *
-               pow(Tools::find_norm(Tools::find_gradient(fMulti, initial)), 2.0)
-               * alpha)
+        while (fMono(alpha) > value + NEWTON_ARMIJO_FACTOR * alpha * slope &&
+               halvings++ < MAX_ITERATIONS)
             alpha /= NEWTON_BETA_FACTOR;
 
         Tools::convert_dimensions(alpha, initial, direction, xTwo);
 
         xOne = xTwo;
         ++iterations;
+
+        // Gradient at xTwo is reused at the top of the next iteration.
+        objective.gradient(xTwo, gradient);
     }
-    while (Tools::find_norm(Tools::find_gradient(fMulti, xTwo)) > epsilon &&
+    while (Tools::find_norm(gradient) > epsilon &&
            iterations < MAX_ITERATIONS);
 
     return Result(iterations, xTwo);
 }
 
-static matrix find_pearson_two_matrix(const matrix& prevMatrix,
-                                      const std::vector<double>& prevPoint,
-                                      const std::vector<double>& currPoint,
-                                      const std::vector<double>& prevAntigradient,
-                                      const std::vector<double>& currGradient)
-{
-    std::vector<double> deltaX(currPoint);
-    for (unsigned idx = 0; idx < deltaX.size(); ++idx)
-        deltaX[idx] -= prevPoint[idx];
-    matrix deltaXMatrix("", deltaX);
-
-    std::vector<double> gamma(currGradient);
-    for (unsigned idx = 0; idx < gamma.size(); ++idx)
-        gamma[idx] += prevAntigradient[idx];
-    const matrix gammaMatrix("", gamma);
-
-    matrix s = prevMatrix * gammaMatrix;
-
-    matrix numerator = (deltaXMatrix - s) * deltaXMatrix.transpose();
-    double denominator = (deltaXMatrix.transpose() * gammaMatrix).m_data[0][0];
-
-    return prevMatrix + numerator / denominator;
-}
-
-Result Methods::quasinewton_pearson_two(double (*fMono)(const double alpha),
-                                        double (*fMulti)(const std::vector<double>&),
-                                        std::vector<double>& variables,
-                                        std::vector<double>& initial,
-                                        std::vector<double>& direction,
-                                        const double epsilon)
+Result Methods::sparse_newton(double (*fMono)(const double),
+                              double (*fMulti)(const std::vector<double>&),
+                              const std::vector<std::vector<int>>& pattern,
+                              std::vector<double>& variables,
+                              std::vector<double>& initial,
+                              std::vector<double>& direction,
+                              const double epsilon)
 {
-    double alpha, leftBound, rightBound;
-    unsigned iterations = 1, variablesCount = variables.size();
+    double alpha, value, slope;
+    unsigned iterations = 0, halvings, variablesCount = variables.size(),
+            colorsCount;
+    std::vector<double> xOne(initial), xTwo(variablesCount),
+            xDelta(variablesCount), gradient(variablesCount),
+            antigradient(variablesCount);
 
-    std::vector<double> prevPoint(variablesCount), currPoint(initial),
-            nextPoint(variablesCount);
-    std::vector<double> currDirection(variablesCount);
-    std::vector<double> prevAntigradient(variablesCount),
-            currGradient(variablesCount);
+    // Coloring, ordering and pattern of factor are shared by all iterations.
+    std::vector<int> colors = Tools::color_columns(pattern, colorsCount);
+    sparse_cholesky factorization(pattern);
+    sparse_matrix hessian(variablesCount, pattern);
 
-    matrix prevA("", variablesCount, variablesCount),
-            currA("", variablesCount, variablesCount);
+    Workspace workspace(variablesCount);
+    Objective objective(fMulti, workspace);
 
     do
     {
-        currGradient = Tools::find_gradient(fMulti, currPoint);
-
-        std::vector<double> currAntigradient(currGradient);
+        value = objective.value_and_gradient(xOne, gradient);
         for (unsigned idx = 0; idx < variablesCount; ++idx)
-            currAntigradient[idx] = -currAntigradient[idx];
-
-        if ((iterations * variablesCount + 1) % (iterations) == 0)
-        {
-            currA = matrix("", 1.0, variablesCount, variablesCount);
-            currDirection = currAntigradient;
-        }
-        else
-        {
-            currA = find_pearson_two_matrix(prevA, prevPoint, nextPoint,
-                                            prevAntigradient, currGradient);
-            currDirection = currA * currAntigradient;
-        }
+            antigradient[idx] = -gradient[idx];
 
-        initial = currPoint;
-        direction = currDirection;
-        Methods::sven_value(fMono, INITIAL_ALPHA, leftBound, rightBound);
-        alpha = fibonacci_two(fMono, leftBound, rightBound, epsilon);
-        Tools::convert_dimensions(alpha, initial, direction, nextPoint);
+        Tools::find_sparse_hessian(fMulti, xOne, pattern, colors, colorsCount,
+                                   hessian, workspace);
+        factorization.factorize(hessian);
+        factorization.solve(antigradient, xDelta);
 
-        // Update variables.
-        prevPoint = currPoint;
-        currPoint = nextPoint;
+        // Factor of modified Hessian is positive definite, so slope < 0.
+        slope = 0.0;
+        for (unsigned idx = 0; idx < variablesCount; ++idx)
+            slope += gradient[idx] * xDelta[idx];
 
-        prevAntigradient = currAntigradient;
+        alpha = 1.0;
+        halvings = 0;
+        initial = xOne;
+        direction = xDelta;
+        while (fMono(alpha) > value + NEWTON_ARMIJO_FACTOR * alpha * slope &&
+               halvings++ < MAX_ITERATIONS)
+            alpha /= NEWTON_BETA_FACTOR;
 
-        prevA = currA;
+        Tools::convert_dimensions(alpha, initial, direction, xTwo);
 
+        xOne = xTwo;
         ++iterations;
+
+        objective.gradient(xTwo, gradient);
     }
-    while (Tools::find_norm(Tools::find_gradient(fMulti, nextPoint)) > epsilon &&
-           iterations - 1 < MAX_ITERATIONS);
+    while (Tools::find_norm(gradient) > epsilon &&
+           iterations < MAX_ITERATIONS);
 
-    return Result(iterations - 1, nextPoint);
+    return Result(iterations, xTwo);
 }
 
-static double find_daniel_coefficient(const std::vector<double>& prevDir,
-                                      const std::vector<double>& prevAntigradient,
-                                      const std::vector<double>& currGradient)
+/*
+ * Returns tau >= 0 such that |@from + tau * @along| equals @radius,
+ * where |@from| doesn't exceed @radius.
+ */
+static double find_boundary_step(const std::vector<double>& from,
+                                 const std::vector<double>& along,
+                                 const double radius)
 {
-    unsigned variablesCount = prevDir.size();
+    double a = Tools::find_dot_product(along, along),
+            b = Tools::find_dot_product(from, along),
+            c = Tools::find_dot_product(from, from) - radius * radius;
+
+    if (a == 0.0)
+        return 0.0;
+
+    // c <= 0, so the root is nonnegative and the form avoids cancellation.
+    if (b > 0.0)
+        return -c / (b + sqrt(b * b - a * c));
+
+    return (-b + sqrt(b * b - a * c)) / a;
+}
+
+/*
+ * Saves dogleg step of quadratic model with @gradient and @hessian
+ * inside trust region of @radius to @step. @factor receives modified
+ * Cholesky factor of @hessian, @newtonStep and @cauchyStep are scratch vectors.
+ */
+static void solve_dogleg(const matrix& hessian, matrix& factor,
+                         const std::vector<double>& gradient,
+                         const double radius, std::vector<double>& step,
+                         std::vector<double>& newtonStep,
+                         std::vector<double>& cauchyStep,
+                         std::vector<double>& product)
+{
+    unsigned variablesCount = gradient.size();
 
-    std::vector<double> gamma(variablesCount);
     for (unsigned idx = 0; idx < variablesCount; ++idx)
-        gamma[idx] = currGradient[idx] + prevAntigradient[idx];
+        cauchyStep[idx] = -gradient[idx];
 
-    double numerator = 0.0, denominator = 0.0;
+    factor = hessian;
+    factor.modified_cholesky();
+    factor.cholesky_solve(cauchyStep, newtonStep);
+
+    if (Tools::find_norm(newtonStep) <= radius)
+    {
+        step = newtonStep;
+        return;
+    }
+
+    double gradientNorm = Tools::find_norm(gradient);
+
+    hessian.multiply(gradient, product);
+    double curvature = Tools::find_dot_product(gradient, product);
+
+    // Minimizer along antigradient, unless it lies outside trust region.
+    if (curvature <= 0.0 ||
+        gradientNorm * gradientNorm * gradientNorm / curvature >= radius)
+    {
+        for (unsigned idx = 0; idx < variablesCount; ++idx)
+            step[idx] = -radius * gradient[idx] / gradientNorm;
+        return;
+    }
+
+    double factorCauchy = gradientNorm * gradientNorm / curvature;
     for (unsigned idx = 0; idx < variablesCount; ++idx)
     {
-        numerator += currGradient[idx] * gamma[idx];
-        denominator += prevDir[idx] * gamma[idx];
+        cauchyStep[idx] = -factorCauchy * gradient[idx];
+        newtonStep[idx] -= cauchyStep[idx];
     }
 
-    return numerator / denominator;
+    double tau = find_boundary_step(cauchyStep, newtonStep, radius);
+    for (unsigned idx = 0; idx < variablesCount; ++idx)
+        step[idx] = cauchyStep[idx] + tau * newtonStep[idx];
 }
 
-Result Methods::mcg_daniel(double (*fMono)(const double alpha),
-                           double (*fMulti)(const std::vector<double>&),
-                           std::vector<double>& variables,
-                           std::vector<double>& initial,
-                           std::vector<double>& direction,
-                           const double epsilon)
+/*
+ * Saves truncated conjugate gradient step of quadratic model with @gradient
+ * and @hessian inside trust region of @radius to @step. Iterations stop on
+ * negative curvature or trust region boundary. @residual, @conjugate and
+ * @product are scratch vectors.
+ */
+static void solve_steihaug_cg(const matrix& hessian,
+                              const std::vector<double>& gradient,
+                              const double radius, std::vector<double>& step,
+                              std::vector<double>& residual,
+                              std::vector<double>& conjugate,
+                              std::vector<double>& product)
 {
-    double alpha, leftBound, rightBound;
-    unsigned iterations = 1, variablesCount = variables.size();
-
-    std::vector<double> xOne(initial), xTwo(variablesCount);
-    std::vector<double> prevDirection(variablesCount),
-            currDirection(variablesCount);
-    std::vector<double> prevAntigradient(variablesCount),
-            currGradient(variablesCount);
+    unsigned variablesCount = gradient.size();
+    double gradientNorm = Tools::find_norm(gradient),
+            tolerance = std::min(0.5, sqrt(gradientNorm)) * gradientNorm;
 
-    do
+    for (unsigned idx = 0; idx < variablesCount; ++idx)
     {
-        currGradient = Tools::find_gradient(fMulti, xOne);
+        step[idx] = 0.0;
+        residual[idx] = gradient[idx];
+        conjugate[idx] = -gradient[idx];
+    }
 
-        std::vector<double> currAntigradient(currGradient);
-        for (unsigned idx = 0; idx < variablesCount; ++idx)
-            currAntigradient[idx] = -currAntigradient[idx];
+    double residualSquare = gradientNorm * gradientNorm;
+    for (unsigned itr = 0; itr < 2 * variablesCount; ++itr)
+    {
+        hessian.multiply(conjugate, product);
+        double curvature = Tools::find_dot_product(conjugate, product);
 
-        // Build currDirection.
-        if ((iterations * variablesCount + 1) % (iterations) == 0)
+        if (curvature <= 0.0)
         {
-            currDirection = currAntigradient;
+            double tau = find_boundary_step(step, conjugate, radius);
+            for (unsigned idx = 0; idx < variablesCount; ++idx)
+                step[idx] += tau * conjugate[idx];
+            return;
         }
-        else
+
+        double alpha = residualSquare / curvature, stepSquare = 0.0;
+        for (unsigned idx = 0; idx < variablesCount; ++idx)
         {
-            // Daniel ratio.
-            double beta = find_daniel_coefficient(prevDirection,
-                                                  prevAntigradient,
-                                                  currGradient);
+            double value = step[idx] + alpha * conjugate[idx];
+            stepSquare += value * value;
+        }
 
-            // Correct prevDirection.
+        if (stepSquare >= radius * radius)
+        {
+            double tau = find_boundary_step(step, conjugate, radius);
             for (unsigned idx = 0; idx < variablesCount; ++idx)
-                prevDirection[idx] *= beta;
+                step[idx] += tau * conjugate[idx];
+            return;
+        }
 
-            // Calculate currDirection.
-            for (unsigned idx = 0; idx < variablesCount; ++idx)
-                currDirection[idx] = currAntigradient[idx] + prevDirection[idx];
+        for (unsigned idx = 0; idx < variablesCount; ++idx)
+        {
+            step[idx] += alpha * conjugate[idx];
+            residual[idx] += alpha * product[idx];
         }
 
-        initial = xOne;
-        direction = currDirection;
-        Methods::sven_value(fMono, INITIAL_ALPHA, leftBound, rightBound);
-        alpha = fibonacci_two(fMono, leftBound, rightBound, epsilon);
-        Tools::convert_dimensions(alpha, initial, direction, xTwo);
+        double nextResidualSquare = Tools::find_dot_product(residual, residual);
+        if (sqrt(nextResidualSquare) < tolerance)
+            return;
 
-        xOne = xTwo;
-        prevDirection = currDirection;
-        prevAntigradient = currAntigradient;
+        double beta = nextResidualSquare / residualSquare;
+        for (unsigned idx = 0; idx < variablesCount; ++idx)
+            conjugate[idx] = -residual[idx] + beta * conjugate[idx];
 
-        ++iterations;
+        residualSquare = nextResidualSquare;
     }
-    while (Tools::find_norm(Tools::find_gradient(fMulti, xTwo)) > epsilon &&
-           iterations - 1 < MAX_ITERATIONS);
-
-    return Result(iterations - 1, xTwo);
 }
 
-Result Methods::powell_two(double (*fMono)(const double alpha),
-                           double (*fMulti)(const std::vector<double>&),
-                           std::vector<double>& variables,
-                           std::vector<double>& initial,
-                           std::vector<double>& direction,
-                           const double epsilon)
+/*
+ * Newton's method globalized by trust region instead of line search.
+ * Step minimizes quadratic model inside region of current radius with
+ * @subproblem solver; radius grows or shrinks depending on agreement
+ * of model and actual reduction. Hessian is recomputed after accepted
+ * steps only.
+ */
+Result Methods::trust_region_newton(double (*)(const double),
+                                    double (*fMulti)(const std::vector<double>&),
+                                    std::vector<double>& variables,
+                                    std::vector<double>& initial,
+                                    std::vector<double>&,
+                                    const double epsilon,
+                                    const TrustRegionSubproblem subproblem)
 {
-    int iterations = 0;
+    double value, trialValue, predicted, ratio, stepNorm,
+            radius = TRUST_REGION_RADIUS;
+    unsigned iterations = 0, accepted = 0, rejected = 0,
+            variablesCount = variables.size();
+    std::vector<double> xOne(initial), xTwo(variablesCount),
+            step(variablesCount), gradient(variablesCount),
+            first(variablesCount), second(variablesCount);
 
-    double alpha, leftBound, rightBound;
+    matrix hessian("HESSIAN", variablesCount, variablesCount),
+            factor("FACTOR", variablesCount, variablesCount);
+
+    Workspace workspace(variablesCount);
+    Objective objective(fMulti, workspace);
+
+    value = objective.value_and_gradient(xOne, gradient);
+    Tools::find_hessian(fMulti, xOne, hessian, workspace);
+
+    while (Tools::find_norm(gradient) > epsilon &&
+           iterations < MAX_ITERATIONS)
+    {
+        if (subproblem == STEIHAUG_CG)
+            solve_steihaug_cg(hessian, gradient, radius, step,
+                              first, second, workspace.product);
+        else
+            solve_dogleg(hessian, factor, gradient, radius, step,
+                         first, second, workspace.product);
+
+        hessian.multiply(step, workspace.product);
+        predicted = -(Tools::find_dot_product(gradient, step) +
+                      0.5 * Tools::find_dot_product(step, workspace.product));
+
+        Tools::convert_dimensions(1.0, xOne, step, xTwo);
+        trialValue = objective.value(xTwo);
+
+        ratio = predicted > 0.0 ? (value - trialValue) / predicted : -1.0;
+        stepNorm = Tools::find_norm(step);
+
+        if (ratio < 0.25)
+            radius = 0.25 * stepNorm;
+        else if (ratio > 0.75 && stepNorm >= 0.99 * radius)
+            radius = std::min(2.0 * radius, TRUST_REGION_MAX_RADIUS);
+
+        ++iterations;
+
+        if (ratio > TRUST_REGION_ETA)
+        {
+            ++accepted;
+
+            xOne = xTwo;
+            value = objective.value_and_gradient(xOne, gradient);
+            Tools::find_hessian(fMulti, xOne, hessian, workspace);
+        }
+        else
+        {
+            ++rejected;
+
+            // Region collapsed to round-off of the point, nothing to gain.
+            if (radius <= DBL_EPSILON * std::max(Tools::find_norm(xOne), 1.0))
+                break;
+        }
+    }
+
+    Result result(iterations, xOne);
+    result.setAcceptedSteps(accepted);
+    result.setRejectedSteps(rejected);
+
+    return result;
+}
+
+/*
+ * Returns count of residuals of @fResiduals, evaluating them at @x.
+ */
+static unsigned count_residuals(void (*fResiduals)(const std::vector<std::vector<double>>&,
+                                                   std::vector<std::vector<double>>&),
+                                const std::vector<double>& x)
+{
+    std::vector<std::vector<double>> values;
+
+    fResiduals(std::vector<std::vector<double>>(1, x), values);
+
+    return values[0].size();
+}
+
+/*
+ * Saves Gauss-Newton matrix J^T * J of @jacobian to @normal and
+ * J^T * r of @jacobian and @residuals, half of gradient of sum of squares,
+ * to @gradient. Returns sum of squares of @residuals.
+ */
+static double find_normal_equations(const matrix& jacobian,
+                                    const std::vector<double>& residuals,
+                                    matrix& normal,
+                                    std::vector<double>& gradient)
+{
+    unsigned residualsCount = residuals.size(),
+            variablesCount = gradient.size();
+    double value = 0.0;
+
+    for (unsigned row = 0; row < residualsCount; ++row)
+        value += residuals[row] * residuals[row];
+
+    for (unsigned alpha = 0; alpha < variablesCount; ++alpha)
+    {
+        gradient[alpha] = 0.0;
+        for (unsigned row = 0; row < residualsCount; ++row)
+            gradient[alpha] += jacobian.m_data[row][alpha] * residuals[row];
+
+        for (unsigned beta = alpha; beta < variablesCount; ++beta)
+        {
+            double sum = 0.0;
+            for (unsigned row = 0; row < residualsCount; ++row)
+                sum += jacobian.m_data[row][alpha] * jacobian.m_data[row][beta];
+            normal.m_data[alpha][beta] = normal.m_data[beta][alpha] = sum;
+        }
+    }
+
+    return value;
+}
+
+/*
+ * Gauss-Newton method for sum of squares of residuals of @fResiduals,
+ * which @fMono and @fMulti evaluate (see Parser::configureResiduals).
+ * Hessian is approximated by J^T * J of finite difference Jacobian,
+ * step is damped by backtracking like in Newton's method.
+ */
+Result Methods::gauss_newton(double (*fMono)(const double),
+                             double (*)(const std::vector<double>&),
+                             void (*fResiduals)(const std::vector<std::vector<double>>&,
+                                                std::vector<std::vector<double>>&),
+                             std::vector<double>& variables,
+                             std::vector<double>& initial,
+                             std::vector<double>& direction,
+                             const double epsilon)
+{
+    double alpha, value, slope;
+    unsigned iterations = 0, halvings, variablesCount = variables.size(),
+            residualsCount = count_residuals(fResiduals, initial);
+    std::vector<double> xOne(initial), xDelta(variablesCount),
+            gradient(variablesCount), antigradient(variablesCount),
+            residuals(residualsCount);
+
+    matrix jacobian("JACOBIAN", residualsCount, variablesCount),
+            normal("NORMAL", variablesCount, variablesCount);
+
+    while (iterations < MAX_ITERATIONS)
+    {
+        Tools::find_jacobian(fResiduals, xOne, residuals, jacobian);
+        value = find_normal_equations(jacobian, residuals, normal, gradient);
+
+        if (2.0 * Tools::find_norm(gradient) <= epsilon)
+            break;
+
+        for (unsigned idx = 0; idx < variablesCount; ++idx)
+            antigradient[idx] = -gradient[idx];
+
+        // Modification keeps step defined for rank deficient Jacobian.
+        normal.modified_cholesky();
+        normal.cholesky_solve(antigradient, xDelta);
+
+        slope = 2.0 * Tools::find_dot_product(gradient, xDelta);
+
+        alpha = 1.0;
+        halvings = 0;
+        initial = xOne;
+        direction = xDelta;
+        while (fMono(alpha) > value + NEWTON_ARMIJO_FACTOR * alpha * slope &&
+               halvings++ < MAX_ITERATIONS)
+            alpha /= NEWTON_BETA_FACTOR;
+
+        Tools::convert_dimensions(alpha, initial, direction, xOne);
+        ++iterations;
+    }
+
+    return Result(iterations, xOne);
+}
+
+/*
+ * Levenberg-Marquardt method for sum of squares of residuals of
+ * @fResiduals, which @fMulti evaluates (see Parser::configureResiduals).
+ * Gauss-Newton matrix is damped by multiple of identity, which shrinks
+ * after successful steps and grows after failed ones; Jacobian is
+ * recomputed after successful steps only.
+ */
+Result Methods::levenberg_marquardt(double (*)(const double),
+                                    double (*fMulti)(const std::vector<double>&),
+                                    void (*fResiduals)(const std::vector<std::vector<double>>&,
+                                                       std::vector<std::vector<double>>&),
+                                    std::vector<double>& variables,
+                                    std::vector<double>& initial,
+                                    std::vector<double>&,
+                                    const double epsilon)
+{
+    double value, trialValue, predicted, ratio, damping = 0.0, growth = 2.0;
+    unsigned iterations = 0, accepted = 0, rejected = 0,
+            variablesCount = variables.size(),
+            residualsCount = count_residuals(fResiduals, initial);
+    std::vector<double> xOne(initial), xTwo(variablesCount),
+            xDelta(variablesCount), gradient(variablesCount),
+            antigradient(variablesCount), residuals(residualsCount);
+
+    matrix jacobian("JACOBIAN", residualsCount, variablesCount),
+            normal("NORMAL", variablesCount, variablesCount),
+            damped("DAMPED", variablesCount, variablesCount);
+
+    Tools::find_jacobian(fResiduals, xOne, residuals, jacobian);
+    value = find_normal_equations(jacobian, residuals, normal, gradient);
+
+    for (unsigned idx = 0; idx < variablesCount; ++idx)
+        damping = std::max(damping, normal.m_data[idx][idx]);
+    damping *= LEVENBERG_MARQUARDT_DAMPING;
+
+    while (2.0 * Tools::find_norm(gradient) > epsilon &&
+           iterations < LEAST_SQUARES_MAX_ITERATIONS)
+    {
+        damped = normal;
+        for (unsigned idx = 0; idx < variablesCount; ++idx)
+        {
+            damped.m_data[idx][idx] += damping;
+            antigradient[idx] = -gradient[idx];
+        }
+
+        damped.modified_cholesky();
+        damped.cholesky_solve(antigradient, xDelta);
+
+        if (Tools::find_norm(xDelta) <=
+                DBL_EPSILON * std::max(Tools::find_norm(xOne), 1.0))
+            break;
+
+        Tools::convert_dimensions(1.0, xOne, xDelta, xTwo);
+        trialValue = fMulti(xTwo);
+
+        // Reduction of Gauss-Newton model, d^T * (mu * d - J^T * r).
+        predicted = damping * Tools::find_dot_product(xDelta, xDelta) -
+                Tools::find_dot_product(xDelta, gradient);
+        ratio = predicted > 0.0 ? (value - trialValue) / predicted : -1.0;
+
+        ++iterations;
+
+        if (ratio > 0.0)
+        {
+            ++accepted;
+
+            xOne = xTwo;
+            Tools::find_jacobian(fResiduals, xOne, residuals, jacobian);
+            value = find_normal_equations(jacobian, residuals, normal,
+                                          gradient);
+
+            damping *= std::max(1.0 / 3.0,
+                                1.0 - pow(2.0 * ratio - 1.0, 3.0));
+            growth = 2.0;
+        }
+        else
+        {
+            ++rejected;
+
+            damping *= growth;
+            growth *= 2.0;
+        }
+    }
+
+    Result result(iterations, xOne);
+    result.setAcceptedSteps(accepted);
+    result.setRejectedSteps(rejected);
+
+    return result;
+}
+
+// State of augmented Lagrangian seen by inner method, one per thread.
+static thread_local void (*sConstrained)(const std::vector<double>&,
+                                         std::vector<double>&);
+static thread_local unsigned sEqualitiesCount;
+static thread_local std::vector<double> sMultipliers;
+static thread_local double sPenalty;
+static thread_local const std::vector<double>* sAugmentedPosition;
+static thread_local const std::vector<double>* sAugmentedDirection;
+static thread_local std::vector<double> sAugmentedPoint;
+static thread_local std::vector<double> sConstrainedValues;
+
+/*
+ * Returns value of augmented Lagrangian at @x. Inequalities enter in
+ * Powell-Hestenes-Rockafellar form, which is smooth while they switch
+ * between active and inactive.
+ */
+static double evaluate_augmented_multi(const std::vector<double>& x)
+{
+    sConstrained(x, sConstrainedValues);
+
+    double value = sConstrainedValues[0];
+
+    for (unsigned idx = 0; idx < sMultipliers.size(); ++idx)
+    {
+        double constraint = sConstrainedValues[idx + 1];
+
+        if (idx < sEqualitiesCount)
+        {
+            value += sMultipliers[idx] * constraint +
+                    0.5 * sPenalty * constraint * constraint;
+        }
+        else
+        {
+            double shifted = std::max(0.0, sMultipliers[idx] +
+                                      sPenalty * constraint);
+            value += (shifted * shifted -
+                      sMultipliers[idx] * sMultipliers[idx]) / (2.0 * sPenalty);
+        }
+    }
+
+    return value;
+}
+
+static double evaluate_augmented_mono(const double alpha)
+{
+    Tools::convert_dimensions(alpha, *sAugmentedPosition, *sAugmentedDirection,
+                              sAugmentedPoint);
+
+    return evaluate_augmented_multi(sAugmentedPoint);
+}
+
+/*
+ * Augmented Lagrangian method for function constrained by equalities,
+ * which are zero, and inequalities, which are nonpositive. @fConstrained
+ * saves function followed by @equalitiesCount equalities and then by
+ * inequalities to its second argument (see Parser::configureConstraints).
+ * Each outer iteration minimizes augmented Lagrangian by @method, starting
+ * from previous minimizer, then updates multipliers; penalty grows while
+ * violation of constraints doesn't shrink fast enough. Inner tolerance
+ * tightens towards @epsilon, which also bounds violation of the result.
+ * Unlike other methods, it allocates in each outer iteration, as inner
+ * @method sets up its vectors on every run.
+ */
+Result Methods::augmented_lagrangian(void (*fConstrained)(const std::vector<double>&,
+                                                          std::vector<double>&),
+                                     unsigned equalitiesCount,
+                                     Result (*method)(double (*)(const double),
+                                                      double (*)(const std::vector<double>&),
+                                                      std::vector<double>&,
+                                                      std::vector<double>&,
+                                                      std::vector<double>&,
+                                                      const double),
+                                     std::vector<double>& variables,
+                                     std::vector<double>& initial,
+                                     std::vector<double>& direction,
+                                     const double epsilon)
+{
+    unsigned iterations = 0;
+    double violation, prevViolation = HUGE_VAL,
+            innerEpsilon = std::max(epsilon, 1.0 / AUGMENTED_PENALTY);
+    std::vector<double> point(initial);
+
+    fConstrained(point, sConstrainedValues);
+
+    sConstrained = fConstrained;
+    sEqualitiesCount = equalitiesCount;
+    sMultipliers.assign(sConstrainedValues.size() - 1, 0.0);
+    sPenalty = AUGMENTED_PENALTY;
+    sAugmentedPosition = &initial;
+    sAugmentedDirection = &direction;
+    sAugmentedPoint.resize(point.size());
+
+    while (iterations < AUGMENTED_MAX_ITERATIONS)
+    {
+        initial = point;
+        std::vector<double> minimizer = method(evaluate_augmented_mono,
+                                               evaluate_augmented_multi,
+                                               variables, initial, direction,
+                                               innerEpsilon).getVector();
+        ++iterations;
+
+        // Diverged inner method leaves the last finite point as result.
+        bool finite = true;
+        for (double value : minimizer)
+            finite = finite && std::isfinite(value);
+        if (!finite)
+            break;
+
+        point = minimizer;
+
+        fConstrained(point, sConstrainedValues);
+
+        // Inequality is violated when positive or when it is inactive
+        // while its multiplier is not zero.
+        violation = 0.0;
+        for (unsigned idx = 0; idx < sMultipliers.size(); ++idx)
+        {
+            double constraint = sConstrainedValues[idx + 1];
+
+            if (idx < equalitiesCount)
+                violation = std::max(violation, fabs(constraint));
+            else
+                violation = std::max(violation, fabs(std::max(constraint,
+                        -sMultipliers[idx] / sPenalty)));
+        }
+
+        if (violation <= epsilon && innerEpsilon <= epsilon)
+            break;
+
+        for (unsigned idx = 0; idx < sMultipliers.size(); ++idx)
+        {
+            double constraint = sConstrainedValues[idx + 1];
+
+            if (idx < equalitiesCount)
+                sMultipliers[idx] += sPenalty * constraint;
+            else
+                sMultipliers[idx] = std::max(0.0, sMultipliers[idx] +
+                                             sPenalty * constraint);
+        }
+
+        if (violation > 0.25 * prevViolation)
+            sPenalty *= AUGMENTED_PENALTY_FACTOR;
+
+        prevViolation = violation;
+        innerEpsilon = std::max(epsilon, 0.1 * innerEpsilon);
+    }
+
+    initial = point;
+
+    return Result(iterations, point);
+}
+
+/*
+ * Applies Pearson's second update to @currA in place, where @currA holds
+ * the matrix of previous iteration. @deltaX, @gamma and @product are
+ * scratch vectors of variables count size.
+ */
+static void update_pearson_two_matrix(matrix& currA,
+                                      const std::vector<double>& prevPoint,
+                                      const std::vector<double>& currPoint,
+                                      const std::vector<double>& prevAntigradient,
+                                      const std::vector<double>& currGradient,
+                                      std::vector<double>& deltaX,
+                                      std::vector<double>& gamma,
+                                      std::vector<double>& product)
+{
+    unsigned variablesCount = deltaX.size();
+
+    for (unsigned idx = 0; idx < variablesCount; ++idx)
+    {
+        deltaX[idx] = currPoint[idx] - prevPoint[idx];
+        gamma[idx] = currGradient[idx] + prevAntigradient[idx];
+    }
+
+    currA.multiply(gamma, product);
+
+    double denominator = 0.0;
+    for (unsigned idx = 0; idx < variablesCount; ++idx)
+        denominator += deltaX[idx] * gamma[idx];
+
+    for (unsigned alpha = 0; alpha < variablesCount; ++alpha)
+        for (unsigned beta = 0; beta < variablesCount; ++beta)
+            currA.m_data[alpha][beta] +=
+                    (deltaX[alpha] - product[alpha]) * deltaX[beta] /
+                    denominator;
+}
+
+/*
+ * Returns the longest step along @direction from @point inside box between
+ * @lower and @upper and saves index of variable reaching its bound first
+ * to @blocking.
+ */
+static double find_max_step(const std::vector<double>& point,
+                            const std::vector<double>& direction,
+                            const std::vector<double>& lower,
+                            const std::vector<double>& upper,
+                            unsigned& blocking)
+{
+    double maxStep = HUGE_VAL;
+
+    for (unsigned idx = 0; idx < point.size(); ++idx)
+    {
+        double step = HUGE_VAL;
+
+        if (direction[idx] > 0.0)
+            step = (upper[idx] - point[idx]) / direction[idx];
+        else if (direction[idx] < 0.0)
+            step = (lower[idx] - point[idx]) / direction[idx];
+
+        if (step < maxStep)
+        {
+            maxStep = step;
+            blocking = idx;
+        }
+    }
+
+    return maxStep;
+}
+
+/*
+ * Limited memory BFGS method for box between @lower and @upper.
+ * Variables at bounds with gradient pointing outside are fixed, direction
+ * of the rest comes from two-loop recursion over last LBFGS_MEMORY steps.
+ * Line search never leaves the box: it is bracketed by bounded Sven's method
+ * within the longest feasible step. Stops when projected gradient
+ * is below @epsilon.
+ */
+Result Methods::projected_lbfgs(double (*fMono)(const double),
+                                double (*fMulti)(const std::vector<double>&),
+                                const std::vector<double>& lower,
+                                const std::vector<double>& upper,
+                                std::vector<double>& variables,
+                                std::vector<double>& initial,
+                                std::vector<double>& direction,
+                                const double epsilon)
+{
+    double alpha, maxAlpha, leftBound, rightBound;
+    unsigned iterations = 0, stored = 0, newest = 0, blocking = 0,
+            variablesCount = variables.size();
+
+    std::vector<double> currPoint(initial), nextPoint(variablesCount),
+            currGradient(variablesCount), nextGradient(variablesCount),
+            currDirection(variablesCount), coefficients(LBFGS_MEMORY),
+            curvatures(LBFGS_MEMORY);
+    std::vector<std::vector<double>> steps(LBFGS_MEMORY,
+                std::vector<double>(variablesCount)),
+            changes(steps);
+    std::vector<bool> fixed(variablesCount);
+
+    Workspace workspace(variablesCount);
+    Objective objective(fMulti, workspace);
+
+    Tools::project(currPoint, lower, upper);
+    objective.gradient(currPoint, currGradient);
+
+    while (iterations < MAX_ITERATIONS)
+    {
+        double projectedNorm = 0.0;
+        for (unsigned idx = 0; idx < variablesCount; ++idx)
+        {
+            double value = std::min(std::max(currPoint[idx] - currGradient[idx],
+                                             lower[idx]), upper[idx]);
+            projectedNorm = std::max(projectedNorm, fabs(value - currPoint[idx]));
+
+            fixed[idx] = (currPoint[idx] <= lower[idx] && currGradient[idx] > 0.0) ||
+                    (currPoint[idx] >= upper[idx] && currGradient[idx] < 0.0);
+        }
+
+        if (projectedNorm <= epsilon)
+            break;
+
+        // Two-loop recursion on free variables, newest step first.
+        for (unsigned idx = 0; idx < variablesCount; ++idx)
+            currDirection[idx] = fixed[idx] ? 0.0 : -currGradient[idx];
+
+        for (unsigned count = 0; count < stored; ++count)
+        {
+            unsigned pair = (newest + LBFGS_MEMORY - count) % LBFGS_MEMORY;
+            coefficients[pair] = curvatures[pair] *
+                    Tools::find_dot_product(steps[pair], currDirection);
+            for (unsigned idx = 0; idx < variablesCount; ++idx)
+                currDirection[idx] -= coefficients[pair] * changes[pair][idx];
+        }
+
+        if (stored > 0)
+        {
+            double scale = 1.0 / (curvatures[newest] *
+                    Tools::find_dot_product(changes[newest], changes[newest]));
+            for (unsigned idx = 0; idx < variablesCount; ++idx)
+                currDirection[idx] *= scale;
+        }
+
+        for (unsigned count = stored; count > 0; --count)
+        {
+            unsigned pair = (newest + LBFGS_MEMORY - count + 1) % LBFGS_MEMORY;
+            double beta = curvatures[pair] *
+                    Tools::find_dot_product(changes[pair], currDirection);
+            for (unsigned idx = 0; idx < variablesCount; ++idx)
+                currDirection[idx] += (coefficients[pair] - beta) *
+                        steps[pair][idx];
+        }
+
+        for (unsigned idx = 0; idx < variablesCount; ++idx)
+            if (fixed[idx])
+                currDirection[idx] = 0.0;
+
+        maxAlpha = find_max_step(currPoint, currDirection, lower, upper,
+                                 blocking);
+
+        // Quasi-Newton direction may be uphill or blocked by a bound, while
+        // antigradient on free variables always leads inside the box.
+        if (Tools::find_dot_product(currGradient, currDirection) >= 0.0 ||
+            maxAlpha <= DBL_EPSILON)
+        {
+            stored = 0;
+            for (unsigned idx = 0; idx < variablesCount; ++idx)
+                currDirection[idx] = fixed[idx] ? 0.0 : -currGradient[idx];
+
+            maxAlpha = find_max_step(currPoint, currDirection, lower, upper,
+                                     blocking);
+        }
+
+        initial = currPoint;
+        direction = currDirection;
+        Methods::sven_value(fMono, std::min(1.0, maxAlpha), 0.0, maxAlpha,
+                            leftBound, rightBound);
+        alpha = fibonacci_two(fMono, leftBound, rightBound, epsilon);
+
+        // Bracket ending at the bound means function decreases up to it,
+        // and search stops short of it within its tolerance.
+        if (rightBound == maxAlpha && fMono(maxAlpha) <= fMono(alpha))
+            alpha = maxAlpha;
+
+        Tools::convert_dimensions(alpha, initial, direction, nextPoint);
+        Tools::project(nextPoint, lower, upper);
+
+        if (alpha == maxAlpha)
+            nextPoint[blocking] = currDirection[blocking] > 0.0 ?
+                        upper[blocking] : lower[blocking];
+
+        objective.gradient(nextPoint, nextGradient);
+        ++iterations;
+
+        // Pairs with nonpositive curvature would spoil positive definiteness.
+        unsigned pair = stored > 0 ? (newest + 1) % LBFGS_MEMORY : newest;
+        for (unsigned idx = 0; idx < variablesCount; ++idx)
+        {
+            steps[pair][idx] = nextPoint[idx] - currPoint[idx];
+            changes[pair][idx] = nextGradient[idx] - currGradient[idx];
+        }
+
+        double curvature = Tools::find_dot_product(steps[pair], changes[pair]);
+        if (curvature > DBL_EPSILON *
+                Tools::find_dot_product(changes[pair], changes[pair]))
+        {
+            curvatures[pair] = 1.0 / curvature;
+            newest = pair;
+            stored = std::min(stored + 1, LBFGS_MEMORY);
+        }
+        else if (stored == LBFGS_MEMORY)
+        {
+            // Rejected pair took place of the oldest one.
+            --stored;
+        }
+
+        currPoint = nextPoint;
+        currGradient = nextGradient;
+    }
+
+    return Result(iterations, currPoint);
+}
+
+Result Methods::quasinewton_pearson_two(double (*fMono)(const double alpha),
+                                        double (*fMulti)(const std::vector<double>&),
+                                        std::vector<double>& variables,
+                                        std::vector<double>& initial,
+                                        std::vector<double>& direction,
+                                        const double epsilon)
+{
+    Checkpoint checkpoint;
+
+    return quasinewton_pearson_two(fMono, fMulti, variables, initial,
+                                   direction, epsilon, checkpoint, 0);
+}
+
+/*
+ * Saves state of @checkpoint. Throws std::runtime_error if it can't be
+ * saved, so method doesn't go on without state it was asked to keep.
+ */
+static void save_checkpoint(const Checkpoint& checkpoint)
+{
+    if (!checkpoint.save())
+        throw std::runtime_error("Checkpoint can't be saved to \"" +
+                                 checkpoint.getPath() + "\".");
+}
+
+/*
+ * Continues from state of @checkpoint if it holds one of this method for
+ * the same objective and variables count, otherwise starts from @initial.
+ * State of another objective only seeds matrix of the first iteration.
+ * State is saved to @checkpoint every @checkpointInterval iterations, if
+ * nonzero, and failure to save it is thrown as std::runtime_error.
+ */
+Result Methods::quasinewton_pearson_two(double (*fMono)(const double alpha),
+                                        double (*fMulti)(const std::vector<double>&),
+                                        std::vector<double>& variables,
+                                        std::vector<double>& initial,
+                                        std::vector<double>& direction,
+                                        const double epsilon,
+                                        Checkpoint& checkpoint,
+                                        const unsigned checkpointInterval)
+{
+    double alpha;
+    unsigned iterations = 1, variablesCount = variables.size();
+
+    std::vector<double> prevPoint(variablesCount), currPoint(initial),
+            nextPoint(variablesCount);
+    std::vector<double> currDirection(variablesCount);
+    std::vector<double> prevAntigradient(variablesCount),
+            currGradient(variablesCount), currAntigradient(variablesCount);
+    std::vector<double> deltaX(variablesCount), gamma(variablesCount);
+
+    matrix currA("", variablesCount, variablesCount);
+
+    Workspace workspace(variablesCount);
+    Objective objective(fMulti, workspace);
+
+    // Rows of state are rows of matrix, previous point and antigradient.
+    bool restored = false, seeded = false;
+    if (checkpoint.holds(Checkpoint::QUASINEWTON_PEARSON_TWO, variablesCount) &&
+        checkpoint.getRows().size() == variablesCount + 2)
+    {
+        const std::vector<std::vector<double>>& rows = checkpoint.getRows();
+
+        for (unsigned row = 0; row < variablesCount; ++row)
+            for (unsigned col = 0; col < variablesCount; ++col)
+                currA.m_data[row][col] = rows[row][col];
+
+        if (checkpoint.holdsObjective())
+        {
+            restored = true;
+            iterations = checkpoint.getIterations() + 1;
+            currPoint = nextPoint = checkpoint.getPoint();
+            prevPoint = rows[variablesCount];
+            prevAntigradient = rows[variablesCount + 1];
+        }
+        else
+            seeded = true;
+    }
+
+    do
+    {
+        objective.gradient(currPoint, currGradient);
+
+        for (unsigned idx = 0; idx < variablesCount; ++idx)
+            currAntigradient[idx] = -currGradient[idx];
+
+        if (seeded)
+        {
+            // Curvature of another objective, no previous step to update it.
+            currA.multiply(currAntigradient, currDirection);
+        }
+        else if (!restored &&
+                 (iterations * variablesCount + 1) % (iterations) == 0)
+        {
+            currA.fill(1.0);
+            currDirection = currAntigradient;
+        }
+        else
+        {
+            update_pearson_two_matrix(currA, prevPoint, nextPoint,
+                                      prevAntigradient, currGradient,
+                                      deltaX, gamma, workspace.product);
+            currA.multiply(currAntigradient, currDirection);
+        }
+
+        initial = currPoint;
+        direction = currDirection;
+        alpha = Methods::line_search(fMono, epsilon);
+        Tools::convert_dimensions(alpha, initial, direction, nextPoint);
+
+        // Update variables.
+        prevPoint = currPoint;
+        currPoint = nextPoint;
+
+        prevAntigradient = currAntigradient;
+
+        ++iterations;
+        restored = seeded = false;
+
+        if (checkpointInterval > 0 && (iterations - 1) % checkpointInterval == 0)
+        {
+            std::vector<std::vector<double>>& rows = checkpoint.getRows();
+
+            rows.resize(variablesCount + 2);
+            for (unsigned row = 0; row < variablesCount; ++row)
+                rows[row].assign(currA.m_data[row],
+                                 currA.m_data[row] + variablesCount);
+            rows[variablesCount] = prevPoint;
+            rows[variablesCount + 1] = prevAntigradient;
+
+            checkpoint.setMethod(Checkpoint::QUASINEWTON_PEARSON_TWO);
+            checkpoint.setIterations(iterations - 1);
+            checkpoint.setPoint(currPoint);
+            save_checkpoint(checkpoint);
+        }
+
+        // Gradient at nextPoint is reused at the top of the next iteration.
+        objective.gradient(nextPoint, currGradient);
+    }
+    while (Tools::find_norm(currGradient) > epsilon &&
+           iterations - 1 < MAX_ITERATIONS);
+
+    return Result(iterations - 1, nextPoint);
+}
+
+static double find_daniel_coefficient(const std::vector<double>& prevDir,
+                                      const std::vector<double>& prevAntigradient,
+                                      const std::vector<double>& currGradient)
+{
+    unsigned variablesCount = prevDir.size();
+
+    double numerator = 0.0, denominator = 0.0;
+    for (unsigned idx = 0; idx < variablesCount; ++idx)
+    {
+        double gamma = currGradient[idx] + prevAntigradient[idx];
+
+        numerator += currGradient[idx] * gamma;
+        denominator += prevDir[idx] * gamma;
+    }
+
+    return numerator / denominator;
+}
+
+Result Methods::mcg_daniel(double (*fMono)(const double alpha),
+                           double (*fMulti)(const std::vector<double>&),
+                           std::vector<double>& variables,
+                           std::vector<double>& initial,
+                           std::vector<double>& direction,
+                           const double epsilon)
+{
+    double alpha;
+    unsigned iterations = 1, variablesCount = variables.size();
+
+    std::vector<double> xOne(initial), xTwo(variablesCount);
+    std::vector<double> prevDirection(variablesCount),
+            currDirection(variablesCount);
+    std::vector<double> prevAntigradient(variablesCount),
+            currGradient(variablesCount), currAntigradient(variablesCount);
+
+    Workspace workspace(variablesCount);
+    Objective objective(fMulti, workspace);
+
+    do
+    {
+        objective.gradient(xOne, currGradient);
+
+        for (unsigned idx = 0; idx < variablesCount; ++idx)
+            currAntigradient[idx] = -currGradient[idx];
+
+        // Build currDirection.
+        if ((iterations * variablesCount + 1) % (iterations) == 0)
+        {
+            currDirection = currAntigradient;
+        }
+        else
+        {
+            // Daniel ratio.
+            double beta = find_daniel_coefficient(prevDirection,
+                                                  prevAntigradient,
+                                                  currGradient);
+
+            // Correct prevDirection.
+            for (unsigned idx = 0; idx < variablesCount; ++idx)
+                prevDirection[idx] *= beta;
+
+            // Calculate currDirection.
+            for (unsigned idx = 0; idx < variablesCount; ++idx)
+                currDirection[idx] = currAntigradient[idx] + prevDirection[idx];
+        }
+
+        initial = xOne;
+        direction = currDirection;
+        alpha = Methods::line_search(fMono, epsilon);
+        Tools::convert_dimensions(alpha, initial, direction, xTwo);
+
+        xOne = xTwo;
+        prevDirection = currDirection;
+        prevAntigradient = currAntigradient;
+
+        ++iterations;
+
+        // Gradient at xTwo is reused at the top of the next iteration.
+        objective.gradient(xTwo, currGradient);
+    }
+    while (Tools::find_norm(currGradient) > epsilon &&
+           iterations - 1 < MAX_ITERATIONS);
+
+    return Result(iterations - 1, xTwo);
+}
+
+/*
+ * Nelder-Mead simplex method. Each iteration replaces @parallelVertices
+ * worst vertices at once (at most half of variables count), reflecting
+ * them through centroid of the rest.
+ * Reflection, expansion and both contractions of all of them are computed
+ * by single call of @fBatch, as well as vertices of shrunk simplex.
+ * Stops when both vertices and their values are within @epsilon of best ones.
+ */
+Result Methods::nelder_mead(double (*)(const double),
+                            double (*)(const std::vector<double>&),
+                            void (*fBatch)(const std::vector<std::vector<double>>&,
+                                           std::vector<double>&),
+                            std::vector<double>& variables,
+                            std::vector<double>& initial,
+                            std::vector<double>&,
+                            const double epsilon,
+                            const unsigned parallelVertices)
+{
+    unsigned iterations = 0, variablesCount = variables.size(),
+            verticesCount = variablesCount + 1,
+            movingCount = std::max(1u, std::min(parallelVertices,
+                                                variablesCount / 2));
+
+    // Parameters adapted to dimension keep expansions and contractions
+    // from collapsing the simplex on problems with many variables. On two
+    // variables they are the classic ones.
+    double expansion = 1.0 + 2.0 / variablesCount,
+            contraction = 0.75 - 0.5 / variablesCount,
+            shrinkage = 1.0 - 1.0 / variablesCount;
+
+    const double FACTORS[] = { 1.0, expansion, contraction, -contraction };
+    const unsigned CANDIDATES_COUNT = sizeof(FACTORS) / sizeof(FACTORS[0]);
+
+    std::vector<std::vector<double>> vertices(verticesCount, initial),
+            candidates(CANDIDATES_COUNT * movingCount,
+                       std::vector<double>(variablesCount)),
+            shrunk(variablesCount, std::vector<double>(variablesCount));
+    std::vector<double> values(verticesCount), candidateValues,
+            shrunkValues, centroid(variablesCount);
+    std::vector<unsigned> order(verticesCount);
+
+    for (unsigned idx = 0; idx < variablesCount; ++idx)
+        vertices[idx + 1][idx] += initial[idx] != 0.0 ?
+                    0.05 * initial[idx] : 0.00025;
+
+    fBatch(vertices, values);
+
+    for (unsigned idx = 0; idx < verticesCount; ++idx)
+        order[idx] = idx;
+
+    while (iterations < SIMPLEX_MAX_ITERATIONS)
+    {
+        std::sort(order.begin(), order.end(),
+                  [&values](unsigned lhs, unsigned rhs)
+                  { return values[lhs] < values[rhs]; });
+
+        const std::vector<double>& best = vertices[order[0]];
+        double valuesSpread = 0.0, verticesSpread = 0.0;
+        for (unsigned vertex = 1; vertex < verticesCount; ++vertex)
+        {
+            valuesSpread = std::max(valuesSpread,
+                                    values[order[vertex]] - values[order[0]]);
+            for (unsigned idx = 0; idx < variablesCount; ++idx)
+                verticesSpread = std::max(verticesSpread,
+                        fabs(vertices[order[vertex]][idx] - best[idx]));
+        }
+
+        if (valuesSpread <= epsilon && verticesSpread <= epsilon)
+            break;
+
+        ++iterations;
+
+        unsigned keptCount = verticesCount - movingCount;
+        for (unsigned idx = 0; idx < variablesCount; ++idx)
+        {
+            centroid[idx] = 0.0;
+            for (unsigned vertex = 0; vertex < keptCount; ++vertex)
+                centroid[idx] += vertices[order[vertex]][idx];
+            centroid[idx] /= keptCount;
+        }
+
+        for (unsigned moving = 0; moving < movingCount; ++moving)
+        {
+            const std::vector<double>& worst =
+                    vertices[order[keptCount + moving]];
+
+            for (unsigned kind = 0; kind < CANDIDATES_COUNT; ++kind)
+                for (unsigned idx = 0; idx < variablesCount; ++idx)
+                    candidates[moving * CANDIDATES_COUNT + kind][idx] =
+                            centroid[idx] +
+                            FACTORS[kind] * (centroid[idx] - worst[idx]);
+        }
+
+        fBatch(candidates, candidateValues);
+
+        double bestValue = values[order[0]],
+                keptValue = values[order[keptCount - 1]];
+        bool improved = false;
+
+        for (unsigned moving = 0; moving < movingCount; ++moving)
+        {
+            unsigned vertex = order[keptCount + moving],
+                    first = moving * CANDIDATES_COUNT, chosen = first;
+            double reflected = candidateValues[first];
+            bool accepted = true;
+
+            if (reflected < bestValue)
+            {
+                if (candidateValues[first + 1] < reflected)
+                    chosen = first + 1;
+            }
+            else if (reflected < keptValue)
+            {
+                chosen = first;
+            }
+            else if (reflected < values[vertex])
+            {
+                chosen = first + 2;
+                accepted = candidateValues[chosen] <= reflected;
+            }
+            else
+            {
+                chosen = first + 3;
+                accepted = candidateValues[chosen] < values[vertex];
+            }
+
+            if (accepted)
+            {
+                vertices[vertex] = candidates[chosen];
+                values[vertex] = candidateValues[chosen];
+                improved = true;
+            }
+        }
+
+        if (improved)
+            continue;
+
+        // None of vertices moved, so the simplex shrinks towards best vertex.
+        for (unsigned vertex = 1; vertex < verticesCount; ++vertex)
+            for (unsigned idx = 0; idx < variablesCount; ++idx)
+                shrunk[vertex - 1][idx] = best[idx] + shrinkage *
+                        (vertices[order[vertex]][idx] - best[idx]);
+
+        fBatch(shrunk, shrunkValues);
+
+        for (unsigned vertex = 1; vertex < verticesCount; ++vertex)
+        {
+            vertices[order[vertex]] = shrunk[vertex - 1];
+            values[order[vertex]] = shrunkValues[vertex - 1];
+        }
+    }
+
+    unsigned bestVertex = order[0];
+    for (unsigned vertex = 1; vertex < verticesCount; ++vertex)
+        if (values[vertex] < values[bestVertex])
+            bestVertex = vertex;
+
+    return Result(iterations, vertices[bestVertex]);
+}
+
+/*
+ * Covariance matrix adaptation evolution strategy. Each generation samples
+ * population from normal distribution around weighted mean of the best
+ * half of previous one and evaluates it by single call of @fBatch.
+ * Covariance follows rank-one and rank-mu updates, step size follows
+ * cumulative path length. Stops when standard deviation along every
+ * coordinate is below @epsilon. Sampling is seeded, so runs are repeatable.
+ *
+ * Given @fCoarseBatch, cheaper and less precise, early generations are
+ * evaluated by it while values of parents spread widely, so its error
+ * can't change their ranking. The rest of the search, the stop included,
+ * is refined with @fBatch, so the result is as precise as without it.
+ */
+Result Methods::cma_es(double (*)(const double),
+                       double (*)(const std::vector<double>&),
+                       void (*fBatch)(const std::vector<std::vector<double>>&,
+                                      std::vector<double>&),
+                       std::vector<double>& variables,
+                       std::vector<double>& initial,
+                       std::vector<double>&,
+                       const double epsilon,
+                       void (*fCoarseBatch)(const std::vector<std::vector<double>>&,
+                                            std::vector<double>&))
+{
+    unsigned generations = 0, evaluations = 0,
+            variablesCount = variables.size(),
+            populationCount = 4 + unsigned(3.0 * log(variablesCount)),
+            parentsCount = populationCount / 2;
+    double n = variablesCount, sigma = EVOLUTION_INITIAL_SIGMA;
+
+    std::vector<double> weights(parentsCount);
+    double weightsSum = 0.0, weightsSquareSum = 0.0;
+    for (unsigned idx = 0; idx < parentsCount; ++idx)
+    {
+        weights[idx] = log(parentsCount + 0.5) - log(idx + 1.0);
+        weightsSum += weights[idx];
+    }
+    for (unsigned idx = 0; idx < parentsCount; ++idx)
+    {
+        weights[idx] /= weightsSum;
+        weightsSquareSum += weights[idx] * weights[idx];
+    }
+
+    // Learning rates of Hansen's tutorial.
+    double effective = 1.0 / weightsSquareSum,
+            cSigma = (effective + 2.0) / (n + effective + 5.0),
+            dSigma = 1.0 + cSigma + 2.0 *
+                std::max(0.0, sqrt((effective - 1.0) / (n + 1.0)) - 1.0),
+            cPath = (4.0 + effective / n) / (n + 4.0 + 2.0 * effective / n),
+            cOne = 2.0 / ((n + 1.3) * (n + 1.3) + effective),
+            cMu = std::min(1.0 - cOne, 2.0 * (effective - 2.0 + 1.0 / effective) /
+                           ((n + 2.0) * (n + 2.0) + effective)),
+            expectedNorm = sqrt(n) * (1.0 - 1.0 / (4.0 * n) +
+                                      1.0 / (21.0 * n * n));
+
+    std::vector<std::vector<double>> population(populationCount,
+                std::vector<double>(variablesCount)),
+            samples(population), steps(population);
+    std::vector<double> values, mean(initial), best(initial),
+            sigmaPath(variablesCount, 0.0), covariancePath(variablesCount, 0.0),
+            meanSample(variablesCount), meanStep(variablesCount);
+    std::vector<unsigned> order(populationCount);
+    double bestValue = HUGE_VAL, spread = HUGE_VAL;
+    bool coarse = fCoarseBatch != nullptr;
+
+    matrix covariance("COVARIANCE", variablesCount, variablesCount),
+            factor("FACTOR", variablesCount, variablesCount);
+    for (unsigned row = 0; row < variablesCount; ++row)
+        for (unsigned col = 0; col < variablesCount; ++col)
+            covariance.m_data[row][col] = row == col ? 1.0 : 0.0;
+
+    std::mt19937 generator(EVOLUTION_SEED);
+    std::normal_distribution<double> distribution;
+
+    while (generations < EVOLUTION_MAX_GENERATIONS)
+    {
+        // Lower triangular factor maps standard normal samples to steps.
+        factor = covariance;
+        factor.modified_cholesky();
+
+        for (unsigned member = 0; member < populationCount; ++member)
+        {
+            for (unsigned idx = 0; idx < variablesCount; ++idx)
+                samples[member][idx] = distribution(generator);
+
+            factor.multiply(samples[member], steps[member]);
+            Tools::convert_dimensions(sigma, mean, steps[member],
+                                      population[member]);
+        }
+
+        if (coarse && generations > 0 && spread <= EVOLUTION_COARSE_SPREAD *
+                std::max(1.0, fabs(bestValue)))
+        {
+            // Best value is compared with precise values from now on.
+            std::vector<double> bestValues;
+
+            coarse = false;
+            fBatch(std::vector<std::vector<double>>(1, best), bestValues);
+            bestValue = bestValues[0];
+            ++evaluations;
+        }
+
+        (coarse ? fCoarseBatch : fBatch)(population, values);
+        evaluations += populationCount;
+        ++generations;
+
+        for (unsigned idx = 0; idx < populationCount; ++idx)
+            order[idx] = idx;
+        std::sort(order.begin(), order.end(),
+                  [&values](unsigned lhs, unsigned rhs)
+                  { return values[lhs] < values[rhs]; });
+
+        if (values[order[0]] < bestValue)
+        {
+            bestValue = values[order[0]];
+            best = population[order[0]];
+        }
+        spread = values[order[parentsCount - 1]] - values[order[0]];
+
+        std::fill(meanSample.begin(), meanSample.end(), 0.0);
+        std::fill(meanStep.begin(), meanStep.end(), 0.0);
+        for (unsigned parent = 0; parent < parentsCount; ++parent)
+            for (unsigned idx = 0; idx < variablesCount; ++idx)
+            {
+                meanSample[idx] += weights[parent] * samples[order[parent]][idx];
+                meanStep[idx] += weights[parent] * steps[order[parent]][idx];
+            }
+
+        Tools::convert_dimensions(sigma, mean, meanStep, mean);
+
+        for (unsigned idx = 0; idx < variablesCount; ++idx)
+            sigmaPath[idx] = (1.0 - cSigma) * sigmaPath[idx] +
+                    sqrt(cSigma * (2.0 - cSigma) * effective) * meanSample[idx];
+
+        // Covariance path stalls while step size path is too long.
+        double sigmaPathNorm = Tools::find_norm(sigmaPath);
+        bool stalled = sigmaPathNorm /
+                sqrt(1.0 - pow(1.0 - cSigma, 2.0 * generations)) >=
+                (1.4 + 2.0 / (n + 1.0)) * expectedNorm;
+
+        for (unsigned idx = 0; idx < variablesCount; ++idx)
+            covariancePath[idx] = (1.0 - cPath) * covariancePath[idx] +
+                    (stalled ? 0.0 :
+                     sqrt(cPath * (2.0 - cPath) * effective) * meanStep[idx]);
+
+        double decay = 1.0 - cOne - cMu +
+                (stalled ? cOne * cPath * (2.0 - cPath) : 0.0);
+        for (unsigned row = 0; row < variablesCount; ++row)
+            for (unsigned col = 0; col <= row; ++col)
+            {
+                double rankMu = 0.0;
+                for (unsigned parent = 0; parent < parentsCount; ++parent)
+                    rankMu += weights[parent] * steps[order[parent]][row] *
+                            steps[order[parent]][col];
+
+                double value = decay * covariance.m_data[row][col] +
+                        cOne * covariancePath[row] * covariancePath[col] +
+                        cMu * rankMu;
+                covariance.m_data[row][col] = covariance.m_data[col][row] =
+                        value;
+            }
+
+        sigma *= exp(cSigma / dSigma * (sigmaPathNorm / expectedNorm - 1.0));
+
+        double deviation = 0.0;
+        for (unsigned idx = 0; idx < variablesCount; ++idx)
+            deviation = std::max(deviation, covariance.m_data[idx][idx]);
+        if (sigma * sqrt(deviation) <= epsilon)
+        {
+            if (!coarse)
+                break;
+
+            // Converged on coarse values, refine before stopping.
+            spread = 0.0;
+        }
+    }
+
+    Result result(best);
+    result.setGenerations(generations);
+    result.setEvaluations(evaluations);
+
+    return result;
+}
+
+Result Methods::powell_two(double (*fMono)(const double alpha),
+                           double (*fMulti)(const std::vector<double>&),
+                           std::vector<double>& variables,
+                           std::vector<double>& initial,
+                           std::vector<double>& direction,
+                           const double epsilon)
+{
+    Checkpoint checkpoint;
+
+    return powell_two(fMono, fMulti, variables, initial, direction, epsilon,
+                      checkpoint, 0);
+}
+
+/*
+ * Continues from state of @checkpoint if it holds one of this method for
+ * the same objective and variables count, otherwise starts from @initial.
+ * State of another objective only seeds directions. State is saved to
+ * @checkpoint every @checkpointInterval iterations, if nonzero, and failure
+ * to save it is thrown as std::runtime_error.
+ */
+Result Methods::powell_two(double (*fMono)(const double alpha),
+                           double (*)(const std::vector<double>&),
+                           std::vector<double>&,
+                           std::vector<double>& initial,
+                           std::vector<double>& direction,
+                           const double epsilon,
+                           Checkpoint& checkpoint,
+                           const unsigned checkpointInterval)
+{
+    unsigned iterations = 0;
+
+    double alpha;
 
     std::vector<double> currentPoint = initial, nextPoint(initial.size());
 
-    std::vector<std::vector<double>> initials;
+    // Saved points are sized up front, so iterations only copy into them.
+    std::vector<std::vector<double>> initials(direction.size() + 2,
+                                              currentPoint);
     std::vector<std::vector<double>> directions(direction.size() + 1);
     std::vector<double> tempDirection(direction.size());
 
@@ -858,26 +2457,35 @@ Result Methods::powell_two(double (*fMono)(const double alpha),
         directions[idx][idx] = 1.0;
     directions[directions.size() - 1] = directions[0];
 
-    do
+    if (checkpoint.holds(Checkpoint::POWELL_TWO, direction.size()) &&
+        checkpoint.getRows().size() == directions.size())
     {
-        initials.clear();
+        directions = checkpoint.getRows();
+
+        if (checkpoint.holdsObjective())
+        {
+            iterations = checkpoint.getIterations();
+            currentPoint = checkpoint.getPoint();
+        }
+    }
 
+    do
+    {
         // Move along all directions.
         for (unsigned idx = 0; idx < directions.size(); ++idx)
         {
             // Save point.
-            initials.push_back(currentPoint);
+            initials[idx] = currentPoint;
 
             // Move along direction.
             initial = currentPoint;
             direction = directions[idx];
-            Methods::sven_value(fMono, INITIAL_ALPHA, leftBound, rightBound);
-            alpha = Methods::fibonacci_two(fMono, leftBound, rightBound, epsilon);
+            alpha = Methods::line_search(fMono, epsilon);
             Tools::convert_dimensions(alpha, initial, direction, nextPoint);
 
             currentPoint = nextPoint;
         }
-        initials.push_back(nextPoint);
+        initials[initials.size() - 1] = nextPoint;
 
         // Last and second.
         for (unsigned idx = 0; idx < tempDirection.size(); ++idx)
@@ -887,8 +2495,7 @@ Result Methods::powell_two(double (*fMono)(const double alpha),
 
         initial = nextPoint;
         direction = tempDirection;
-        Methods::sven_value(fMono, INITIAL_ALPHA, leftBound, rightBound);
-        alpha = Methods::fibonacci_two(fMono, leftBound, rightBound, epsilon);
+        alpha = Methods::line_search(fMono, epsilon);
         Tools::convert_dimensions(alpha, initial, direction, nextPoint);
 
         if (Tools::find_norm(tempDirection) <= epsilon)
@@ -900,6 +2507,15 @@ Result Methods::powell_two(double (*fMono)(const double alpha),
 
             directions[0] = directions[directions.size() - 1] = tempDirection;
         }
+
+        if (checkpointInterval > 0 && (iterations + 1) % checkpointInterval == 0)
+        {
+            checkpoint.setMethod(Checkpoint::POWELL_TWO);
+            checkpoint.setIterations(iterations + 1);
+            checkpoint.setPoint(currentPoint);
+            checkpoint.getRows() = directions;
+            save_checkpoint(checkpoint);
+        }
     }
     while (iterations++ < MAX_ITERATIONS);
 
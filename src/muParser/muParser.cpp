@@ -27,6 +27,7 @@
 */
 #include "muParser.h"
 #include "muParserTemplateMagic.h"
+#include "muParserVecMath.h"
 
 //--- Standard includes ------------------------------------------------------------------------
 #include <cmath>
@@ -207,13 +208,16 @@ namespace mu
 
 
   //---------------------------------------------------------------------------
-  /** \brief Default value recognition callback. 
+  /** \brief Read a value with a stream imbued with the parser locale.
+
+      Used for values the fast reader can't convert exactly and for locales
+      with a thousands separator.
       \param [in] a_szExpr Pointer to the expression
       \param [in, out] a_iPos Pointer to an index storing the current position within the expression
       \param [out] a_fVal Pointer where the value should be stored in case one is found.
       \return 1 if a value was found 0 otherwise.
   */
-  int Parser::IsVal(const char_type* a_szExpr, int *a_iPos, value_type *a_fVal)
+  int Parser::IsValStream(const char_type* a_szExpr, int *a_iPos, value_type *a_fVal)
   {
     value_type fVal(0);
 
@@ -231,6 +235,113 @@ namespace mu
     return 1;
   }
 
+  //---------------------------------------------------------------------------
+  /** \brief Default value recognition callback. 
+
+      Accepts the same syntax as reading a value with a stream: an optional
+      sign, digits with an optional decimal separator and an optional
+      exponent. The value is converted without a stream: the product or
+      quotient of an integer mantissa of up to 53 bits and a power of ten 
+      up to 1e22 is rounded once, so it is exact as well. Other values and
+      locales with a thousands separator fall back to the stream.
+
+      \param [in] a_szExpr Pointer to the expression
+      \param [in, out] a_iPos Pointer to an index storing the current position within the expression
+      \param [out] a_fVal Pointer where the value should be stored in case one is found.
+      \return 1 if a value was found 0 otherwise.
+  */
+  int Parser::IsVal(const char_type* a_szExpr, int *a_iPos, value_type *a_fVal)
+  {
+    static const value_type afPow10[] = { 1e0,  1e1,  1e2,  1e3,  1e4,  1e5,
+                                          1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                          1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+                                          1e18, 1e19, 1e20, 1e21, 1e22 };
+    static const int iMaxPow10 = 22;
+    static const unsigned long long iMaxMantissa = 1ULL << 53;
+
+    const char_type *szPos = a_szExpr;
+
+    // Names are the most frequent tokens here, reject them early.
+    if ( (*szPos>=_T('a') && *szPos<=_T('z')) || (*szPos>=_T('A') && *szPos<=_T('Z')) || *szPos==_T('_') )
+      return 0;
+
+    const std::numpunct<char_type> &punct = std::use_facet<std::numpunct<char_type> >(Parser::s_locale);
+    if (punct.thousands_sep()!=0)
+      return IsValStream(a_szExpr, a_iPos, a_fVal);
+
+    const char_type cDecSep = punct.decimal_point();
+
+    bool bNeg = false;
+    if (*szPos==_T('+') || *szPos==_T('-'))
+      bNeg = (*szPos++==_T('-'));
+
+    unsigned long long iMantissa = 0;
+    int iExp10 = 0;
+    bool bDigits = false, 
+         bExact = true;
+
+    for (bool bFrac = false; ; ++szPos)
+    {
+      if (*szPos>=_T('0') && *szPos<=_T('9'))
+      {
+        bDigits = true;
+
+        if (iMantissa <= (iMaxMantissa - 9) / 10)
+        {
+          iMantissa = iMantissa*10 + (*szPos - _T('0'));
+          if (bFrac)
+            --iExp10;
+        }
+        else
+          bExact = false;
+      }
+      else if (*szPos==cDecSep && !bFrac)
+        bFrac = true;
+      else
+        break;
+    }
+
+    if (!bDigits)
+      return 0;
+
+    if (*szPos==_T('e') || *szPos==_T('E'))
+    {
+      ++szPos;
+
+      bool bNegExp = false;
+      if (*szPos==_T('+') || *szPos==_T('-'))
+        bNegExp = (*szPos++==_T('-'));
+
+      // A stream fails on an exponent without digits
+      if (*szPos<_T('0') || *szPos>_T('9'))
+        return 0;
+
+      int iExp = 0;
+      for (; *szPos>=_T('0') && *szPos<=_T('9'); ++szPos)
+        iExp = std::min(iExp*10 + (*szPos - _T('0')), 100000);
+
+      iExp10 += bNegExp ? -iExp : iExp;
+    }
+
+    if (iMantissa!=0 && (iExp10<-iMaxPow10 || iExp10>iMaxPow10))
+      bExact = false;
+
+    if (!bExact)
+      return IsValStream(a_szExpr, a_iPos, a_fVal);
+
+    value_type fVal = (value_type)iMantissa;
+    if (iMantissa!=0 && iExp10>0)
+      fVal *= afPow10[iExp10];
+    else if (iMantissa!=0 && iExp10<0)
+      fVal /= afPow10[-iExp10];
+
+    if (bNeg)
+      fVal = -fVal;
+
+    *a_iPos += (int)(szPos - a_szExpr);
+    *a_fVal = fVal;
+    return 1;
+  }
 
   //---------------------------------------------------------------------------
   /** \brief Constructor. 
@@ -277,8 +388,8 @@ namespace mu
     else
     {
       // trigonometric functions
-      DefineFun(_T("sin"), Sin);
-      DefineFun(_T("cos"), Cos);
+      DefineFun(_T("sin"), Sin, ParserVecMath::Sin);
+      DefineFun(_T("cos"), Cos, ParserVecMath::Cos);
       DefineFun(_T("tan"), Tan);
       // arcus functions
       DefineFun(_T("asin"), ASin);
@@ -293,17 +404,28 @@ namespace mu
       DefineFun(_T("asinh"), ASinh);
       DefineFun(_T("acosh"), ACosh);
       DefineFun(_T("atanh"), ATanh);
-      // Logarithm functions
+      // Logarithm functions, block kernels don't check the domain
+#ifdef MUP_MATH_EXCEPTIONS
       DefineFun(_T("log2"), Log2);
       DefineFun(_T("log10"), Log10);
       DefineFun(_T("log"), Ln);
       DefineFun(_T("ln"), Ln);
+#else
+      DefineFun(_T("log2"), Log2, ParserVecMath::Log2);
+      DefineFun(_T("log10"), Log10, ParserVecMath::Log10);
+      DefineFun(_T("log"), Ln, ParserVecMath::Ln);
+      DefineFun(_T("ln"), Ln, ParserVecMath::Ln);
+#endif
       // misc
-      DefineFun(_T("exp"), Exp);
+      DefineFun(_T("exp"), Exp, ParserVecMath::Exp);
+#ifdef MUP_MATH_EXCEPTIONS
       DefineFun(_T("sqrt"), Sqrt);
+#else
+      DefineFun(_T("sqrt"), Sqrt, ParserVecMath::Sqrt);
+#endif
       DefineFun(_T("sign"), Sign);
       DefineFun(_T("rint"), Rint);
-      DefineFun(_T("abs"), Abs);
+      DefineFun(_T("abs"), Abs, ParserVecMath::Abs);
       // Functions with variable number of arguments
       DefineFun(_T("sum"), Sum);
       DefineFun(_T("avg"), Avg);
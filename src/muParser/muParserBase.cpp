@@ -33,6 +33,8 @@
 #include <cassert>
 #include <algorithm>
 #include <cmath>
+#include <cstddef>
+#include <limits>
 #include <memory>
 #include <vector>
 #include <deque>
@@ -56,6 +58,27 @@ namespace mu
   bool ParserBase::g_DbgDumpCmdCode = false;
   bool ParserBase::g_DbgDumpStack = false;
 
+  namespace
+  {
+    /** \brief Apply the block kernel of a function to a block of the stack. */
+    inline void ApplyKernel(vecfun_type1 a_pFun, value_type *a_pVal, int a_iCount, EMathAccuracy a_eAccuracy, value_type* /*a_pBuf*/)
+    {
+      a_pFun(a_pVal, a_iCount, a_eAccuracy);
+    }
+
+    /** \brief Apply the block kernel of a function to a single precision block.
+
+        Kernels work in double precision, so the block is converted to and
+        back from a buffer of #ParserBase::s_BulkBlockSize values.
+    */
+    inline void ApplyKernel(vecfun_type1 a_pFun, float *a_pVal, int a_iCount, EMathAccuracy a_eAccuracy, value_type *a_pBuf)
+    {
+      std::copy(a_pVal, a_pVal + a_iCount, a_pBuf);
+      a_pFun(a_pBuf, a_iCount, a_eAccuracy);
+      std::copy(a_pBuf, a_pBuf + a_iCount, a_pVal);
+    }
+  } // anonymous namespace
+
   //------------------------------------------------------------------------------
   /** \brief Identifiers for built in binary operators. 
 
@@ -89,12 +112,15 @@ namespace mu
     ,m_ConstDef()
     ,m_StrVarDef()
     ,m_VarDef()
+    ,m_ArrDef()
     ,m_bBuiltInOp(true)
+    ,m_eMathAccuracy(maULP1)
     ,m_sNameChars()
     ,m_sOprtChars()
     ,m_sInfixOprtChars()
     ,m_nIfElseCounter(0)
     ,m_vStackBuffer()
+    ,m_vBulkStacks()
     ,m_nFinalResultIdx(0)
   {
     InitTokenReader();
@@ -118,7 +144,9 @@ namespace mu
     ,m_ConstDef()
     ,m_StrVarDef()
     ,m_VarDef()
+    ,m_ArrDef()
     ,m_bBuiltInOp(true)
+    ,m_eMathAccuracy(maULP1)
     ,m_sNameChars()
     ,m_sOprtChars()
     ,m_sInfixOprtChars()
@@ -166,7 +194,9 @@ namespace mu
 
     m_ConstDef        = a_Parser.m_ConstDef;         // Copy user define constants
     m_VarDef          = a_Parser.m_VarDef;           // Copy user defined variables
+    m_ArrDef          = a_Parser.m_ArrDef;           // Copy user defined array variables
     m_bBuiltInOp      = a_Parser.m_bBuiltInOp;
+    m_eMathAccuracy   = a_Parser.m_eMathAccuracy;
     m_vStringBuf      = a_Parser.m_vStringBuf;
     m_vStackBuffer    = a_Parser.m_vStackBuffer;
     m_nFinalResultIdx = a_Parser.m_nFinalResultIdx;
@@ -608,6 +638,41 @@ namespace mu
     ReInit();
   }
 
+  //---------------------------------------------------------------------------
+  /** \brief Add a user defined array variable. 
+
+      Elements of the array are accessed by their index in square brackets as in
+      "x[i]" where the index is any expression. Indices start at zero and are 
+      truncated, indices out of range give NaN.
+
+      \param [in] a_sName the array name
+      \param [in] a_pVar A pointer to the first element.
+      \param [in] a_iSize Number of elements.
+      \param [in] a_iStride Distance between two elements. In bulk mode an element 
+                            is followed by its values at the next points, so the 
+                            distance is the number of points.
+      \post Will reset the Parser to string parsing mode.
+      \throw ParserException in case the name contains invalid signs or a_pVar is NULL.
+  */
+  void ParserBase::DefineArray(const string_type &a_sName, value_type *a_pVar, int a_iSize, int a_iStride)
+  {
+    if (a_pVar==0)
+      Error(ecINVALID_VAR_PTR);
+
+    // Test if a constant with that names already exists
+    if (m_ConstDef.find(a_sName)!=m_ConstDef.end())
+      Error(ecNAME_CONFLICT);
+
+    CheckName(a_sName, ValidNameChars());
+
+    SArrayVar arr;
+    arr.ptr = a_pVar;
+    arr.size = a_iSize;
+    arr.stride = a_iStride;
+    m_ArrDef[a_sName] = arr;
+    ReInit();
+  }
+
   //---------------------------------------------------------------------------
   /** \brief Add a user defined constant. 
       \param [in] a_sName The name of the constant.
@@ -739,6 +804,47 @@ namespace mu
     return m_FunDef;
   }
 
+  //---------------------------------------------------------------------------
+  /** \brief Return prototypes of all unary infix operators.
+      \return #m_InfixOprtDef
+      \throw nothrow
+  */
+  const funmap_type& ParserBase::GetInfixOprtDef() const
+  {
+    return m_InfixOprtDef;
+  }
+
+  //---------------------------------------------------------------------------
+  /** \brief Return the bytecode of the current expression.
+
+      The expression is compiled first if it has not been evaluated yet.
+      \throw ParserException in case the expression can't be compiled.
+  */
+  const ParserByteCode& ParserBase::GetByteCode() const
+  {
+    if (m_pParseFormula==&ParserBase::ParseString)
+      ParseString();
+
+    return m_vRPN;
+  }
+
+  //---------------------------------------------------------------------------
+  /** \brief Use precompiled bytecode for the current expression.
+
+      The expression must be set and variables defined before, since both
+      reset the parser to string parsing mode.
+      \param a_ByteCode Bytecode previously returned by GetByteCode().
+      \param a_nNumResults Number of results of the bytecode.
+      \throw nothrow
+  */
+  void ParserBase::SetByteCode(const ParserByteCode &a_ByteCode, int a_nNumResults)
+  {
+    m_vRPN = a_ByteCode;
+    m_nFinalResultIdx = a_nNumResults;
+    m_vStackBuffer.resize(m_vRPN.GetMaxStackSize());
+    m_pParseFormula = &ParserBase::ParseCmdCode;
+  }
+
   //---------------------------------------------------------------------------
   /** \brief Retrieve the formula. */
   const string_type& ParserBase::GetExpr() const
@@ -860,7 +966,7 @@ namespace mu
           if (funTok.GetArgCount()==-1 && iArgCount==0)
             Error(ecTOO_FEW_PARAMS, m_pTokenReader->GetPos(), funTok.GetAsString());
 
-          m_vRPN.AddFun(funTok.GetFuncAddr(), (funTok.GetArgCount()==-1) ? -iArgNumerical : iArgNumerical);
+          m_vRPN.AddFun(funTok.GetFuncAddr(), (funTok.GetArgCount()==-1) ? -iArgNumerical : iArgNumerical, funTok.GetVecFuncAddr());
           break;
     }
 
@@ -870,6 +976,69 @@ namespace mu
     a_stVal.push(token);
   }
 
+  //---------------------------------------------------------------------------
+  /** \brief Apply an array element token.
+      \param a_iArgCount Number of indices in the square brackets.
+      \post The result is pushed to the value stack
+      \post The array element token is removed from the stack
+      \throw exception_type if there is not exactly one index.
+  */
+  void ParserBase::ApplyArray(ParserStack<token_type> &a_stOpt,
+                              ParserStack<token_type> &a_stVal, 
+                              int a_iArgCount) const
+  {
+    token_type arrTok = a_stOpt.pop();
+
+    if (a_iArgCount>1)
+      Error(ecTOO_MANY_PARAMS, m_pTokenReader->GetPos()-1, arrTok.GetAsString());
+
+    if (a_iArgCount<1)
+      Error(ecTOO_FEW_PARAMS, m_pTokenReader->GetPos()-1, arrTok.GetAsString());
+
+    if (a_stVal.pop().GetType()==tpSTR)
+      Error(ecVAL_EXPECTED, m_pTokenReader->GetPos(), arrTok.GetAsString());
+
+    const SArrayVar *pArr = arrTok.GetArray();
+    m_vRPN.AddArrayVar(pArr->ptr, pArr->size, pArr->stride);
+
+    token_type token;
+    a_stVal.push(token.SetVal(1));
+  }
+
+  //---------------------------------------------------------------------------
+  /** \brief Apply a loop token.
+      \param a_vLoopPos Stack positions of the loop indices, the one of this loop is the last.
+      \param a_iArgCount Number of loop arguments following the loop index.
+      \post The result is pushed to the value stack
+      \post The loop token is removed from the stack
+      \throw exception_type if the loop has no bounds and body.
+  */
+  void ParserBase::ApplyLoop(ParserStack<token_type> &a_stOpt,
+                             ParserStack<token_type> &a_stVal, 
+                             std::vector<int> &a_vLoopPos,
+                             int a_iArgCount) const
+  {
+    token_type loopTok = a_stOpt.pop();
+
+    if (a_iArgCount>3)
+      Error(ecTOO_MANY_PARAMS, m_pTokenReader->GetPos()-1, loopTok.GetAsString());
+
+    if (a_iArgCount<3)
+      Error(ecTOO_FEW_PARAMS, m_pTokenReader->GetPos()-1, loopTok.GetAsString());
+
+    for (int i=0; i<a_iArgCount; ++i)
+    {
+      if (a_stVal.pop().GetType()==tpSTR)
+        Error(ecVAL_EXPECTED, m_pTokenReader->GetPos(), loopTok.GetAsString());
+    }
+
+    m_vRPN.AddLoopEnd(a_vLoopPos.back(), (ECmdCode)loopTok.GetIdx());
+    a_vLoopPos.pop_back();
+
+    token_type token;
+    a_stVal.push(token.SetVal(1));
+  }
+
   //---------------------------------------------------------------------------
   void ParserBase::ApplyIfElse(ParserStack<token_type> &a_stOpt,
                                ParserStack<token_type> &a_stVal) const
@@ -950,6 +1119,8 @@ namespace mu
   {
     while (stOpt.size() && 
            stOpt.top().GetCode() != cmBO &&
+           stOpt.top().GetCode() != cmVARIDX &&
+           stOpt.top().GetCode() != cmLOOP &&
            stOpt.top().GetCode() != cmIF)
     {
       token_type tok = stOpt.top();
@@ -997,21 +1168,17 @@ namespace mu
   */
   value_type ParserBase::ParseCmdCode() const
   {
-    return ParseCmdCodeBulk(0, 0);
+    return ParseCmdCodeBulk(0, 0, &m_vStackBuffer[0]);
   }
 
   //---------------------------------------------------------------------------
   /** \brief Evaluate the RPN. 
       \param nOffset The offset added to variable addresses (for bulk mode)
-      \param nThreadID OpenMP Thread id of the calling thread
+      \param nWorkerID Passed to bulk functions as the id of the calling thread
+      \param Stack Stack buffer of GetMaxStackSize() values
   */
-  value_type ParserBase::ParseCmdCodeBulk(int nOffset, int nThreadID) const
+  value_type ParserBase::ParseCmdCodeBulk(int nOffset, int nWorkerID, value_type *Stack) const
   {
-    assert(nThreadID<=s_MaxNumOpenMPThreads);
-
-    // Note: The check for nOffset==0 and nThreadID here is not necessary but 
-    //       brings a minor performance gain when not in bulk mode.
-    value_type *Stack = ((nOffset==0) && (nThreadID==0)) ? &m_vStackBuffer[0] : &m_vStackBuffer[nThreadID * (m_vStackBuffer.size() / s_MaxNumOpenMPThreads)];
     value_type buf;
     int sidx(0);
     for (const SToken *pTok = m_vRPN.GetBase(); pTok->Cmd!=cmEND ; ++pTok)
@@ -1092,6 +1259,61 @@ namespace mu
       case  cmVARMUL:  Stack[++sidx] = *(pTok->Val.ptr + nOffset) * pTok->Val.data + pTok->Val.data2;
                        continue;
 
+      // array elements and loops
+      case  cmVARIDX:
+            buf = Stack[sidx];
+            Stack[sidx] = (buf>=0 && buf<pTok->Arr.size) 
+                            ? *(pTok->Arr.ptr + (std::ptrdiff_t)buf * pTok->Arr.stride + nOffset) 
+                            : std::numeric_limits<value_type>::quiet_NaN();
+            continue;
+
+      case  cmVARIDX_LOOP:
+            buf = Stack[pTok->Arr.pos];
+            Stack[++sidx] = (buf>=0 && buf<pTok->Arr.size) 
+                              ? *(pTok->Arr.ptr + (std::ptrdiff_t)buf * pTok->Arr.stride + nOffset) 
+                              : std::numeric_limits<value_type>::quiet_NaN();
+            continue;
+
+      case  cmLOOPVAR: Stack[++sidx] = Stack[pTok->Loop.pos]; continue;
+
+      case  cmLOOP_BEGIN:
+            {
+              // Index and bound are on the stack, the result follows them
+              value_type *pLoop = &Stack[pTok->Loop.pos];
+              pLoop[2] = (pTok->Loop.red==cmMUL) ? 1 : 0;
+              sidx = pTok->Loop.pos + 2;
+
+              if (!(pLoop[0]<pLoop[1]))
+              {
+                // Empty loop, skip its body
+                pLoop[0] = pLoop[2];
+                sidx = pTok->Loop.pos;
+                pTok += pTok->Loop.offset;
+              }
+            }
+            continue;
+
+      case  cmLOOP_END:
+            {
+              value_type *pLoop = &Stack[pTok->Loop.pos];
+              if (pTok->Loop.red==cmMUL)
+                pLoop[2] *= Stack[sidx];
+              else
+                pLoop[2] += Stack[sidx];
+
+              if (++pLoop[0]<pLoop[1])
+              {
+                sidx = pTok->Loop.pos + 2;
+                pTok += pTok->Loop.offset;
+              }
+              else
+              {
+                pLoop[0] = pLoop[2];
+                sidx = pTok->Loop.pos;
+              }
+            }
+            continue;
+
       // Next is treatment of numeric functions
       case  cmFUNC:
             {
@@ -1147,17 +1369,17 @@ namespace mu
                 // switch according to argument count
                 switch(iArgCount)  
                 {
-                case 0: sidx += 1; Stack[sidx] = (*(bulkfun_type0 )pTok->Fun.ptr)(nOffset, nThreadID); continue;
-                case 1:            Stack[sidx] = (*(bulkfun_type1 )pTok->Fun.ptr)(nOffset, nThreadID, Stack[sidx]); continue;
-                case 2: sidx -= 1; Stack[sidx] = (*(bulkfun_type2 )pTok->Fun.ptr)(nOffset, nThreadID, Stack[sidx], Stack[sidx+1]); continue;
-                case 3: sidx -= 2; Stack[sidx] = (*(bulkfun_type3 )pTok->Fun.ptr)(nOffset, nThreadID, Stack[sidx], Stack[sidx+1], Stack[sidx+2]); continue;
-                case 4: sidx -= 3; Stack[sidx] = (*(bulkfun_type4 )pTok->Fun.ptr)(nOffset, nThreadID, Stack[sidx], Stack[sidx+1], Stack[sidx+2], Stack[sidx+3]); continue;
-                case 5: sidx -= 4; Stack[sidx] = (*(bulkfun_type5 )pTok->Fun.ptr)(nOffset, nThreadID, Stack[sidx], Stack[sidx+1], Stack[sidx+2], Stack[sidx+3], Stack[sidx+4]); continue;
-                case 6: sidx -= 5; Stack[sidx] = (*(bulkfun_type6 )pTok->Fun.ptr)(nOffset, nThreadID, Stack[sidx], Stack[sidx+1], Stack[sidx+2], Stack[sidx+3], Stack[sidx+4], Stack[sidx+5]); continue;
-                case 7: sidx -= 6; Stack[sidx] = (*(bulkfun_type7 )pTok->Fun.ptr)(nOffset, nThreadID, Stack[sidx], Stack[sidx+1], Stack[sidx+2], Stack[sidx+3], Stack[sidx+4], Stack[sidx+5], Stack[sidx+6]); continue;
-                case 8: sidx -= 7; Stack[sidx] = (*(bulkfun_type8 )pTok->Fun.ptr)(nOffset, nThreadID, Stack[sidx], Stack[sidx+1], Stack[sidx+2], Stack[sidx+3], Stack[sidx+4], Stack[sidx+5], Stack[sidx+6], Stack[sidx+7]); continue;
-                case 9: sidx -= 8; Stack[sidx] = (*(bulkfun_type9 )pTok->Fun.ptr)(nOffset, nThreadID, Stack[sidx], Stack[sidx+1], Stack[sidx+2], Stack[sidx+3], Stack[sidx+4], Stack[sidx+5], Stack[sidx+6], Stack[sidx+7], Stack[sidx+8]); continue;
-                case 10:sidx -= 9; Stack[sidx] = (*(bulkfun_type10)pTok->Fun.ptr)(nOffset, nThreadID, Stack[sidx], Stack[sidx+1], Stack[sidx+2], Stack[sidx+3], Stack[sidx+4], Stack[sidx+5], Stack[sidx+6], Stack[sidx+7], Stack[sidx+8], Stack[sidx+9]); continue;
+                case 0: sidx += 1; Stack[sidx] = (*(bulkfun_type0 )pTok->Fun.ptr)(nOffset, nWorkerID); continue;
+                case 1:            Stack[sidx] = (*(bulkfun_type1 )pTok->Fun.ptr)(nOffset, nWorkerID, Stack[sidx]); continue;
+                case 2: sidx -= 1; Stack[sidx] = (*(bulkfun_type2 )pTok->Fun.ptr)(nOffset, nWorkerID, Stack[sidx], Stack[sidx+1]); continue;
+                case 3: sidx -= 2; Stack[sidx] = (*(bulkfun_type3 )pTok->Fun.ptr)(nOffset, nWorkerID, Stack[sidx], Stack[sidx+1], Stack[sidx+2]); continue;
+                case 4: sidx -= 3; Stack[sidx] = (*(bulkfun_type4 )pTok->Fun.ptr)(nOffset, nWorkerID, Stack[sidx], Stack[sidx+1], Stack[sidx+2], Stack[sidx+3]); continue;
+                case 5: sidx -= 4; Stack[sidx] = (*(bulkfun_type5 )pTok->Fun.ptr)(nOffset, nWorkerID, Stack[sidx], Stack[sidx+1], Stack[sidx+2], Stack[sidx+3], Stack[sidx+4]); continue;
+                case 6: sidx -= 5; Stack[sidx] = (*(bulkfun_type6 )pTok->Fun.ptr)(nOffset, nWorkerID, Stack[sidx], Stack[sidx+1], Stack[sidx+2], Stack[sidx+3], Stack[sidx+4], Stack[sidx+5]); continue;
+                case 7: sidx -= 6; Stack[sidx] = (*(bulkfun_type7 )pTok->Fun.ptr)(nOffset, nWorkerID, Stack[sidx], Stack[sidx+1], Stack[sidx+2], Stack[sidx+3], Stack[sidx+4], Stack[sidx+5], Stack[sidx+6]); continue;
+                case 8: sidx -= 7; Stack[sidx] = (*(bulkfun_type8 )pTok->Fun.ptr)(nOffset, nWorkerID, Stack[sidx], Stack[sidx+1], Stack[sidx+2], Stack[sidx+3], Stack[sidx+4], Stack[sidx+5], Stack[sidx+6], Stack[sidx+7]); continue;
+                case 9: sidx -= 8; Stack[sidx] = (*(bulkfun_type9 )pTok->Fun.ptr)(nOffset, nWorkerID, Stack[sidx], Stack[sidx+1], Stack[sidx+2], Stack[sidx+3], Stack[sidx+4], Stack[sidx+5], Stack[sidx+6], Stack[sidx+7], Stack[sidx+8]); continue;
+                case 10:sidx -= 9; Stack[sidx] = (*(bulkfun_type10)pTok->Fun.ptr)(nOffset, nWorkerID, Stack[sidx], Stack[sidx+1], Stack[sidx+2], Stack[sidx+3], Stack[sidx+4], Stack[sidx+5], Stack[sidx+6], Stack[sidx+7], Stack[sidx+8], Stack[sidx+9]); continue;
                 default:
                   Error(ecINTERNAL_ERROR, 2);
                   continue;
@@ -1173,6 +1395,300 @@ namespace mu
     return Stack[m_nFinalResultIdx];  
   }
 
+  //---------------------------------------------------------------------------
+  /** \brief Evaluate the RPN for a block of points at once.
+
+      Stack slot i holds the values of all points of the block, beginning at
+      Stack[i*s_BulkBlockSize]. Every token is a loop over the block, which
+      the compiler can vectorize, and functions with a block kernel are
+      called once per block. The bytecode must pass ParserByteCode::CanEvalBlocks(),
+      so loop indices are the same for all points and are kept in the first
+      value of their slot.
+
+      With a float stack values of variables are rounded to single precision
+      when they are loaded and results are converted back when they are
+      stored, everything in between is single precision arithmetic.
+
+      \param nOffset Index of the first point of the block
+      \param nCount Number of points in the block, up to #s_BulkBlockSize
+      \param Stack Stack buffer of GetMaxStackSize() slots
+      \param pResults Receives results of the points of the block
+  */
+  template<typename TStack>
+  void ParserBase::ParseCmdCodeBlock(int nOffset, int nCount, TStack *Stack, value_type *pResults) const
+  {
+    const int B = s_BulkBlockSize;
+    value_type aKernelBuf[s_BulkBlockSize];  // Used by single precision blocks only
+
+    // Apply a binary operator to the two topmost slots
+    #define MUP_BLOCK_BINOP(EXPR)               \
+            {                                   \
+              --sidx;                           \
+              TStack *a = &Stack[sidx*B];       \
+              const TStack *b = a + B;          \
+              MUP_SIMD                          \
+              for (int j=0; j<nCount; ++j)      \
+                a[j] = EXPR;                    \
+            }                                   \
+            continue
+
+    int sidx(0);
+    for (const SToken *pTok = m_vRPN.GetBase(); pTok->Cmd!=cmEND ; ++pTok)
+    {
+      switch (pTok->Cmd)
+      {
+      // built in binary operators
+      case  cmLE:   MUP_BLOCK_BINOP(a[j] <= b[j]);
+      case  cmGE:   MUP_BLOCK_BINOP(a[j] >= b[j]);
+      case  cmNEQ:  MUP_BLOCK_BINOP(a[j] != b[j]);
+      case  cmEQ:   MUP_BLOCK_BINOP(a[j] == b[j]);
+      case  cmLT:   MUP_BLOCK_BINOP(a[j] <  b[j]);
+      case  cmGT:   MUP_BLOCK_BINOP(a[j] >  b[j]);
+      case  cmADD:  MUP_BLOCK_BINOP(a[j] + b[j]);
+      case  cmSUB:  MUP_BLOCK_BINOP(a[j] - b[j]);
+      case  cmMUL:  MUP_BLOCK_BINOP(a[j] * b[j]);
+      case  cmLAND: MUP_BLOCK_BINOP(a[j] && b[j]);
+      case  cmLOR:  MUP_BLOCK_BINOP(a[j] || b[j]);
+      case  cmDIV:
+
+  #if defined(MUP_MATH_EXCEPTIONS)
+                  for (int j=0; j<nCount; ++j)
+                  {
+                    if (Stack[sidx*B + j]==0)
+                      Error(ecDIV_BY_ZERO);
+                  }
+  #endif
+                  MUP_BLOCK_BINOP(a[j] / b[j]);
+
+      case  cmPOW:
+            {
+              --sidx;
+              TStack *a = &Stack[sidx*B];
+              for (int j=0; j<nCount; ++j)
+                a[j] = MathImpl<TStack>::Pow(a[j], a[B+j]);
+            }
+            continue;
+
+      case  cmASSIGN:
+            {
+              --sidx;
+              TStack *a = &Stack[sidx*B];
+              value_type *pVar = pTok->Oprt.ptr + nOffset;
+              for (int j=0; j<nCount; ++j)
+                a[j] = pVar[j] = a[B+j];
+            }
+            continue;
+
+      // value and variable tokens
+      case  cmVAR:
+      case  cmVARPOW2:
+      case  cmVARPOW3:
+      case  cmVARPOW4:
+      case  cmVARMUL:
+            {
+              TStack *a = &Stack[++sidx*B];
+              const value_type *pVar = pTok->Val.ptr + nOffset;
+
+              switch (pTok->Cmd)
+              {
+              case cmVAR:
+                   MUP_SIMD
+                   for (int j=0; j<nCount; ++j)
+                     a[j] = static_cast<TStack>(pVar[j]);
+                   break;
+
+              case cmVARPOW2:
+                   MUP_SIMD
+                   for (int j=0; j<nCount; ++j)
+                     a[j] = static_cast<TStack>(pVar[j]*pVar[j]);
+                   break;
+
+              case cmVARPOW3:
+                   MUP_SIMD
+                   for (int j=0; j<nCount; ++j)
+                     a[j] = static_cast<TStack>(pVar[j]*pVar[j]*pVar[j]);
+                   break;
+
+              case cmVARPOW4:
+                   MUP_SIMD
+                   for (int j=0; j<nCount; ++j)
+                     a[j] = static_cast<TStack>(pVar[j]*pVar[j]*pVar[j]*pVar[j]);
+                   break;
+
+              default:
+                   MUP_SIMD
+                   for (int j=0; j<nCount; ++j)
+                     a[j] = static_cast<TStack>(pVar[j] * pTok->Val.data + pTok->Val.data2);
+                   break;
+              }
+            }
+            continue;
+
+      case  cmVAL:
+            std::fill_n(&Stack[++sidx*B], nCount, static_cast<TStack>(pTok->Val.data2));
+            continue;
+
+      // array elements and loops
+      case  cmVARIDX:
+            {
+              TStack *a = &Stack[sidx*B];
+              for (int j=0; j<nCount; ++j)
+              {
+                TStack fIdx = a[j];
+                a[j] = (fIdx>=0 && fIdx<pTok->Arr.size)
+                         ? static_cast<TStack>(*(pTok->Arr.ptr + (std::ptrdiff_t)fIdx * pTok->Arr.stride + nOffset + j))
+                         : std::numeric_limits<TStack>::quiet_NaN();
+              }
+            }
+            continue;
+
+      case  cmVARIDX_LOOP:
+            {
+              TStack fIdx = Stack[pTok->Arr.pos*B],
+                     *a = &Stack[++sidx*B];
+
+              if (fIdx>=0 && fIdx<pTok->Arr.size)
+                std::copy(pTok->Arr.ptr + (std::ptrdiff_t)fIdx * pTok->Arr.stride + nOffset,
+                          pTok->Arr.ptr + (std::ptrdiff_t)fIdx * pTok->Arr.stride + nOffset + nCount,
+                          a);
+              else
+                std::fill_n(a, nCount, std::numeric_limits<TStack>::quiet_NaN());
+            }
+            continue;
+
+      case  cmLOOPVAR:
+            std::fill_n(&Stack[++sidx*B], nCount, Stack[pTok->Loop.pos*B]);
+            continue;
+
+      case  cmLOOP_BEGIN:
+            {
+              // Slots of index, bound and result; the first two are uniform
+              TStack *pLoop = &Stack[pTok->Loop.pos*B];
+              std::fill_n(pLoop + 2*B, nCount, static_cast<TStack>((pTok->Loop.red==cmMUL) ? 1 : 0));
+              sidx = pTok->Loop.pos + 2;
+
+              if (!(pLoop[0]<pLoop[B]))
+              {
+                std::copy(pLoop + 2*B, pLoop + 2*B + nCount, pLoop);
+                sidx = pTok->Loop.pos;
+                pTok += pTok->Loop.offset;
+              }
+            }
+            continue;
+
+      case  cmLOOP_END:
+            {
+              TStack *pLoop = &Stack[pTok->Loop.pos*B],
+                     *pRes = pLoop + 2*B;
+              const TStack *a = &Stack[sidx*B];
+
+              if (pTok->Loop.red==cmMUL)
+              {
+                MUP_SIMD
+                for (int j=0; j<nCount; ++j)
+                  pRes[j] *= a[j];
+              }
+              else
+              {
+                MUP_SIMD
+                for (int j=0; j<nCount; ++j)
+                  pRes[j] += a[j];
+              }
+
+              if (++pLoop[0]<pLoop[B])
+              {
+                sidx = pTok->Loop.pos + 2;
+                pTok += pTok->Loop.offset;
+              }
+              else
+              {
+                std::copy(pRes, pRes + nCount, pLoop);
+                sidx = pTok->Loop.pos;
+              }
+            }
+            continue;
+
+      // numeric functions, CanEvalBlocks() admits up to three arguments
+      case  cmFUNC:
+            {
+              int iArgCount = pTok->Fun.argc;
+
+              switch(iArgCount)
+              {
+              case 0:
+                {
+                  TStack *a = &Stack[++sidx*B];
+                  for (int j=0; j<nCount; ++j)
+                    a[j] = static_cast<TStack>((*(fun_type0)pTok->Fun.ptr)());
+                }
+                continue;
+
+              case 1:
+                {
+                  TStack *a = &Stack[sidx*B];
+                  if (pTok->Fun.vec)
+                  {
+                    ApplyKernel(pTok->Fun.vec, a, nCount, m_eMathAccuracy, aKernelBuf);
+                  }
+                  else
+                  {
+                    for (int j=0; j<nCount; ++j)
+                      a[j] = static_cast<TStack>((*(fun_type1)pTok->Fun.ptr)(a[j]));
+                  }
+                }
+                continue;
+
+              case 2:
+                {
+                  TStack *a = &Stack[--sidx*B];
+                  for (int j=0; j<nCount; ++j)
+                    a[j] = static_cast<TStack>((*(fun_type2)pTok->Fun.ptr)(a[j], a[B+j]));
+                }
+                continue;
+
+              case 3:
+                {
+                  sidx -= 2;
+                  TStack *a = &Stack[sidx*B];
+                  for (int j=0; j<nCount; ++j)
+                    a[j] = static_cast<TStack>((*(fun_type3)pTok->Fun.ptr)(a[j], a[B+j], a[2*B+j]));
+                }
+                continue;
+
+              default:
+                {
+                  if (iArgCount>0)
+                    Error(ecINTERNAL_ERROR, 1);
+
+                  // Arguments of a point are gathered from their slots, 
+                  // CanEvalBlocks() bounds their number
+                  sidx -= -iArgCount - 1;
+                  TStack *a = &Stack[sidx*B];
+                  value_type aArg[ParserByteCode::s_MaxBlockArgCount];
+
+                  for (int j=0; j<nCount; ++j)
+                  {
+                    for (int i=0; i<-iArgCount; ++i)
+                      aArg[i] = a[i*B+j];
+
+                    a[j] = static_cast<TStack>((*(multfun_type)pTok->Fun.ptr)(aArg, -iArgCount));
+                  }
+                }
+                continue;
+              }
+            }
+
+      default:
+            Error(ecINTERNAL_ERROR, 3);
+            return;
+      } // switch CmdCode
+    } // for all bytecode tokens
+
+    #undef MUP_BLOCK_BINOP
+
+    std::copy(&Stack[m_nFinalResultIdx*B], &Stack[m_nFinalResultIdx*B] + nCount, pResults);
+  }
+
   //---------------------------------------------------------------------------
   void ParserBase::CreateRPN() const
   {
@@ -1181,6 +1697,7 @@ namespace mu
 
     ParserStack<token_type> stOpt, stVal;
     ParserStack<int> stArgCount;
+    std::vector<int> vLoopPos;  // Stack positions of the indices of loops with their body started
     token_type opta, opt;  // for storing operators
     token_type val, tval;  // for storing value
 
@@ -1215,6 +1732,14 @@ namespace mu
                 m_vRPN.AddVal( opt.GetVal() );
                 break;
 
+        case cmLOOPVAR:
+                {
+                  token_type tok;
+                  stVal.push(tok.SetVal(1));
+                  m_vRPN.AddLoopVar( vLoopPos.at(opt.GetIdx()) );
+                }
+                break;
+
         case cmELSE:
                 m_nIfElseCounter--;
                 if (m_nIfElseCounter<0)
@@ -1231,7 +1756,12 @@ namespace mu
                   Error(ecUNEXPECTED_ARG_SEP, m_pTokenReader->GetPos());
 
                 ++stArgCount.top();
-                // fallthrough intentional (no break!)
+                ApplyRemainingOprt(stOpt, stVal);
+
+                // Bounds of a loop are followed by its body
+                if (stOpt.size() && stOpt.top().GetCode()==cmLOOP && stArgCount.top()==3)
+                  vLoopPos.push_back( m_vRPN.AddLoop((ECmdCode)stOpt.top().GetIdx()) );
+                break;
 
         case cmEND:
                 ApplyRemainingOprt(stOpt, stVal);
@@ -1278,6 +1808,14 @@ namespace mu
                       ApplyFunc(stOpt, stVal, iArgCount);
                     }
                   }
+                  else if (stOpt.size() && stOpt.top().GetCode()==cmVARIDX)
+                  {
+                    ApplyArray(stOpt, stVal, stArgCount.pop());
+                  }
+                  else if (stOpt.size() && stOpt.top().GetCode()==cmLOOP)
+                  {
+                    ApplyLoop(stOpt, stVal, vLoopPos, stArgCount.pop());
+                  }
                 } // if bracket content is evaluated
                 break;
 
@@ -1310,6 +1848,8 @@ namespace mu
                 // A binary operator (user defined or built in) has been found. 
                 while ( stOpt.size() && 
                         stOpt.top().GetCode() != cmBO &&
+                        stOpt.top().GetCode() != cmVARIDX &&
+                        stOpt.top().GetCode() != cmLOOP &&
                         stOpt.top().GetCode() != cmELSE &&
                         stOpt.top().GetCode() != cmIF)
                 {
@@ -1350,6 +1890,8 @@ namespace mu
         // Last section contains functions and operators implicitly mapped to functions
         //
         case cmBO:
+        case cmVARIDX:  // array elements and loops open their brackets themselves
+        case cmLOOP:
                 stArgCount.push(1);
                 stOpt.push(opt);
                 break;
@@ -1402,7 +1944,7 @@ namespace mu
     if (stVal.top().GetType()!=tpDBL)
       Error(ecSTR_RESULT);
 
-    m_vStackBuffer.resize(m_vRPN.GetMaxStackSize() * s_MaxNumOpenMPThreads);
+    m_vStackBuffer.resize(m_vRPN.GetMaxStackSize());
   }
 
   //---------------------------------------------------------------------------
@@ -1454,6 +1996,7 @@ namespace mu
   void ParserBase::ClearVar()
   {
     m_VarDef.clear();
+    m_ArrDef.clear();
     ReInit();
   }
 
@@ -1581,6 +2124,33 @@ namespace mu
     return m_bBuiltInOp;
   }
 
+  //------------------------------------------------------------------------------
+  /** \brief Set the accuracy of block kernels of functions in bulk mode.
+      \throw nothrow
+
+    Bulk mode evaluates blocks of points with the kernels of functions
+    defined with one, e.g. the built-in functions of Parser. #maULP1 keeps
+    the results within 1 ulp, #maULP4 is faster and within 4 ulp. #maSingle
+    evaluates blocks in single precision, which halves the memory of the
+    stack and doubles the number of values per SIMD register, results are
+    accurate to about 1e-7 relative to the operands. The bytecode doesn't
+    depend on it, so the parser isn't reinitialized.
+  */
+  void ParserBase::SetMathAccuracy(EMathAccuracy a_eAccuracy)
+  {
+    m_eMathAccuracy = a_eAccuracy;
+  }
+
+  //------------------------------------------------------------------------------
+  /** \brief Query the accuracy of block kernels of functions in bulk mode.
+      \return #m_eMathAccuracy
+      \throw nothrow
+  */
+  EMathAccuracy ParserBase::GetMathAccuracy() const
+  {
+    return m_eMathAccuracy;
+  }
+
   //------------------------------------------------------------------------------
   /** \brief Get the argument separator character. 
   */
@@ -1714,68 +2284,128 @@ namespace mu
   }
 
   //---------------------------------------------------------------------------
+  /** \brief Evaluate the expression for all points of a bulk.
+
+      Variables point to arrays of nBulkSize values. With OpenMP the bulk is
+      split into chunks (see GetBulkChunkSize()) shared dynamically among the
+      threads, each of them with its own stack. Stacks are kept between calls,
+      so repeated evaluations don't allocate.
+
+      \param results Receives the results of the points
+      \param nBulkSize Number of points
+  */
   void ParserBase::Eval(value_type *results, int nBulkSize)
   {
-/* <ibg 2014-09-24/> Commented because it is making a unit test impossible
+    std::size_t nStackSize = GetBulkStackSize();
 
-    // Parallelization does not make sense for fewer than 10000 computations 
-    // due to thread creation overhead. If the bulk size is below 2000
-    // computation is refused. 
-    if (nBulkSize<2000)
-    {
-      throw ParserError(ecUNREASONABLE_NUMBER_OF_COMPUTATIONS);
-    }
-*/
-    CreateRPN();
+#ifdef MUP_USE_OPENMP
+    int nChunkSize = GetBulkChunkSize(nBulkSize, omp_get_max_threads()),
+        nChunks = (nBulkSize + nChunkSize - 1) / nChunkSize;
 
-    int i = 0;
+    m_vBulkStacks.resize(omp_get_max_threads());
 
-#ifdef MUP_USE_OPENMP
-//#define DEBUG_OMP_STUFF
-    #ifdef DEBUG_OMP_STUFF
-    int *pThread = new int[nBulkSize];
-    int *pIdx = new int[nBulkSize];
-    #endif
-
-    int nMaxThreads = std::min(omp_get_max_threads(), s_MaxNumOpenMPThreads);
-	int nThreadID = 0, ct = 0;
-    omp_set_num_threads(nMaxThreads);
-
-    #pragma omp parallel for schedule(static, nBulkSize/nMaxThreads) private(nThreadID)
-    for (i=0; i<nBulkSize; ++i)
+    #pragma omp parallel if(nChunks>1)
     {
-      nThreadID = omp_get_thread_num();
-      results[i] = ParseCmdCodeBulk(i, nThreadID);
+      valbuf_type &vStack = m_vBulkStacks[omp_get_thread_num()];
+      if (vStack.size()<nStackSize)
+        vStack.resize(nStackSize);
 
-      #ifdef DEBUG_OMP_STUFF
-      #pragma omp critical
+      #pragma omp for schedule(dynamic)
+      for (int i=0; i<nChunks; ++i)
       {
-        pThread[ct] = nThreadID;  
-        pIdx[ct] = i; 
-        ct++;
+        EvalBulk(results + i*nChunkSize, i*nChunkSize, std::min(nChunkSize, nBulkSize - i*nChunkSize), 
+                 &vStack[0], omp_get_thread_num());
       }
-      #endif
     }
+#else
+    m_vBulkStacks.resize(1);
+
+    valbuf_type &vStack = m_vBulkStacks[0];
+    if (vStack.size()<nStackSize)
+      vStack.resize(nStackSize);
+    EvalBulk(results, 0, nBulkSize, &vStack[0]);
+#endif
+  }
+
+  //---------------------------------------------------------------------------
+  /** \brief Evaluate the expression for a range of points of a bulk.
+
+      The caller owns the stack, so calls with different stacks may run
+      concurrently in threads of any kind. The parser itself is not modified,
+      provided GetBulkStackSize() has been called since the expression or
+      the variables were changed last.
+
+      \param results Receives the results of points nOffset to nOffset+nCount-1
+      \param nOffset Index of the first point
+      \param nCount Number of points
+      \param pStack Stack of GetBulkStackSize() values, used by one call at a time;
+                    single precision blocks (#maSingle) keep floats in it
+      \param nWorkerID Passed to bulk functions as the id of the calling thread
+  */
+  void ParserBase::EvalBulk(value_type *results, int nOffset, int nCount, value_type *pStack, int nWorkerID) const
+  {
+    if (m_pParseFormula==&ParserBase::ParseString)
+      GetBulkStackSize();
 
-#ifdef DEBUG_OMP_STUFF
-    FILE *pFile = fopen("bulk_dbg.txt", "w");
-    for (i=0; i<nBulkSize; ++i)
+    if (m_vRPN.CanEvalBlocks() && m_eMathAccuracy==maSingle)
     {
-      fprintf(pFile, "idx: %d  thread: %d \n", pIdx[i], pThread[i]);
+      // The stack holds as many values as the blocks need, floats fit in it
+      float *pFloatStack = reinterpret_cast<float*>(pStack);
+      for (int i=0; i<nCount; i+=s_BulkBlockSize)
+        ParseCmdCodeBlock(nOffset + i, std::min(s_BulkBlockSize, nCount - i), pFloatStack, results + i);
     }
-    
-    delete [] pIdx;
-    delete [] pThread;
+    else if (m_vRPN.CanEvalBlocks())
+    {
+      for (int i=0; i<nCount; i+=s_BulkBlockSize)
+        ParseCmdCodeBlock(nOffset + i, std::min(s_BulkBlockSize, nCount - i), pStack, results + i);
+    }
+    else
+    {
+      for (int i=0; i<nCount; ++i)
+        results[i] = ParseCmdCodeBulk(nOffset + i, nWorkerID, pStack);
+    }
+  }
 
-    fclose(pFile);
-#endif
+  //---------------------------------------------------------------------------
+  /** \brief Return the number of values of a stack passed to EvalBulk().
 
-#else
-    for (i=0; i<nBulkSize; ++i)
+      Compiles the expression unless it has been compiled already.
+  */
+  std::size_t ParserBase::GetBulkStackSize() const
+  {
+    if (m_pParseFormula==&ParserBase::ParseString)
     {
-      results[i] = ParseCmdCodeBulk(i, 0);
+      try
+      {
+        CreateRPN();
+        m_pParseFormula = &ParserBase::ParseCmdCode;
+      }
+      catch(ParserError &exc)
+      {
+        exc.SetFormula(m_pTokenReader->GetExpr());
+        throw;
+      }
     }
-#endif
 
+    return m_vRPN.GetMaxStackSize() * (m_vRPN.CanEvalBlocks() ? s_BulkBlockSize : 1);
+  }
+
+  //---------------------------------------------------------------------------
+  /** \brief Return the number of points of the chunks a bulk is split into.
+
+      Chunks are whole blocks of #s_BulkBlockSize points. Each worker gets 
+      at least four of them, so workers finishing early can take over the
+      chunks of others, and none exceeds #s_BulkChunkSize points, so the
+      values of a chunk stay in cache while it is evaluated.
+
+      \param nBulkSize Number of points of the bulk
+      \param nWorkers Number of threads sharing the chunks
+  */
+  int ParserBase::GetBulkChunkSize(int nBulkSize, int nWorkers)
+  {
+    int nSize = nBulkSize / (4 * std::max(1, nWorkers));
+
+    nSize = (nSize + s_BulkBlockSize - 1) / s_BulkBlockSize * s_BulkBlockSize;
+    return std::min(std::max(nSize, s_BulkBlockSize), s_BulkChunkSize);
   }
 } // namespace mu
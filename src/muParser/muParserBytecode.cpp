@@ -30,6 +30,8 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <stack>
 #include <vector>
@@ -98,6 +100,52 @@ namespace mu
 	m_bEnableOptimizer = a_ByteCode.m_bEnableOptimizer;
   }
 
+  //---------------------------------------------------------------------------
+  /** \brief Move variable pointers from one array of variables to another.
+
+      Pointers into the array of \a a_iCount variables starting at
+      \a a_pOldBase are redirected to the same items of \a a_pNewBase,
+      so bytecode compiled for one array may be evaluated with another.
+      \throw nothrow
+  */
+  void ParserByteCode::RebaseVar(const value_type *a_pOldBase, value_type *a_pNewBase, std::size_t a_iCount)
+  {
+    const std::uintptr_t iBegin = reinterpret_cast<std::uintptr_t>(a_pOldBase),
+                         iEnd   = iBegin + a_iCount * sizeof(value_type);
+
+    for (std::size_t i=0; i<m_vRPN.size(); ++i)
+    {
+      value_type **ppVar = 0;
+
+      switch (m_vRPN[i].Cmd)
+      {
+      case cmVAR:
+      case cmVARPOW2:
+      case cmVARPOW3:
+      case cmVARPOW4:
+      case cmVARMUL:
+           ppVar = &m_vRPN[i].Val.ptr;
+           break;
+
+      case cmASSIGN:
+           ppVar = &m_vRPN[i].Oprt.ptr;
+           break;
+
+      case cmVARIDX:
+      case cmVARIDX_LOOP:
+           ppVar = &m_vRPN[i].Arr.ptr;
+           break;
+
+      default:
+           continue;
+      }
+
+      const std::uintptr_t iPos = reinterpret_cast<std::uintptr_t>(*ppVar);
+      if (iPos>=iBegin && iPos<iEnd)
+        *ppVar = a_pNewBase + (iPos - iBegin) / sizeof(value_type);
+    }
+  }
+
   //---------------------------------------------------------------------------
   /** \brief Add a Variable pointer to bytecode. 
       \param a_pVar Pointer to be added.
@@ -117,6 +165,29 @@ namespace mu
     m_vRPN.push_back(tok);
   }
 
+  //---------------------------------------------------------------------------
+  /** \brief Add a variable token of optimized bytecode reading another variable.
+
+      Tokens fused by the optimizer (cmVARMUL, cmVARPOW2, ...) can't be rebuilt
+      from AddVar, AddVal and AddOp without changing their rounding, so they are
+      copied with only the variable pointer replaced.
+      \param a_Tok Token of cmVAR, cmVARMUL, cmVARPOW2, cmVARPOW3 or cmVARPOW4.
+      \param a_pVar Pointer to the variable read by the token.
+      \throw nothrow
+  */
+  void ParserByteCode::AddOptimizedVar(const SToken &a_Tok, value_type *a_pVar)
+  {
+    assert(a_Tok.Cmd==cmVAR || a_Tok.Cmd==cmVARMUL || a_Tok.Cmd==cmVARPOW2 ||
+           a_Tok.Cmd==cmVARPOW3 || a_Tok.Cmd==cmVARPOW4);
+
+    ++m_iStackPos;
+    m_iMaxStackSize = std::max(m_iMaxStackSize, (size_t)m_iStackPos);
+
+    SToken tok = a_Tok;
+    tok.Val.ptr = a_pVar;
+    m_vRPN.push_back(tok);
+  }
+
   //---------------------------------------------------------------------------
   /** \brief Add a Variable pointer to bytecode. 
 
@@ -327,6 +398,12 @@ namespace mu
   //---------------------------------------------------------------------------
   void ParserByteCode::AddIfElse(ECmdCode a_Oprt)
   {
+    // The condition is taken from the stack and both branches leave their
+    // value at the same position, so code after the if-then-else and loops
+    // in it see the actual stack positions.
+    if (a_Oprt==cmIF || a_Oprt==cmELSE)
+      --m_iStackPos;
+
     SToken tok;
     tok.Cmd = a_Oprt;
     m_vRPN.push_back(tok);
@@ -358,8 +435,9 @@ namespace mu
 
       \param a_iArgc Number of arguments, negative numbers indicate multiarg functions.
       \param a_pFun Pointer to function callback.
+      \param a_pVecFun Block kernel of the function for bulk mode, used with one argument only.
   */
-  void ParserByteCode::AddFun(generic_fun_type a_pFun, int a_iArgc)
+  void ParserByteCode::AddFun(generic_fun_type a_pFun, int a_iArgc, vecfun_type1 a_pVecFun)
   {
     if (a_iArgc>=0)
     {
@@ -376,6 +454,7 @@ namespace mu
     tok.Cmd = cmFUNC;
     tok.Fun.argc = a_iArgc;
     tok.Fun.ptr = a_pFun;
+    tok.Fun.vec = (a_iArgc==1) ? a_pVecFun : 0;
     m_vRPN.push_back(tok);
   }
 
@@ -419,20 +498,132 @@ namespace mu
     m_iMaxStackSize = std::max(m_iMaxStackSize, (size_t)m_iStackPos);
   }
 
+  //---------------------------------------------------------------------------
+  /** \brief Add an array element to bytecode.
+
+      The element index is taken from the top of the stack and truncated, indices
+      out of range give NaN. A constant index makes the element a plain variable, 
+      a loop index is read from its loop directly.
+
+      \param a_pVar Address of the first element.
+      \param a_iSize Number of elements.
+      \param a_iStride Distance between two elements.
+  */
+  void ParserByteCode::AddArrayVar(value_type *a_pVar, int a_iSize, int a_iStride)
+  {
+    SToken &idx = m_vRPN.back();
+
+    if (m_bEnableOptimizer && idx.Cmd==cmVAL && idx.Val.data2>=0 && idx.Val.data2<a_iSize)
+    {
+      // Optimization: x[2] -> variable
+      idx.Cmd       = cmVAR;
+      idx.Val.ptr   = a_pVar + (std::ptrdiff_t)idx.Val.data2 * a_iStride;
+      idx.Val.data  = 1;
+      idx.Val.data2 = 0;
+      return;
+    }
+
+    SToken tok;
+    tok.Cmd = cmVARIDX;
+    tok.Arr.ptr = a_pVar;
+    tok.Arr.size = a_iSize;
+    tok.Arr.stride = a_iStride;
+    tok.Arr.pos = 0;
+
+    if (m_bEnableOptimizer && idx.Cmd==cmLOOPVAR)
+    {
+      // Optimization: loop index followed by indexing -> single token
+      tok.Cmd = cmVARIDX_LOOP;
+      tok.Arr.pos = idx.Loop.pos;
+      idx = tok;
+      return;
+    }
+
+    m_vRPN.push_back(tok);
+  }
+
+  //---------------------------------------------------------------------------
+  /** \brief Add start of a loop to bytecode.
+
+      The lower and the upper bound of the loop index are on top of the stack. 
+      The loop keeps its index in place of the lower bound and its result next
+      to the upper bound, so the loop body starts with a stack of three more items.
+
+      \param a_Reduction cmADD for sums, cmMUL for products.
+      \return Stack position of the loop index.
+  */
+  int ParserByteCode::AddLoop(ECmdCode a_Reduction)
+  {
+    int iPos = (int)m_iStackPos - 1;
+
+    ++m_iStackPos;
+    m_iMaxStackSize = std::max(m_iMaxStackSize, (size_t)m_iStackPos);
+
+    SToken tok;
+    tok.Cmd = cmLOOP_BEGIN;
+    tok.Loop.pos = iPos;
+    tok.Loop.offset = 0;
+    tok.Loop.red = a_Reduction;
+    m_vRPN.push_back(tok);
+
+    return iPos;
+  }
+
+  //---------------------------------------------------------------------------
+  /** \brief Add loop index to bytecode.
+      \param a_iPos Stack position of the index as returned by AddLoop.
+  */
+  void ParserByteCode::AddLoopVar(int a_iPos)
+  {
+    ++m_iStackPos;
+    m_iMaxStackSize = std::max(m_iMaxStackSize, (size_t)m_iStackPos);
+
+    SToken tok;
+    tok.Cmd = cmLOOPVAR;
+    tok.Loop.pos = a_iPos;
+    tok.Loop.offset = 0;
+    tok.Loop.red = cmUNKNOWN;
+    m_vRPN.push_back(tok);
+  }
+
+  //---------------------------------------------------------------------------
+  /** \brief Add end of a loop to bytecode.
+
+      The body value is accumulated and the loop result replaces the loop 
+      index once the upper bound is reached.
+
+      \param a_iPos Stack position of the index as returned by AddLoop.
+      \param a_Reduction cmADD for sums, cmMUL for products.
+  */
+  void ParserByteCode::AddLoopEnd(int a_iPos, ECmdCode a_Reduction)
+  {
+    m_iStackPos = a_iPos;
+
+    SToken tok;
+    tok.Cmd = cmLOOP_END;
+    tok.Loop.pos = a_iPos;
+    tok.Loop.offset = 0;
+    tok.Loop.red = a_Reduction;
+    m_vRPN.push_back(tok);
+  }
+
   //---------------------------------------------------------------------------
   /** \brief Add end marker to bytecode.
       
+      \param a_bShrink Shrink the bytecode vector to fit; bytecode cleared 
+                       and refilled over and over keeps its storage instead.
       \throw nothrow 
   */
-  void ParserByteCode::Finalize()
+  void ParserByteCode::Finalize(bool a_bShrink)
   {
     SToken tok;
     tok.Cmd = cmEND;
     m_vRPN.push_back(tok);
-    rpn_type(m_vRPN).swap(m_vRPN);     // shrink bytecode vector to fit
+    if (a_bShrink)
+      rpn_type(m_vRPN).swap(m_vRPN);   // shrink bytecode vector to fit
 
-    // Determine the if-then-else jump offsets
-    ParserStack<int> stIf, stElse;
+    // Determine the if-then-else and loop jump offsets
+    ParserStack<int> stIf, stElse, stLoop;
     int idx;
     for (int i=0; i<(int)m_vRPN.size(); ++i)
     {
@@ -453,6 +644,16 @@ namespace mu
             m_vRPN[idx].Oprt.offset = i - idx;
             break;
 
+      case cmLOOP_BEGIN:
+            stLoop.push(i);
+            break;
+
+      case cmLOOP_END:
+            idx = stLoop.pop();
+            m_vRPN[idx].Loop.offset = i - idx;
+            m_vRPN[i].Loop.offset = idx - i;
+            break;
+
       default:
             break;
       }
@@ -474,6 +675,50 @@ namespace mu
     return m_iMaxStackSize+1;
   }
 
+  //---------------------------------------------------------------------------
+  /** \brief Check if the bytecode can be evaluated over blocks of points.
+
+      All points of a block take the same path through the bytecode, so there
+      must be no if-then-else and loop bounds must be constants or loop indices.
+      String functions, bulk functions, functions of more than three
+      arguments and functions of any number of arguments given more than 
+      #s_MaxBlockArgCount of them are evaluated point by point.
+  */
+  bool ParserByteCode::CanEvalBlocks() const
+  {
+    for (std::size_t i=0; i<m_vRPN.size(); ++i)
+    {
+      switch (m_vRPN[i].Cmd)
+      {
+      case cmIF:
+      case cmELSE:
+      case cmENDIF:
+      case cmFUNC_STR:
+      case cmFUNC_BULK:
+            return false;
+
+      case cmFUNC:
+            if (m_vRPN[i].Fun.argc>3 || -m_vRPN[i].Fun.argc>s_MaxBlockArgCount)
+              return false;
+            break;
+
+      case cmLOOP_BEGIN:
+            // Start and bound are single tokens right before the loop
+            for (std::size_t j=i-2; j<i; ++j)
+            {
+              if (m_vRPN[j].Cmd!=cmVAL && m_vRPN[j].Cmd!=cmLOOPVAR)
+                return false;
+            }
+            break;
+
+      default:
+            break;
+      }
+    }
+
+    return true;
+  }
+
   //---------------------------------------------------------------------------
   /** \brief Returns the number of entries in the bytecode. */
   std::size_t ParserByteCode::GetSize() const
@@ -539,6 +784,30 @@ namespace mu
                       mu::console() << _T(" + [") << m_vRPN[i].Val.data2 << _T("]\n");
                       break;
 
+      case cmVARIDX:
+      case cmVARIDX_LOOP:
+                    mu::console() << ((m_vRPN[i].Cmd==cmVARIDX) ? _T("VARIDX \t") : _T("VARIDX LOOP \t"));
+                    mu::console() << _T("[ADDR: 0x") << std::hex << m_vRPN[i].Arr.ptr << _T("]");
+                    mu::console() << _T("[SIZE:") << std::dec << m_vRPN[i].Arr.size << _T("]");
+                    mu::console() << _T("[STRIDE:") << m_vRPN[i].Arr.stride << _T("]");
+                    if (m_vRPN[i].Cmd==cmVARIDX_LOOP)
+                      mu::console() << _T("[POS:") << m_vRPN[i].Arr.pos << _T("]");
+                    mu::console() << _T("\n");
+                    break;
+
+      case cmLOOPVAR:
+                    mu::console() << _T("LOOPVAR\t");
+                    mu::console() << _T("[POS:") << std::dec << m_vRPN[i].Loop.pos << _T("]\n");
+                    break;
+
+      case cmLOOP_BEGIN:
+      case cmLOOP_END:
+                    mu::console() << ((m_vRPN[i].Cmd==cmLOOP_BEGIN) ? _T("LOOP\t") : _T("ENDLOOP\t"));
+                    mu::console() << ((m_vRPN[i].Loop.red==cmMUL) ? _T("[PROD]") : _T("[SUM]"));
+                    mu::console() << _T("[POS:") << std::dec << m_vRPN[i].Loop.pos << _T("]");
+                    mu::console() << _T("[OFFSET:") << m_vRPN[i].Loop.offset << _T("]\n");
+                    break;
+
       case cmFUNC:  mu::console() << _T("CALL\t");
                     mu::console() << _T("[ARG:") << std::dec << m_vRPN[i].Fun.argc << _T("]"); 
                     mu::console() << _T("[ADDR: 0x") << std::hex << m_vRPN[i].Fun.ptr << _T("]"); 
@@ -43,6 +43,7 @@ namespace mu
     ,m_iCode(cmFUNC)
     ,m_iType(tpDBL)
     ,m_bAllowOpti(a_bAllowOpti)
+    ,m_pVecFun(0)
   {}
 
   //---------------------------------------------------------------------------
@@ -54,6 +55,25 @@ namespace mu
     ,m_iCode(a_iCode)
     ,m_iType(tpDBL)
     ,m_bAllowOpti(a_bAllowOpti)
+    ,m_pVecFun(0)
+  {}
+
+  //---------------------------------------------------------------------------
+  /** \brief Constructor for functions of one argument with a block kernel.
+      \param a_pFun Pointer to the function
+      \param a_pVecFun Kernel applying the function to a block of values in bulk mode
+      \param a_bAllowOpti A flag indicating this function can be optimized
+      \throw nothrow
+  */
+  ParserCallback::ParserCallback(fun_type1 a_pFun, vecfun_type1 a_pVecFun, bool a_bAllowOpti)
+    :m_pFun((void*)a_pFun)
+    ,m_iArgc(1)
+    ,m_iPri(-1)
+    ,m_eOprtAsct(oaNONE)
+    ,m_iCode(cmFUNC)
+    ,m_iType(tpDBL)
+    ,m_bAllowOpti(a_bAllowOpti)
+    ,m_pVecFun(a_pVecFun)
   {}
 
 
@@ -69,6 +89,7 @@ namespace mu
     ,m_iCode(cmFUNC)
     ,m_iType(tpDBL)
     ,m_bAllowOpti(a_bAllowOpti)
+    ,m_pVecFun(0)
   {}
 
   //---------------------------------------------------------------------------
@@ -90,6 +111,7 @@ namespace mu
     ,m_iCode(cmOPRT_BIN)
     ,m_iType(tpDBL)
     ,m_bAllowOpti(a_bAllowOpti)
+    ,m_pVecFun(0)
   {}
 
   //---------------------------------------------------------------------------
@@ -101,6 +123,7 @@ namespace mu
     ,m_iCode(cmFUNC)
     ,m_iType(tpDBL)
     ,m_bAllowOpti(a_bAllowOpti)
+    ,m_pVecFun(0)
   {}
 
 
@@ -113,6 +136,7 @@ namespace mu
     ,m_iCode(cmFUNC)
     ,m_iType(tpDBL)
     ,m_bAllowOpti(a_bAllowOpti)
+    ,m_pVecFun(0)
   {}
 
 
@@ -125,6 +149,7 @@ namespace mu
     ,m_iCode(cmFUNC)
     ,m_iType(tpDBL)
     ,m_bAllowOpti(a_bAllowOpti)
+    ,m_pVecFun(0)
   {}
 
   //---------------------------------------------------------------------------
@@ -136,6 +161,7 @@ namespace mu
     ,m_iCode(cmFUNC)
     ,m_iType(tpDBL)
     ,m_bAllowOpti(a_bAllowOpti)
+    ,m_pVecFun(0)
   {}
 
   //---------------------------------------------------------------------------
@@ -147,6 +173,7 @@ namespace mu
     ,m_iCode(cmFUNC)
     ,m_iType(tpDBL)
     ,m_bAllowOpti(a_bAllowOpti)
+    ,m_pVecFun(0)
   {}
 
   //---------------------------------------------------------------------------
@@ -158,6 +185,7 @@ namespace mu
     ,m_iCode(cmFUNC)
     ,m_iType(tpDBL)
     ,m_bAllowOpti(a_bAllowOpti)
+    ,m_pVecFun(0)
   {}
 
   //---------------------------------------------------------------------------
@@ -169,6 +197,7 @@ namespace mu
     ,m_iCode(cmFUNC)
     ,m_iType(tpDBL)
     ,m_bAllowOpti(a_bAllowOpti)
+    ,m_pVecFun(0)
   {}
 
   //---------------------------------------------------------------------------
@@ -180,6 +209,7 @@ namespace mu
     ,m_iCode(cmFUNC)
     ,m_iType(tpDBL)
     ,m_bAllowOpti(a_bAllowOpti)
+    ,m_pVecFun(0)
   {}
 
   //---------------------------------------------------------------------------
@@ -191,6 +221,7 @@ namespace mu
     ,m_iCode(cmFUNC_BULK)
     ,m_iType(tpDBL)
     ,m_bAllowOpti(a_bAllowOpti)
+    ,m_pVecFun(0)
   {}
 
   //---------------------------------------------------------------------------
@@ -202,6 +233,7 @@ namespace mu
     ,m_iCode(cmFUNC_BULK)
     ,m_iType(tpDBL)
     ,m_bAllowOpti(a_bAllowOpti)
+    ,m_pVecFun(0)
   {}
 
 
@@ -217,6 +249,7 @@ namespace mu
     ,m_iCode(cmFUNC_BULK)
     ,m_iType(tpDBL)
     ,m_bAllowOpti(a_bAllowOpti)
+    ,m_pVecFun(0)
   {}
 
   //---------------------------------------------------------------------------
@@ -228,6 +261,7 @@ namespace mu
     ,m_iCode(cmFUNC_BULK)
     ,m_iType(tpDBL)
     ,m_bAllowOpti(a_bAllowOpti)
+    ,m_pVecFun(0)
   {}
 
 
@@ -240,6 +274,7 @@ namespace mu
     ,m_iCode(cmFUNC_BULK)
     ,m_iType(tpDBL)
     ,m_bAllowOpti(a_bAllowOpti)
+    ,m_pVecFun(0)
   {}
 
 
@@ -252,6 +287,7 @@ namespace mu
     ,m_iCode(cmFUNC_BULK)
     ,m_iType(tpDBL)
     ,m_bAllowOpti(a_bAllowOpti)
+    ,m_pVecFun(0)
   {}
 
   //---------------------------------------------------------------------------
@@ -263,6 +299,7 @@ namespace mu
     ,m_iCode(cmFUNC_BULK)
     ,m_iType(tpDBL)
     ,m_bAllowOpti(a_bAllowOpti)
+    ,m_pVecFun(0)
   {}
 
   //---------------------------------------------------------------------------
@@ -274,6 +311,7 @@ namespace mu
     ,m_iCode(cmFUNC_BULK)
     ,m_iType(tpDBL)
     ,m_bAllowOpti(a_bAllowOpti)
+    ,m_pVecFun(0)
   {}
 
   //---------------------------------------------------------------------------
@@ -285,6 +323,7 @@ namespace mu
     ,m_iCode(cmFUNC_BULK)
     ,m_iType(tpDBL)
     ,m_bAllowOpti(a_bAllowOpti)
+    ,m_pVecFun(0)
   {}
 
   //---------------------------------------------------------------------------
@@ -296,6 +335,7 @@ namespace mu
     ,m_iCode(cmFUNC_BULK)
     ,m_iType(tpDBL)
     ,m_bAllowOpti(a_bAllowOpti)
+    ,m_pVecFun(0)
   {}
 
   //---------------------------------------------------------------------------
@@ -307,6 +347,7 @@ namespace mu
     ,m_iCode(cmFUNC_BULK)
     ,m_iType(tpDBL)
     ,m_bAllowOpti(a_bAllowOpti)
+    ,m_pVecFun(0)
   {}
 
 
@@ -319,6 +360,7 @@ namespace mu
     ,m_iCode(cmFUNC)
     ,m_iType(tpDBL)
     ,m_bAllowOpti(a_bAllowOpti)
+    ,m_pVecFun(0)
   {}
 
 
@@ -331,6 +373,7 @@ namespace mu
     ,m_iCode(cmFUNC_STR)
     ,m_iType(tpSTR)
     ,m_bAllowOpti(a_bAllowOpti)
+    ,m_pVecFun(0)
   {}
 
 
@@ -343,6 +386,7 @@ namespace mu
     ,m_iCode(cmFUNC_STR)
     ,m_iType(tpSTR)
     ,m_bAllowOpti(a_bAllowOpti)
+    ,m_pVecFun(0)
   {}
 
 
@@ -355,6 +399,7 @@ namespace mu
     ,m_iCode(cmFUNC_STR)
     ,m_iType(tpSTR)
     ,m_bAllowOpti(a_bAllowOpti)
+    ,m_pVecFun(0)
   {}
 
 
@@ -370,6 +415,7 @@ namespace mu
     ,m_iCode(cmUNKNOWN)
     ,m_iType(tpVOID)
     ,m_bAllowOpti(0)
+    ,m_pVecFun(0)
   {}
 
 
@@ -380,6 +426,7 @@ namespace mu
   ParserCallback::ParserCallback(const ParserCallback &ref)
   {
     m_pFun       = ref.m_pFun;
+    m_pVecFun    = ref.m_pVecFun;
     m_iArgc      = ref.m_iArgc;
     m_bAllowOpti = ref.m_bAllowOpti;
     m_iCode      = ref.m_iCode;
@@ -420,6 +467,16 @@ namespace mu
     return m_pFun;  
   }
 
+  //---------------------------------------------------------------------------
+  /** \brief Get the kernel applying the function to a block of values.
+      \throw nothrow
+      \return #m_pVecFun, 0 if the function has no kernel
+  */
+  vecfun_type1 ParserCallback::GetVecAddr() const
+  {
+    return m_pVecFun;
+  }
+
   //---------------------------------------------------------------------------
   /** \brief Return the callback code. */
   ECmdCode  ParserCallback::GetCode() const 
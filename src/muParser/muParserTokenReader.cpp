@@ -89,6 +89,7 @@ namespace mu
     m_pFunDef         = a_Reader.m_pFunDef;
     m_pConstDef       = a_Reader.m_pConstDef;
     m_pVarDef         = a_Reader.m_pVarDef;
+    m_pArrDef         = a_Reader.m_pArrDef;
     m_pStrVarDef      = a_Reader.m_pStrVarDef;
     m_pPostOprtDef    = a_Reader.m_pPostOprtDef;
     m_pInfixOprtDef   = a_Reader.m_pInfixOprtDef;
@@ -97,10 +98,12 @@ namespace mu
     m_vIdentFun       = a_Reader.m_vIdentFun;
     m_pFactory        = a_Reader.m_pFactory;
     m_pFactoryData    = a_Reader.m_pFactoryData;
-    m_iBrackets       = a_Reader.m_iBrackets;
+    m_sBrackets       = a_Reader.m_sBrackets;
+    m_vLoops          = a_Reader.m_vLoops;
     m_cArgSep         = a_Reader.m_cArgSep;
 	m_fZero           = a_Reader.m_fZero;
 	m_lastTok         = a_Reader.m_lastTok;
+    m_iNamePos        = -1;
   }
 
   //---------------------------------------------------------------------------
@@ -125,14 +128,19 @@ namespace mu
     ,m_pConstDef(NULL)
     ,m_pStrVarDef(NULL)
     ,m_pVarDef(NULL)
+    ,m_pArrDef(NULL)
     ,m_pFactory(NULL)
     ,m_pFactoryData(NULL)
     ,m_vIdentFun()
     ,m_UsedVar()
     ,m_fZero(0)
-    ,m_iBrackets(0)
+    ,m_sBrackets()
+    ,m_vLoops()
     ,m_lastTok()
     ,m_cArgSep(',')
+    ,m_iNamePos(-1)
+    ,m_iNameEnd(-1)
+    ,m_sName()
   {
     assert(m_pParser);
     SetParent(m_pParser);
@@ -248,9 +256,11 @@ namespace mu
   {
     m_iPos = 0;
     m_iSynFlags = sfSTART_OF_LINE;
-    m_iBrackets = 0;
+    m_sBrackets.clear();
+    m_vLoops.clear();
     m_UsedVar.clear();
     m_lastTok = token_type();
+    m_iNamePos = -1;
   }
 
   //---------------------------------------------------------------------------
@@ -268,10 +278,13 @@ namespace mu
 
     if ( IsEOF(tok) )        return SaveBeforeReturn(tok); // Check for end of formula
     if ( IsOprt(tok) )       return SaveBeforeReturn(tok); // Check for user defined binary operator
+    if ( IsLoopTok(tok) )    return SaveBeforeReturn(tok); // Check for loops such as sum(i, 0, n, x[i])
     if ( IsFunTok(tok) )     return SaveBeforeReturn(tok); // Check for function token
     if ( IsBuiltIn(tok) )    return SaveBeforeReturn(tok); // Check built in operators / tokens
     if ( IsArgSep(tok) )     return SaveBeforeReturn(tok); // Check for function argument separators
+    if ( IsArrayTok(tok) )   return SaveBeforeReturn(tok); // Check for array elements
     if ( IsValTok(tok) )     return SaveBeforeReturn(tok); // Check for values / constant tokens
+    if ( IsLoopVarTok(tok) ) return SaveBeforeReturn(tok); // Check for loop indices
     if ( IsVarTok(tok) )     return SaveBeforeReturn(tok); // Check for variable tokens
     if ( IsStrVarTok(tok) )  return SaveBeforeReturn(tok); // Check for string variables
     if ( IsString(tok) )     return SaveBeforeReturn(tok); // Check for String tokens
@@ -293,7 +306,7 @@ namespace mu
     // !!! From this point on there is no exit without an exception possible...
     // 
     string_type strTok;
-    int iEnd = ExtractToken(m_pParser->ValidNameChars(), strTok, m_iPos);
+    int iEnd = ExtractName(strTok, m_iPos);
     if (iEnd!=m_iPos)
       Error(ecUNASSIGNABLE_TOKEN, m_iPos, strTok);
 
@@ -310,6 +323,7 @@ namespace mu
     m_pInfixOprtDef = &a_pParent->m_InfixOprtDef;
     m_pPostOprtDef  = &a_pParent->m_PostOprtDef;
     m_pVarDef       = &a_pParent->m_VarDef;
+    m_pArrDef       = &a_pParent->m_ArrDef;
     m_pStrVarDef    = &a_pParent->m_StrVarDef;
     m_pConstDef     = &a_pParent->m_ConstDef;
   }
@@ -339,6 +353,32 @@ namespace mu
     return iEnd;
   }
 
+  //---------------------------------------------------------------------------
+  /** \brief Extract the name starting at a given position.
+
+    Function, constant and variable checks all read the same name, so the
+    last one is kept and extracted only once per token.
+
+    \param a_sTok [out] The name, unchanged if there is none.
+    \param a_iPos [in] Position in the string from where to start reading.
+    \return The Position of the first character not valid in names.
+    \throw nothrow
+  */
+  int ParserTokenReader::ExtractName(string_type &a_sTok, int a_iPos)
+  {
+    if (a_iPos!=m_iNamePos)
+    {
+      m_sName.clear();
+      m_iNameEnd = ExtractToken(m_pParser->ValidNameChars(), m_sName, a_iPos);
+      m_iNamePos = a_iPos;
+    }
+
+    if (m_iNameEnd!=a_iPos)
+      a_sTok = m_sName;
+
+    return m_iNameEnd;
+  }
+
   //---------------------------------------------------------------------------
   /** \brief Check Expression for the presence of a binary operator token.
   
@@ -383,8 +423,12 @@ namespace mu
     // check string for operator/function
     for (int i=0; pOprtDef[i]; i++)
     {
+      // Reject operators by their first character, then compare in place
+      if (pOprtDef[i][0]!=szFormula[m_iPos])
+        continue;
+
       std::size_t len( std::char_traits<char_type>::length(pOprtDef[i]) );
-      if ( string_type(pOprtDef[i]) == string_type(szFormula + m_iPos, szFormula + m_iPos + len) )
+      if ( m_strFormula.compare(m_iPos, len, pOprtDef[i])==0 )
       {
         switch(i)
         {
@@ -436,7 +480,7 @@ namespace mu
               else
                 m_iSynFlags = noBC | noOPT | noEND | noARG_SEP | noPOSTOP | noASSIGN| noIF | noELSE;
 
-              ++m_iBrackets;
+              m_sBrackets += '(';
               break;
 
 		    case cmBC:
@@ -445,8 +489,14 @@ namespace mu
 
               m_iSynFlags  = noBO | noVAR | noVAL | noFUN | noINFIXOP | noSTR | noASSIGN;
 
-              if (--m_iBrackets<0)
+              if (m_sBrackets.empty() || m_sBrackets[m_sBrackets.size()-1]!='(')
                 Error(ecUNEXPECTED_PARENS, m_iPos, pOprtDef[i]);
+
+              // The loop index is unknown after the loop
+              if (m_vLoops.size() && m_vLoops.back().iDepth==m_sBrackets.size())
+                m_vLoops.pop_back();
+
+              m_sBrackets.resize(m_sBrackets.size()-1);
               break;
 
         case cmELSE:
@@ -494,6 +544,9 @@ namespace mu
       m_iSynFlags  = noBC | noOPT | noEND | noARG_SEP | noPOSTOP | noASSIGN;
       m_iPos++;
       a_Tok.Set(cmARG_SEP, szSep);
+
+      if (m_vLoops.size() && m_vLoops.back().iDepth==m_sBrackets.size())
+        ++m_vLoops.back().iArg;
       return true;
     }
 
@@ -518,8 +571,8 @@ namespace mu
       if ( m_iSynFlags & noEND )
         Error(ecUNEXPECTED_EOF, m_iPos);
 
-      if (m_iBrackets>0)
-        Error(ecMISSING_PARENS, m_iPos, _T(")"));
+      if (m_sBrackets.size())
+        Error(ecMISSING_PARENS, m_iPos, (m_sBrackets[m_sBrackets.size()-1]=='[') ? _T("]") : _T(")"));
 
       m_iSynFlags = 0;
       a_Tok.Set(cmEND);
@@ -581,7 +634,7 @@ namespace mu
   bool ParserTokenReader::IsFunTok(token_type &a_Tok)
   {
     string_type strTok;
-    int iEnd = ExtractToken(m_pParser->ValidNameChars(), strTok, m_iPos);
+    int iEnd = ExtractName(strTok, m_iPos);
     if (iEnd==m_iPos)
       return false;
 
@@ -611,7 +664,6 @@ namespace mu
   */
   bool ParserTokenReader::IsOprt(token_type &a_Tok)
   {
-    const char_type *const szExpr = m_strFormula.c_str();
     string_type strTok;
 
     int iEnd = ExtractOperatorToken(strTok, m_iPos);
@@ -622,7 +674,7 @@ namespace mu
     const char_type **const pOprtDef = m_pParser->GetOprtDef();
     for (int i=0; m_pParser->HasBuiltInOprt() && pOprtDef[i]; ++i)
     {
-      if (string_type(pOprtDef[i])==strTok)
+      if (strTok==pOprtDef[i])
         return false;
     }
 
@@ -636,7 +688,7 @@ namespace mu
     for ( ; it!=m_pOprtDef->rend(); ++it)
     {
       const string_type &sID = it->first;
-      if ( sID == string_type(szExpr + m_iPos, szExpr + m_iPos + sID.length()) )
+      if ( m_strFormula.compare(m_iPos, sID.length(), sID)==0 )
       {
         a_Tok.Set(it->second, strTok);
 
@@ -732,7 +784,7 @@ namespace mu
     
     // 2.) Check for user defined constant
     // Read everything that could be a constant name
-    iEnd = ExtractToken(m_pParser->ValidNameChars(), strTok, m_iPos);
+    iEnd = ExtractName(strTok, m_iPos);
     if (iEnd!=m_iPos)
     {
       valmap_type::const_iterator item = m_pConstDef->find(strTok);
@@ -783,7 +835,7 @@ namespace mu
       return false;
 
     string_type strTok;
-    int iEnd = ExtractToken(m_pParser->ValidNameChars(), strTok, m_iPos);
+    int iEnd = ExtractName(strTok, m_iPos);
     if (iEnd==m_iPos)
       return false;
 
@@ -795,6 +847,7 @@ namespace mu
       Error(ecUNEXPECTED_VAR, m_iPos, strTok);
 
     m_pParser->OnDetectVar(&m_strFormula, m_iPos, iEnd);
+    m_iNamePos = -1;  // The formula may have been changed
 
     m_iPos = iEnd;
     a_Tok.SetVar(item->second, strTok);
@@ -814,7 +867,7 @@ namespace mu
       return false;
 
     string_type strTok;
-    int iEnd = ExtractToken(m_pParser->ValidNameChars(), strTok, m_iPos);
+    int iEnd = ExtractName(strTok, m_iPos);
     if (iEnd==m_iPos)
       return false;
 
@@ -846,7 +899,7 @@ namespace mu
   bool ParserTokenReader::IsUndefVarTok(token_type &a_Tok)
   {
     string_type strTok;
-    int iEnd( ExtractToken(m_pParser->ValidNameChars(), strTok, m_iPos) );
+    int iEnd( ExtractName(strTok, m_iPos) );
     if ( iEnd==m_iPos )
       return false;
 
@@ -887,6 +940,191 @@ namespace mu
     return true;
   }
 
+  //---------------------------------------------------------------------------
+  /** \brief Check whether a token at a given position is an array element.
+
+      Array elements are array names immediately followed by an opening square 
+      bracket, which is closed by a closing square bracket after the index. 
+      Both brackets are read here.
+
+      \param a_Tok [out] If an array element or a closing square bracket has been 
+                         found it will be placed here.
+      \return true if an array element or a closing square bracket has been found.
+  */
+  bool ParserTokenReader::IsArrayTok(token_type &a_Tok)
+  {
+    const char_type *szFormula = m_strFormula.c_str();
+
+    if (szFormula[m_iPos]==']')
+    {
+      if ( (m_iSynFlags & noBC) || m_sBrackets.empty() || m_sBrackets[m_sBrackets.size()-1]!='[' )
+        Error(ecUNEXPECTED_PARENS, m_iPos, _T("]"));
+
+      m_sBrackets.resize(m_sBrackets.size()-1);
+      m_iSynFlags = noBO | noVAR | noVAL | noFUN | noINFIXOP | noSTR | noASSIGN;
+      ++m_iPos;
+      a_Tok.Set(cmBC, _T("]"));
+      return true;
+    }
+
+    if (m_pArrDef->empty())
+      return false;
+
+    string_type strTok;
+    int iEnd = ExtractName(strTok, m_iPos);
+    if (iEnd==m_iPos || szFormula[iEnd]!='[')
+      return false;
+
+    arrmap_type::const_iterator item = m_pArrDef->find(strTok);
+    if (item==m_pArrDef->end())
+      return false;
+
+    if (m_iSynFlags & noVAR)
+      Error(ecUNEXPECTED_VAR, m_iPos, strTok);
+
+    m_iPos = iEnd + 1;
+    m_sBrackets += '[';
+    a_Tok.SetArray(&item->second, strTok);
+
+    m_iSynFlags = noBC | noOPT | noEND | noARG_SEP | noPOSTOP | noASSIGN | noIF | noELSE;
+    return true;
+  }
+
+  //---------------------------------------------------------------------------
+  /** \brief Check whether a token at a given position is a loop.
+
+      Loops are sums and products over a loop index such as "sum(i, 0, n, x[i])",
+      where the index runs from the lower bound up to, but excluding, the upper 
+      bound. The loop name, its opening bracket, the index and the following 
+      argument separator are read here. The index must not be a known name, so 
+      "sum(a, b)" with a variable a remains a function call.
+
+      \param a_Tok [out] If a loop has been found it will be placed here.
+      \return true if a loop has been found.
+  */
+  bool ParserTokenReader::IsLoopTok(token_type &a_Tok)
+  {
+    // Unknown names are variables if there is a variable factory
+    if (m_pFactory)
+      return false;
+
+    string_type strTok;
+    int iEnd = ExtractName(strTok, m_iPos);
+    if (iEnd==m_iPos)
+      return false;
+
+    ECmdCode iReduction;
+    if (strTok==_T("sum"))
+      iReduction = cmADD;
+    else if (strTok==_T("prod"))
+      iReduction = cmMUL;
+    else
+      return false;
+
+    const char_type *szFormula = m_strFormula.c_str();
+    if (szFormula[iEnd]!='(')
+      return false;
+
+    int iPos = iEnd + 1;
+    while (szFormula[iPos]>0 && szFormula[iPos]<=0x20) 
+      ++iPos;
+
+    string_type sIdx;
+    int iIdxEnd = ExtractName(sIdx, iPos);
+    if (iIdxEnd==iPos || (sIdx[0]>='0' && sIdx[0]<='9'))
+      return false;
+
+    while (szFormula[iIdxEnd]>0 && szFormula[iIdxEnd]<=0x20) 
+      ++iIdxEnd;
+
+    if (szFormula[iIdxEnd]!=m_cArgSep || IsKnownName(sIdx))
+      return false;
+
+    if (m_iSynFlags & noFUN)
+      Error(ecUNEXPECTED_FUN, m_iPos, strTok);
+
+    m_sBrackets += '(';
+
+    SLoopScope loop;
+    loop.sIdx = sIdx;
+    loop.iDepth = m_sBrackets.size();
+    loop.iArg = 1;
+    m_vLoops.push_back(loop);
+
+    m_iPos = iIdxEnd + 1;
+    a_Tok.SetLoop(cmLOOP, iReduction, strTok);
+
+    m_iSynFlags = noBC | noOPT | noEND | noARG_SEP | noPOSTOP | noASSIGN | noIF | noELSE;
+    return true;
+  }
+
+  //---------------------------------------------------------------------------
+  /** \brief Check whether a token at a given position is a loop index.
+
+      Loop indices are known in the body of their loop only.
+
+      \param a_Tok [out] If a loop index has been found it will be placed here.
+      \return true if a loop index has been found.
+  */
+  bool ParserTokenReader::IsLoopVarTok(token_type &a_Tok)
+  {
+    if (m_vLoops.empty())
+      return false;
+
+    string_type strTok;
+    int iEnd = ExtractName(strTok, m_iPos);
+    if (iEnd==m_iPos)
+      return false;
+
+    for (int i=(int)m_vLoops.size()-1; i>=0; --i)
+    {
+      if (m_vLoops[i].iArg<3 || m_vLoops[i].sIdx!=strTok)
+        continue;
+
+      if (m_iSynFlags & noVAR)
+        Error(ecUNEXPECTED_VAR, m_iPos, strTok);
+
+      // Loops are numbered by their bodies, a loop in bounds of another one 
+      // has its body started first.
+      int iLevel = 0;
+      for (int j=0; j<i; ++j)
+      {
+        if (m_vLoops[j].iArg>=3)
+          ++iLevel;
+      }
+
+      m_iPos = iEnd;
+      a_Tok.SetLoop(cmLOOPVAR, iLevel, strTok);
+
+      m_iSynFlags = noVAL | noVAR | noFUN | noBO | noINFIXOP | noSTR | noASSIGN;
+      return true;
+    }
+
+    return false;
+  }
+
+  //---------------------------------------------------------------------------
+  /** \brief Check whether a name is already used by a variable, constant, 
+             function or loop index.
+  */
+  bool ParserTokenReader::IsKnownName(const string_type &a_sName) const
+  {
+    if ( m_pVarDef->find(a_sName)!=m_pVarDef->end() ||
+         m_pArrDef->find(a_sName)!=m_pArrDef->end() ||
+         m_pConstDef->find(a_sName)!=m_pConstDef->end() ||
+         m_pStrVarDef->find(a_sName)!=m_pStrVarDef->end() ||
+         m_pFunDef->find(a_sName)!=m_pFunDef->end() )
+      return true;
+
+    for (std::size_t i=0; i<m_vLoops.size(); ++i)
+    {
+      if (m_vLoops[i].sIdx==a_sName)
+        return true;
+    }
+
+    return false;
+  }
+
 
   //---------------------------------------------------------------------------
   /** \brief Check wheter a token at a given position is a string.
@@ -0,0 +1,523 @@
+#include "muParserVecMath.h"
+
+// The kernels pick results of special arguments with conditional
+// expressions. If floating point operations may trap, GCC keeps the
+// operations on the taken branch only and the loops aren't vectorized.
+// The parser never unmasks floating point exceptions.
+#if defined(__GNUC__) && !defined(__clang__)
+  #pragma GCC optimize("no-trapping-math")
+#endif
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+// The kernels are compiled for AVX2 too, which has vectors twice as wide
+// as SSE2, the baseline of x86-64. The dynamic loader picks the version for
+// the CPU. AVX2 goes without FMA, so both versions give the same results.
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__) && defined(__ELF__)
+  #define MUP_VEC_CLONES __attribute__((target_clones("avx2", "default")))
+#else
+  #define MUP_VEC_CLONES
+#endif
+
+/** \file
+    \brief Implementation of the block kernels of the built-in functions.
+
+    Argument reductions and polynomials of the accurate kernels are the ones
+    of fdlibm (Sun Microsystems), which are within 1 ulp.
+*/
+
+namespace mu
+{
+  static_assert(sizeof(value_type)==sizeof(std::uint64_t) && std::numeric_limits<value_type>::is_iec559,
+                "block kernels need IEEE 754 double precision values");
+
+  namespace
+  {
+    //---------------------------------------------------------------------------
+    inline std::uint64_t AsBits(value_type a_fVal)
+    {
+      std::uint64_t iBits;
+      std::memcpy(&iBits, &a_fVal, sizeof(iBits));
+      return iBits;
+    }
+
+    //---------------------------------------------------------------------------
+    inline value_type AsValue(std::uint64_t a_iBits)
+    {
+      value_type fVal;
+      std::memcpy(&fVal, &a_iBits, sizeof(fVal));
+      return fVal;
+    }
+
+    // Adding 1.5*2^52 rounds a value below 2^51 to an integer, which is
+    // then stored in the low bits of the sum.
+    const value_type c_fShift = 6755399441055744.0;
+    const value_type c_fInf = std::numeric_limits<value_type>::infinity();
+    const value_type c_fNaN = std::numeric_limits<value_type>::quiet_NaN();
+
+    const value_type c_fLn2Hi  = 6.93147180369123816490e-01;
+    const value_type c_fLn2Lo  = 1.90821492927058770002e-10;
+    const value_type c_fInvLn2 = 1.44269504088896338700e+00;
+
+    //---------------------------------------------------------------------------
+    /** \brief Return the integer \a a_iK as a value, \a a_iK must be in [0, 2^52). */
+    inline value_type ToValue(std::uint64_t a_iK)
+    {
+      return AsValue(a_iK | AsBits(4503599627370496.0)) - 4503599627370496.0;
+    }
+
+    //---------------------------------------------------------------------------
+    // Exponential function
+
+    const value_type c_fExpMax = 7.09782712893383973096e+02;
+    const value_type c_fExpMin = -7.45133219101941108420e+02;
+
+    //---------------------------------------------------------------------------
+    /** \brief Return a_fY*2^k for the integer k=a_fK and fix results out of range.
+
+        2^k is applied as two factors, so both are normal numbers for any k
+        of arguments in range and the result is rounded once.
+    */
+    inline value_type ExpScale(value_type a_fY, value_type a_fK, value_type a_fArg)
+    {
+      value_type fK1 = (a_fK*0.5 + c_fShift) - c_fShift,
+                 fK2 = a_fK - fK1;
+      std::uint64_t iK1 = AsBits(fK1 + c_fShift) - AsBits(c_fShift),
+                    iK2 = AsBits(fK2 + c_fShift) - AsBits(c_fShift);
+
+      value_type fRes = a_fY * AsValue((iK1 + 1023) << 52) * AsValue((iK2 + 1023) << 52);
+      fRes = (a_fArg > c_fExpMax) ? c_fInf : fRes;
+      fRes = (a_fArg < c_fExpMin) ? 0 : fRes;
+      return (a_fArg==a_fArg) ? fRes : a_fArg;
+    }
+
+    //---------------------------------------------------------------------------
+    /** \brief Clamp exponent arguments, so that NaN and values out of range
+               don't overflow the integer part of the reduction. */
+    inline value_type ExpClamp(value_type a_fArg)
+    {
+      value_type fArg = (a_fArg < 710.0) ? a_fArg : 710.0;
+      return (fArg > -746.0) ? fArg : -746.0;
+    }
+
+    //---------------------------------------------------------------------------
+    inline value_type ExpAccurate(value_type a_fArg)
+    {
+      const value_type P1 =  1.66666666666666019037e-01,
+                       P2 = -2.77777777770155933842e-03,
+                       P3 =  6.61375632143793436117e-05,
+                       P4 = -1.65339022054652515390e-06,
+                       P5 =  4.13813679705723846039e-08;
+
+      value_type x  = ExpClamp(a_fArg),
+                 k  = (x*c_fInvLn2 + c_fShift) - c_fShift,
+                 hi = x - k*c_fLn2Hi,
+                 lo = k*c_fLn2Lo,
+                 r  = hi - lo,
+                 t  = r*r,
+                 c  = r - t*(P1 + t*(P2 + t*(P3 + t*(P4 + t*P5)))),
+                 y  = 1.0 - ((lo - (r*c)/(2.0 - c)) - hi);
+
+      return ExpScale(y, k, a_fArg);
+    }
+
+    //---------------------------------------------------------------------------
+    /** \brief Exponential function with a Taylor polynomial instead of the
+               rational approximation, so it needs no division.
+
+        The polynomial is evaluated by Estrin's scheme, which has shorter
+        chains of dependent operations than Horner's one.
+    */
+    inline value_type ExpFast(value_type a_fArg)
+    {
+      value_type x  = ExpClamp(a_fArg),
+                 k  = (x*c_fInvLn2 + c_fShift) - c_fShift,
+                 r  = (x - k*c_fLn2Hi) - k*c_fLn2Lo,
+                 r2 = r*r,
+                 r4 = r2*r2,
+                 r8 = r4*r4,
+                 p  = (1.0/2 + r*(1.0/6)) + r2*(1.0/24 + r*(1.0/120))
+                    + r4*((1.0/720 + r*(1.0/5040)) + r2*(1.0/40320 + r*(1.0/362880)))
+                    + r8*((1.0/3628800 + r*(1.0/39916800)) + r2*(1.0/479001600 + r*(1.0/6227020800.0)));
+
+      return ExpScale(1.0 + (r + r2*p), k, a_fArg);
+    }
+
+    //---------------------------------------------------------------------------
+    // Logarithms
+
+    /** \brief Split a_fArg into 2^a_fK*(1 + a_fF) with 1 + a_fF in [sqrt(2)/2, sqrt(2)).
+
+        \return log(1 + a_fF) - a_fF + a_fF^2/2, set a_fHfsq to a_fF^2/2.
+    */
+    inline value_type LogReduce(value_type a_fArg, value_type &a_fK, value_type &a_fF, value_type &a_fHfsq)
+    {
+      const value_type Lg1 = 6.666666666666735130e-01,
+                       Lg2 = 3.999999999940941908e-01,
+                       Lg3 = 2.857142874366239149e-01,
+                       Lg4 = 2.222219843214978396e-01,
+                       Lg5 = 1.818357216161805012e-01,
+                       Lg6 = 1.531383769920937332e-01,
+                       Lg7 = 1.479819860511658591e-01;
+
+      // Subnormal arguments are scaled by 2^54 first.
+      bool bSub = a_fArg < std::numeric_limits<value_type>::min();
+      value_type x = bSub ? a_fArg*18014398509481984.0 : a_fArg;
+
+      std::uint64_t iBits = AsBits(x),
+                    iK = (iBits + (AsBits(1.0) - AsBits(0.70710678118654752440))) >> 52;
+
+      a_fK = ToValue(iK) - (bSub ? 1077.0 : 1023.0);
+      a_fF = AsValue(iBits - (iK << 52) + AsBits(1.0)) - 1.0;
+
+      value_type s = a_fF/(2.0 + a_fF),
+                 z = s*s,
+                 w = z*z,
+                 t1 = w*(Lg2 + w*(Lg4 + w*Lg6)),
+                 t2 = z*(Lg1 + w*(Lg3 + w*(Lg5 + w*Lg7)));
+
+      a_fHfsq = 0.5*a_fF*a_fF;
+      return s*(a_fHfsq + t2 + t1);
+    }
+
+    //---------------------------------------------------------------------------
+    /** \brief Replace a_fRes by the logarithm of special arguments. */
+    inline value_type LogSpecial(value_type a_fArg, value_type a_fRes)
+    {
+      value_type fRes = (a_fArg==c_fInf) ? a_fArg : a_fRes;
+      fRes = (a_fArg==0) ? -c_fInf : fRes;
+      fRes = (a_fArg<0) ? c_fNaN : fRes;
+      return (a_fArg==a_fArg) ? fRes : a_fArg;
+    }
+
+    //---------------------------------------------------------------------------
+    /** \brief Split log(1 + a_fF) into a_fHi with 21 significant bits and a_fLo. */
+    inline void LogSplit(value_type a_fF, value_type a_fHfsq, value_type a_fR, value_type &a_fHi, value_type &a_fLo)
+    {
+      a_fHi = AsValue(AsBits(a_fF - a_fHfsq) & 0xffffffff00000000ULL);
+      a_fLo = (a_fF - a_fHi) - a_fHfsq + a_fR;
+    }
+
+    //---------------------------------------------------------------------------
+    inline value_type LnAccurate(value_type a_fArg)
+    {
+      value_type k, f, hfsq,
+                 r = LogReduce(a_fArg, k, f, hfsq);
+
+      return LogSpecial(a_fArg, k*c_fLn2Hi - ((hfsq - (r + k*c_fLn2Lo)) - f));
+    }
+
+    //---------------------------------------------------------------------------
+    inline value_type Log2Accurate(value_type a_fArg)
+    {
+      const value_type fInvLn2Hi = 1.44269504072144627571e+00,
+                       fInvLn2Lo = 1.67517131648865118353e-10;
+
+      value_type k, f, hfsq, hi, lo,
+                 r = LogReduce(a_fArg, k, f, hfsq);
+
+      LogSplit(f, hfsq, r, hi, lo);
+
+      value_type fValHi = hi*fInvLn2Hi,
+                 fValLo = (lo + hi)*fInvLn2Lo + lo*fInvLn2Hi,
+                 w = k + fValHi;
+
+      fValLo += (k - w) + fValHi;
+      return LogSpecial(a_fArg, fValLo + w);
+    }
+
+    //---------------------------------------------------------------------------
+    inline value_type Log10Accurate(value_type a_fArg)
+    {
+      const value_type fInvLn10Hi = 4.34294481878168880939e-01,
+                       fInvLn10Lo = 2.50829467116452752298e-11,
+                       fLog10_2Hi = 3.01029995663611771306e-01,
+                       fLog10_2Lo = 3.69423907715893078616e-13;
+
+      value_type k, f, hfsq, hi, lo,
+                 r = LogReduce(a_fArg, k, f, hfsq);
+
+      LogSplit(f, hfsq, r, hi, lo);
+
+      value_type fValHi = hi*fInvLn10Hi,
+                 y2 = k*fLog10_2Hi,
+                 fValLo = k*fLog10_2Lo + (lo + hi)*fInvLn10Lo + lo*fInvLn10Hi,
+                 w = y2 + fValHi;
+
+      fValLo += (y2 - w) + fValHi;
+      return LogSpecial(a_fArg, fValLo + w);
+    }
+
+    //---------------------------------------------------------------------------
+    // Sine and cosine
+
+    // Arguments are reduced by k*pi/2 with the integer k below 2^19,
+    // larger ones, infinities and NaN are left to the C library.
+    const value_type c_fTrigMax = 8.2354966e+05;
+    const value_type c_fInvPio2 = 6.36619772367581382433e-01;
+    const value_type c_fPio2_1  = 1.57079632673412561417e+00;   // first 33 bits of pi/2
+    const value_type c_fPio2_2  = 6.07710050630396597660e-11;   // second 33 bits of pi/2
+    const value_type c_fPio2_3  = 2.02226624871116645580e-21;   // third 33 bits of pi/2
+    const value_type c_fPio2_3t = 8.47842766036889956997e-32;   // pi/2 - (c_fPio2_1 + c_fPio2_2 + c_fPio2_3)
+
+    //---------------------------------------------------------------------------
+    /** \brief Return the quadrant of a_fArg and set a_fK to it. */
+    inline std::uint64_t Quadrant(value_type a_fArg, value_type &a_fK)
+    {
+      value_type fSum = a_fArg*c_fInvPio2 + c_fShift;
+
+      a_fK = fSum - c_fShift;
+      return AsBits(fSum) & 3;
+    }
+
+    //---------------------------------------------------------------------------
+    /** \brief Reduce a_fArg to a_fY + a_fYt in [-pi/4, pi/4].
+
+        Three rounds of fdlibm without its tests of cancellation, which
+        would be branches. The rounding errors of all rounds are kept in
+        the tail, so the rounds are good for any argument in range.
+    */
+    inline std::uint64_t ReduceAccurate(value_type a_fArg, value_type &a_fY, value_type &a_fYt)
+    {
+      value_type k;
+      std::uint64_t iQuad = Quadrant(a_fArg, k);
+
+      // Products of k and 33 bit parts of pi/2 are exact.
+      value_type t = a_fArg - k*c_fPio2_1,
+                 w = k*c_fPio2_2,
+                 r = t - w,
+                 e = (t - r) - w;
+
+      t = r;
+      w = k*c_fPio2_3;
+      r = t - w;
+      e += (t - r) - w;
+      w = k*c_fPio2_3t - e;
+
+      a_fY = r - w;
+      a_fYt = (r - a_fY) - w;
+      return iQuad;
+    }
+
+    //---------------------------------------------------------------------------
+    /** \brief Sine of x + y on [-pi/4, pi/4], y is the tail of x. */
+    inline value_type KernelSin(value_type x, value_type y)
+    {
+      const value_type S1 = -1.66666666666666324348e-01,
+                       S2 =  8.33333333332248946124e-03,
+                       S3 = -1.98412698298579493134e-04,
+                       S4 =  2.75573137070700676789e-06,
+                       S5 = -2.50507602534068634195e-08,
+                       S6 =  1.58969099521155010221e-10;
+
+      value_type z = x*x,
+                 w = z*z,
+                 r = S2 + z*(S3 + z*S4) + z*w*(S5 + z*S6),
+                 v = z*x;
+
+      return x - ((z*(0.5*y - v*r) - y) - v*S1);
+    }
+
+    //---------------------------------------------------------------------------
+    /** \brief Cosine of x + y on [-pi/4, pi/4], y is the tail of x. */
+    inline value_type KernelCos(value_type x, value_type y)
+    {
+      const value_type C1 =  4.16666666666666019037e-02,
+                       C2 = -1.38888888888741095749e-03,
+                       C3 =  2.48015872894767294178e-05,
+                       C4 = -2.75573143513906633035e-07,
+                       C5 =  2.08757232129817482790e-09,
+                       C6 = -1.13596475577881948265e-11;
+
+      value_type z  = x*x,
+                 w  = z*z,
+                 r  = z*(C1 + z*(C2 + z*C3)) + w*w*(C4 + z*(C5 + z*C6)),
+                 hz = 0.5*z,
+                 u  = 1.0 - hz;
+
+      return u + (((1.0 - u) - hz) + (z*r - x*y));
+    }
+
+    //---------------------------------------------------------------------------
+    /** \brief Pick sine or cosine of the reduced argument for quadrant a_iQuad. */
+    inline value_type SelectQuadrant(std::uint64_t a_iQuad, value_type a_fSin, value_type a_fCos)
+    {
+      // Bit masks, as 64 bit integer comparisons aren't vectorized on SSE2.
+      std::uint64_t iMask = 0 - (a_iQuad & 1);
+
+      return AsValue(((AsBits(a_fSin) & ~iMask) | (AsBits(a_fCos) & iMask)) ^ ((a_iQuad & 2) << 62));
+    }
+
+    //---------------------------------------------------------------------------
+    /** \brief Return true if all values can be reduced by the kernels. */
+    inline bool InTrigRange(const value_type *a_pVal, int a_iCount)
+    {
+      std::uint64_t iOut = 0;
+
+      for (int i=0; i<a_iCount; ++i)
+        iOut |= AsBits((std::fabs(a_pVal[i])<=c_fTrigMax) ? 0.0 : 1.0);
+
+      return iOut==0;
+    }
+  } // anonymous namespace
+
+  //---------------------------------------------------------------------------
+  MUP_VEC_CLONES
+  void ParserVecMath::Sin(value_type *a_pVal, int a_iCount, EMathAccuracy a_eAccuracy)
+  {
+    if (!InTrigRange(a_pVal, a_iCount))
+    {
+      for (int i=0; i<a_iCount; ++i)
+        a_pVal[i] = std::sin(a_pVal[i]);
+    }
+    else if (a_eAccuracy==maULP1)
+    {
+      MUP_SIMD
+      for (int i=0; i<a_iCount; ++i)
+      {
+        value_type y, yt;
+        std::uint64_t iQuad = ReduceAccurate(a_pVal[i], y, yt);
+        a_pVal[i] = SelectQuadrant(iQuad, KernelSin(y, yt), KernelCos(y, yt));
+      }
+    }
+    else
+    {
+      // The tail of the reduced argument is dropped.
+      MUP_SIMD
+      for (int i=0; i<a_iCount; ++i)
+      {
+        value_type y, yt;
+        std::uint64_t iQuad = ReduceAccurate(a_pVal[i], y, yt);
+        a_pVal[i] = SelectQuadrant(iQuad, KernelSin(y, 0), KernelCos(y, 0));
+      }
+    }
+  }
+
+  //---------------------------------------------------------------------------
+  MUP_VEC_CLONES
+  void ParserVecMath::Cos(value_type *a_pVal, int a_iCount, EMathAccuracy a_eAccuracy)
+  {
+    if (!InTrigRange(a_pVal, a_iCount))
+    {
+      for (int i=0; i<a_iCount; ++i)
+        a_pVal[i] = std::cos(a_pVal[i]);
+    }
+    else if (a_eAccuracy==maULP1)
+    {
+      MUP_SIMD
+      for (int i=0; i<a_iCount; ++i)
+      {
+        value_type y, yt;
+        std::uint64_t iQuad = ReduceAccurate(a_pVal[i], y, yt) + 1;
+        a_pVal[i] = SelectQuadrant(iQuad, KernelSin(y, yt), KernelCos(y, yt));
+      }
+    }
+    else
+    {
+      // The tail of the reduced argument is dropped.
+      MUP_SIMD
+      for (int i=0; i<a_iCount; ++i)
+      {
+        value_type y, yt;
+        std::uint64_t iQuad = ReduceAccurate(a_pVal[i], y, yt) + 1;
+        a_pVal[i] = SelectQuadrant(iQuad, KernelSin(y, 0), KernelCos(y, 0));
+      }
+    }
+  }
+
+  //---------------------------------------------------------------------------
+  MUP_VEC_CLONES
+  void ParserVecMath::Exp(value_type *a_pVal, int a_iCount, EMathAccuracy a_eAccuracy)
+  {
+    if (a_eAccuracy==maULP1)
+    {
+      MUP_SIMD
+      for (int i=0; i<a_iCount; ++i)
+        a_pVal[i] = ExpAccurate(a_pVal[i]);
+    }
+    else
+    {
+      MUP_SIMD
+      for (int i=0; i<a_iCount; ++i)
+        a_pVal[i] = ExpFast(a_pVal[i]);
+    }
+  }
+
+  //---------------------------------------------------------------------------
+  MUP_VEC_CLONES
+  void ParserVecMath::Ln(value_type *a_pVal, int a_iCount, EMathAccuracy /*a_eAccuracy*/)
+  {
+    MUP_SIMD
+    for (int i=0; i<a_iCount; ++i)
+      a_pVal[i] = LnAccurate(a_pVal[i]);
+  }
+
+  //---------------------------------------------------------------------------
+  /** \brief Logarithm base 2.
+
+      The fast mode scales the natural logarithm, which adds a rounding.
+  */
+  MUP_VEC_CLONES
+  void ParserVecMath::Log2(value_type *a_pVal, int a_iCount, EMathAccuracy a_eAccuracy)
+  {
+    if (a_eAccuracy==maULP1)
+    {
+      MUP_SIMD
+      for (int i=0; i<a_iCount; ++i)
+        a_pVal[i] = Log2Accurate(a_pVal[i]);
+    }
+    else
+    {
+      MUP_SIMD
+      for (int i=0; i<a_iCount; ++i)
+        a_pVal[i] = LnAccurate(a_pVal[i])*c_fInvLn2;
+    }
+  }
+
+  //---------------------------------------------------------------------------
+  /** \brief Logarithm base 10, see Log2(). */
+  MUP_VEC_CLONES
+  void ParserVecMath::Log10(value_type *a_pVal, int a_iCount, EMathAccuracy a_eAccuracy)
+  {
+    if (a_eAccuracy==maULP1)
+    {
+      MUP_SIMD
+      for (int i=0; i<a_iCount; ++i)
+        a_pVal[i] = Log10Accurate(a_pVal[i]);
+    }
+    else
+    {
+      const value_type fInvLn10 = 4.34294481903251827651e-01;
+
+      MUP_SIMD
+      for (int i=0; i<a_iCount; ++i)
+        a_pVal[i] = LnAccurate(a_pVal[i])*fInvLn10;
+    }
+  }
+
+  //---------------------------------------------------------------------------
+  /** \brief Square root, it's correctly rounded.
+
+      Unless errno is disabled by the build, the compiler keeps the check of
+      negative arguments and the loop isn't vectorized.
+  */
+  MUP_VEC_CLONES
+  void ParserVecMath::Sqrt(value_type *a_pVal, int a_iCount, EMathAccuracy /*a_eAccuracy*/)
+  {
+    for (int i=0; i<a_iCount; ++i)
+      a_pVal[i] = std::sqrt(a_pVal[i]);
+  }
+
+  //---------------------------------------------------------------------------
+  MUP_VEC_CLONES
+  void ParserVecMath::Abs(value_type *a_pVal, int a_iCount, EMathAccuracy /*a_eAccuracy*/)
+  {
+    MUP_SIMD
+    for (int i=0; i<a_iCount; ++i)
+      a_pVal[i] = std::fabs(a_pVal[i]);
+  }
+
+} // namespace mu
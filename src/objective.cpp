@@ -0,0 +1,64 @@
+#include "objective.hpp"
+#include "tools.hpp"
+
+/*
+ * Returns value of function at @x, reusing cached one if @x is the last point.
+ */
+double Objective::value(const std::vector<double>& x)
+{
+    move_to(x);
+
+    if (!mHasValue)
+    {
+        mValue = mFunction(x);
+        mHasValue = true;
+    }
+
+    return mValue;
+}
+
+/*
+ * Saves gradient of function at @x to @g, reusing cached one if @x is
+ * the last point.
+ */
+void Objective::gradient(const std::vector<double>& x, std::vector<double>& g)
+{
+    value_and_gradient(x, g);
+}
+
+/*
+ * Returns value of function at @x and saves its gradient to @g.
+ * Value at @x is computed once and shared by all finite differences.
+ */
+double Objective::value_and_gradient(const std::vector<double>& x,
+                                     std::vector<double>& g)
+{
+    double fx = value(x);
+
+    if (!mHasGradient)
+    {
+        Tools::find_gradient(mFunction, x, fx, mGradient, mWorkspace);
+        mHasGradient = true;
+    }
+
+    g = mGradient;
+
+    return fx;
+}
+
+/*
+ * Drops cached point.
+ */
+void Objective::reset()
+{
+    mHasValue = mHasGradient = false;
+}
+
+void Objective::move_to(const std::vector<double>& x)
+{
+    if ((mHasValue || mHasGradient) && mPoint == x)
+        return;
+
+    mPoint = x;
+    mHasValue = mHasGradient = false;
+}
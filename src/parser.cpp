@@ -1,33 +1,337 @@
-#include <QString>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <list>
+#include <unordered_map>
+#include <utility>
 
+#include "analysis.hpp"
+#include "incremental.hpp"
 #include "parser.hpp"
 #include "tools.hpp"
 
-mu::Parser Parser::sParser;
+/*
+ * Returns parser with built-in functions, operators and constants, which
+ * are defined once. Symbol tables of its copies share them, so each thread
+ * gets its parsers cheaply.
+ */
+static const mu::Parser& prototype_parser()
+{
+    static const mu::Parser sPrototype;
+
+    return sPrototype;
+}
+
+thread_local mu::Parser Parser::sParser(prototype_parser());
+thread_local mu::Parser Parser::sBulkParser(prototype_parser());
+
+thread_local std::vector<mu::Parser> Parser::sResidualParsers;
+
+thread_local mu::Parser Parser::sConstraintsParser(prototype_parser());
+
+thread_local std::vector<double> Parser::sVariables;
+thread_local std::vector<double> Parser::sPosition;
+thread_local std::vector<double> Parser::sDirection;
+
+thread_local std::vector<double> Parser::sBulkVariables;
+
+/*
+ * Bytecode of function compiled for variables starting at @variables.
+ */
+struct CompiledFunction
+{
+    std::string key;
+    mu::ParserByteCode byteCode;
+    int resultsCount;
+    const double* variables;
+};
+
+// Compiled functions from the most to the least recently used one.
+static thread_local std::list<CompiledFunction> sCache;
+static thread_local std::unordered_map<
+        std::string, std::list<CompiledFunction>::iterator> sCacheIndex;
+
+static std::atomic<unsigned long> sCacheHits(0);
+static std::atomic<unsigned long> sCacheMisses(0);
+
+// Evaluator of function of parser at points differing in few coordinates.
+static thread_local IncrementalEvaluator sIncremental;
+
+// Degree along the last line, which depends only on its moving coordinates.
+static thread_local std::vector<char> sLineMoving;
+static thread_local int sLineDegree = Analysis::NOT_POLYNOMIAL;
+
+/*
+ * Returns @text as string of muParser, which is wide when it is built
+ * with _UNICODE.
+ */
+static mu::string_type to_parser_string(const std::string& text)
+{
+    return mu::string_type(text.begin(), text.end());
+}
+
+static mu::string_type variable_name(unsigned idx)
+{
+    mu::stringstream_type stream;
+
+    stream << _T("x") << idx;
+
+    return stream.str();
+}
+
+/*
+ * Defines @variablesCount variables of @parser stored @stride values apart
+ * starting at @variables, both as x0, x1, ... and as elements of array x.
+ * Constant n is number of variables, so sum(i, 0, n, x[i]) sums all of them.
+ */
+static void define_variables(mu::Parser& parser, double* variables,
+                             unsigned variablesCount, unsigned stride)
+{
+    std::vector<std::pair<mu::string_type, unsigned>> names(variablesCount);
+
+    for (unsigned idx = 0; idx < variablesCount; ++idx)
+        names[idx] = std::make_pair(variable_name(idx), idx);
+
+    // Symbol table is sorted, so sorted names are appended to its end
+    // instead of being inserted in the middle one by one.
+    std::sort(names.begin(), names.end());
+
+    parser.ClearVar();
+    for (const auto& name : names)
+        parser.DefineVar(name.first, variables + name.second * stride);
+
+    if (variablesCount > 0)
+        parser.DefineArray(_T("x"), variables, variablesCount, stride);
+    parser.DefineConst(_T("n"), variablesCount);
+}
+
+/*
+ * Returns true if @c is a token of its own, which never merges with
+ * neighbouring characters.
+ */
+static bool is_separator(char c)
+{
+    return c == '(' || c == ')' || c == ',';
+}
+
+/*
+ * Returns key of cache for @expression of @variablesCount variables.
+ * Runs of whitespace are collapsed to single space and dropped next to
+ * brackets and commas, so expressions differing there only share compiled
+ * bytecode. Elsewhere dropping it could merge two tokens, as in "< =" or
+ * "1e -3", so it is kept. Strings are kept as they are.
+ */
+static std::string find_cache_key(const std::string& expression,
+                                  unsigned variablesCount)
+{
+    std::string key;
+    bool space = false, string = false;
+
+    for (unsigned idx = 0; idx < expression.size(); ++idx)
+    {
+        char c = expression[idx];
+
+        if (string)
+        {
+            key += c;
+
+            if (c == '\\' && idx + 1 < expression.size())
+                key += expression[++idx];
+            else if (c == '"')
+                string = false;
+
+            continue;
+        }
+
+        if (std::isspace(static_cast<unsigned char>(c)))
+        {
+            space = true;
+            continue;
+        }
+
+        if (space && !key.empty() && !is_separator(key.back()) &&
+            !is_separator(c))
+            key += ' ';
+        key += c;
+        space = false;
+        string = c == '"';
+    }
+
+    return key + '\n' + std::to_string(variablesCount);
+}
+
+/*
+ * Sets bytecode of function with @key to parser if it is cached and makes
+ * it the most recently used one.
+ */
+static bool restore_compiled(const std::string& key)
+{
+    auto found = sCacheIndex.find(key);
+    if (found == sCacheIndex.end())
+        return false;
+
+    sCache.splice(sCache.begin(), sCache, found->second);
+
+    CompiledFunction& compiled = sCache.front();
+    mu::ParserByteCode byteCode(compiled.byteCode);
+
+    byteCode.RebaseVar(compiled.variables, Parser::sVariables.data(),
+                       Parser::sVariables.size());
+    Parser::sParser.SetByteCode(byteCode, compiled.resultsCount);
 
-std::vector<double> Parser::sVariables;
-std::vector<double> Parser::sPosition;
-std::vector<double> Parser::sDirection;
+    return true;
+}
+
+/*
+ * Compiles function of parser and caches its bytecode with @key, evicting
+ * the least recently used one when cache is full. Expression which can't
+ * be compiled isn't cached, so its error is reported on evaluation.
+ */
+static void store_compiled(const std::string& key)
+{
+    CompiledFunction compiled;
+
+    try
+    {
+        compiled.byteCode = Parser::sParser.GetByteCode();
+    }
+    catch (mu::Parser::exception_type&)
+    {
+        return;
+    }
+
+    compiled.key = key;
+    compiled.resultsCount = Parser::sParser.GetNumResults();
+    compiled.variables = Parser::sVariables.data();
+
+    if (sCache.size() >= Parser::CACHE_CAPACITY)
+    {
+        sCacheIndex.erase(sCache.back().key);
+        sCache.pop_back();
+    }
+
+    sCache.push_front(compiled);
+    sCacheIndex[key] = sCache.begin();
+}
 
-void Parser::configureParser(const std::wstring& expression,
+/*
+ * Configures parser for function given by @expression. Bytecode of
+ * recently configured functions is reused instead of compiling them again.
+ */
+void Parser::configureParser(const std::string& expression,
                              unsigned variablesCount)
 {
-    sParser.SetExpr(expression);
+    sParser.SetExpr(to_parser_string(expression));
 
     sVariables = std::vector<double>(variablesCount);
     sPosition = std::vector<double>(variablesCount);
     sDirection = std::vector<double>(variablesCount);
 
-    sParser.ClearVar();
-    for (unsigned idx = 0; idx < variablesCount; ++idx)
-        sParser.DefineVar((QString("x%1").arg(idx)).toStdWString(),
-                          &sVariables[idx]);
+    define_variables(sParser, sVariables.data(), variablesCount, 1);
+
+    std::string key = find_cache_key(expression, variablesCount);
+    if (restore_compiled(key))
+    {
+        ++sCacheHits;
+    }
+    else
+    {
+        ++sCacheMisses;
+        store_compiled(key);
+    }
+
+    try
+    {
+        sIncremental.configure(sParser, sVariables.data(), variablesCount);
+    }
+    catch (mu::Parser::exception_type&)
+    {
+        // Left unsupported, parser reports the error on evaluation.
+    }
+
+    sLineMoving.clear();
+
+    // Variables of bulk parser are bound on the first batch.
+    sBulkParser.SetExpr(to_parser_string(expression));
+    sBulkParser.ClearVar();
+    sBulkVariables.clear();
+
+    sResidualParsers.clear();
+    sConstraintsParser.ClearVar();
+}
+
+/*
+ * Configures parser for least squares problem with @residuals, so function
+ * is sum of their squares and each residual may be evaluated by its own.
+ */
+void Parser::configureResiduals(const std::vector<std::string>& residuals,
+                                unsigned variablesCount)
+{
+    std::string expression;
+
+    for (unsigned idx = 0; idx < residuals.size(); ++idx)
+    {
+        if (idx > 0)
+            expression += " + ";
+        expression += "(" + residuals[idx] + ")^2";
+    }
+
+    configureParser(expression.empty() ? "0" : expression, variablesCount);
+
+    sResidualParsers = std::vector<mu::Parser>(residuals.size(),
+                                               prototype_parser());
+    for (unsigned idx = 0; idx < residuals.size(); ++idx)
+        sResidualParsers[idx].SetExpr(to_parser_string(residuals[idx]));
+}
+
+/*
+ * Configures parser for function given by @expression subject to
+ * @equalities, which are zero, and @inequalities, which are nonpositive.
+ * Function and constraints are compiled together, so they share
+ * a single evaluation.
+ */
+void Parser::configureConstraints(const std::string& expression,
+                                  const std::vector<std::string>& equalities,
+                                  const std::vector<std::string>& inequalities,
+                                  unsigned variablesCount)
+{
+    configureParser(expression, variablesCount);
+
+    std::string constrained = expression;
+    for (const std::string& equality : equalities)
+        constrained += ", " + equality;
+    for (const std::string& inequality : inequalities)
+        constrained += ", " + inequality;
+
+    sConstraintsParser.SetExpr(to_parser_string(constrained));
+    define_variables(sConstraintsParser, sVariables.data(), variablesCount, 1);
+}
+
+/*
+ * Returns value of function at variables. Only parts of function depending
+ * on variables changed since the previous evaluation are computed again,
+ * so moving along an axis costs the terms with its coordinate.
+ */
+static double evaluate_function()
+{
+    if (sIncremental.isSupported())
+        return sIncremental.evaluate(Parser::sVariables);
+
+    return Parser::sParser.Eval();
 }
 
+/*
+ * Returns value of function at @alpha along direction from position and
+ * leaves the point in variables. Terms not depending on @alpha are computed
+ * once per line.
+ */
 double Parser::evaluateFunctionMono(const double alpha)
 {
     Tools::convert_dimensions(alpha, sPosition, sDirection, sVariables);
 
+    if (sIncremental.isSupported())
+        return sIncremental.evaluateLine(sPosition, sDirection, alpha);
+
     return sParser.Eval();
 }
 
@@ -37,5 +341,166 @@ double Parser::evaluateFunctionMulti(const std::vector<double>& x)
     for (unsigned idx = 0; idx < x.size(); ++idx)
         sVariables[idx] = x[idx];
 
-    return sParser.Eval();
+    return evaluate_function();
+}
+
+/*
+ * Saves value of function at @x followed by values of its equality and
+ * inequality constraints to @values.
+ */
+void Parser::evaluateConstrained(const std::vector<double>& x,
+                                 std::vector<double>& values)
+{
+    for (unsigned idx = 0; idx < x.size(); ++idx)
+        sVariables[idx] = x[idx];
+
+    int count;
+    double* results = sConstraintsParser.Eval(count);
+
+    values.assign(results, results + count);
+}
+
+/*
+ * Saves values of function at each of @points to @values with single
+ * bulk evaluation of parser, which spreads points over threads when
+ * parser is built with OpenMP.
+ */
+void Parser::evaluateFunctionBatch(
+        const std::vector<std::vector<double>>& points,
+        std::vector<double>& values)
+{
+    evaluateBatch(points, values, mu::maULP1);
+}
+
+/*
+ * Same as evaluateFunctionBatch(), but evaluates in single precision, so
+ * values have about 7 significant digits. Good enough to rank points far
+ * from each other, as in sampling and bracketing phases of search.
+ */
+void Parser::evaluateFunctionBatchCoarse(
+        const std::vector<std::vector<double>>& points,
+        std::vector<double>& values)
+{
+    evaluateBatch(points, values, mu::maSingle);
+}
+
+void Parser::evaluateBatch(const std::vector<std::vector<double>>& points,
+                           std::vector<double>& values,
+                           mu::EMathAccuracy accuracy)
+{
+    unsigned pointsCount = points.size();
+
+    values.resize(pointsCount);
+    if (pointsCount == 0)
+        return;
+
+    bindBulkVariables(points);
+    sBulkParser.SetMathAccuracy(accuracy);
+    sBulkParser.Eval(values.data(), pointsCount);
+}
+
+/*
+ * Saves residuals at each of @points to @values, so @values[i][j] is
+ * j-th residual at i-th point. Every residual is a single bulk evaluation.
+ */
+void Parser::evaluateResidualsBatch(
+        const std::vector<std::vector<double>>& points,
+        std::vector<std::vector<double>>& values)
+{
+    unsigned pointsCount = points.size(),
+            residualsCount = sResidualParsers.size();
+    std::vector<double> column(pointsCount);
+
+    values.resize(pointsCount);
+    for (unsigned point = 0; point < pointsCount; ++point)
+        values[point].resize(residualsCount);
+
+    if (pointsCount == 0)
+        return;
+
+    bindBulkVariables(points);
+
+    for (unsigned residual = 0; residual < residualsCount; ++residual)
+    {
+        sResidualParsers[residual].Eval(column.data(), pointsCount);
+
+        for (unsigned point = 0; point < pointsCount; ++point)
+            values[point][residual] = column[point];
+    }
+}
+
+std::vector<std::vector<int>> Parser::findHessianPattern()
+{
+    return Analysis::find_hessian_pattern(sParser, sVariables.data(),
+                                          sVariables.size());
+}
+
+/*
+ * Returns degree of function as polynomial of alpha along direction, or
+ * Analysis::NOT_POLYNOMIAL. Bytecode is analyzed again only when other
+ * coordinates move than along the previous line.
+ */
+int Parser::findLineDegree()
+{
+    if (sDirection.size() != sVariables.size())
+        return Analysis::NOT_POLYNOMIAL;
+
+    bool isSameLine = sLineMoving.size() == sDirection.size();
+    for (unsigned idx = 0; idx < sDirection.size() && isSameLine; ++idx)
+        isSameLine = sLineMoving[idx] == (sDirection[idx] != 0.0);
+
+    if (isSameLine)
+        return sLineDegree;
+
+    sLineMoving.resize(sDirection.size());
+    for (unsigned idx = 0; idx < sDirection.size(); ++idx)
+        sLineMoving[idx] = sDirection[idx] != 0.0;
+
+    sLineDegree = Analysis::find_line_degree(sParser, sVariables.data(),
+                                             sVariables.size(), sDirection);
+
+    return sLineDegree;
+}
+
+/*
+ * Returns number of functions configured with cached bytecode by all threads.
+ */
+unsigned long Parser::getCacheHits()
+{
+    return sCacheHits;
+}
+
+/*
+ * Returns number of functions compiled by all threads.
+ */
+unsigned long Parser::getCacheMisses()
+{
+    return sCacheMisses;
+}
+
+/*
+ * Copies @points to variables of bulk parsers, growing them if needed.
+ */
+void Parser::bindBulkVariables(const std::vector<std::vector<double>>& points)
+{
+    unsigned pointsCount = points.size(), variablesCount = sVariables.size();
+
+    // Bulk mode reads i-th point from i-th element after variable address,
+    // so each variable owns a row of capacity elements.
+    if (sBulkVariables.size() < pointsCount * variablesCount)
+    {
+        sBulkVariables.resize(pointsCount * variablesCount);
+
+        define_variables(sBulkParser, sBulkVariables.data(), variablesCount,
+                         pointsCount);
+        for (mu::Parser& parser : sResidualParsers)
+            define_variables(parser, sBulkVariables.data(), variablesCount,
+                             pointsCount);
+    }
+
+    unsigned capacity = variablesCount > 0 ?
+                sBulkVariables.size() / variablesCount : 0;
+    for (unsigned point = 0; point < pointsCount; ++point)
+        for (unsigned idx = 0; idx < variablesCount; ++idx)
+            sBulkVariables[idx * capacity + point] = points[point][idx];
 }
@@ -1,5 +1,4 @@
-#include <QString>
-#include <QStringBuilder>
+#include <cstdio>
 
 #include "result.hpp"
 
@@ -23,6 +22,46 @@ void Result::setAccelerationItrs(int iterations)
     mAccelerationItrs = iterations;
 }
 
+int Result::getAcceptedSteps() const
+{
+    return mAcceptedSteps;
+}
+
+void Result::setAcceptedSteps(int steps)
+{
+    mAcceptedSteps = steps;
+}
+
+int Result::getRejectedSteps() const
+{
+    return mRejectedSteps;
+}
+
+void Result::setRejectedSteps(int steps)
+{
+    mRejectedSteps = steps;
+}
+
+int Result::getGenerations() const
+{
+    return mGenerations;
+}
+
+void Result::setGenerations(int generations)
+{
+    mGenerations = generations;
+}
+
+int Result::getEvaluations() const
+{
+    return mEvaluations;
+}
+
+void Result::setEvaluations(int evaluations)
+{
+    mEvaluations = evaluations;
+}
+
 std::vector<double> Result::getVector() const
 {
     return mVector;
@@ -33,23 +72,63 @@ void Result::setVector(const std::vector<double>& vector)
     mVector = vector;
 }
 
-QString Result::getMessage() const
+/*
+ * Returns @value with 12 significant digits.
+ */
+static std::string format_number(double value)
+{
+    char buffer[32];
+
+    snprintf(buffer, sizeof(buffer), "%.12g", value);
+
+    return buffer;
+}
+
+std::string Result::getMessage() const
 {
-    QString message;
+    std::string message;
 
     message.append("Result:\n");
 
     if (mNormalItrs > 0)
     {
         message.append("* Normal iterations: ");
-        message.append(QString::number(mNormalItrs));
+        message.append(std::to_string(mNormalItrs));
         message.append("\n");
     }
 
     if (mAccelerationItrs > 0)
     {
         message.append("* Acceleration iterations: ");
-        message.append(QString::number(mAccelerationItrs));
+        message.append(std::to_string(mAccelerationItrs));
+        message.append("\n");
+    }
+
+    if (mAcceptedSteps >= 0)
+    {
+        message.append("* Accepted steps: ");
+        message.append(std::to_string(mAcceptedSteps));
+        message.append("\n");
+    }
+
+    if (mRejectedSteps >= 0)
+    {
+        message.append("* Rejected steps: ");
+        message.append(std::to_string(mRejectedSteps));
+        message.append("\n");
+    }
+
+    if (mGenerations >= 0)
+    {
+        message.append("* Generations: ");
+        message.append(std::to_string(mGenerations));
+        message.append("\n");
+    }
+
+    if (mEvaluations >= 0)
+    {
+        message.append("* Evaluations: ");
+        message.append(std::to_string(mEvaluations));
         message.append("\n");
     }
 
@@ -59,11 +138,10 @@ QString Result::getMessage() const
         message.append("* Vector: { ");
 
         for (unsigned idx = 0; idx < vectorCount - 1; ++idx)
-            message.append(QString::number(mVector[idx], 'g', 12) + QString("; "));
+            message.append(format_number(mVector[idx]) + "; ");
 
-        message.append(QString::number(mVector[vectorCount - 1], 'g', 12) +
-                QString(" }"));
+        message.append(format_number(mVector[vectorCount - 1]) + " }");
     }
 
-    return std::move(message);
+    return message;
 }
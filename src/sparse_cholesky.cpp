@@ -0,0 +1,205 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <set>
+
+#include "sparse_cholesky.hpp"
+
+/*
+ * Orders rows of symmetric @pattern by minimum degree and builds
+ * pattern of factor by eliminating them in that order.
+ */
+sparse_cholesky::sparse_cholesky(const std::vector<std::vector<int>>& pattern) :
+    m_size(pattern.size()),
+    m_permutation(pattern.size()),
+    m_order(pattern.size()),
+    m_col_offsets(pattern.size() + 1, 0),
+    m_rows(pattern.size()),
+    m_work(pattern.size(), 0.0),
+    m_is_modified(false)
+{
+    std::vector<std::set<int>> graph(m_size);
+    std::set<std::pair<int, int>> queue;
+    std::vector<std::vector<int>> columns(m_size);
+
+    for (int row = 0; row < m_size; ++row)
+    {
+        for (int col : pattern[row])
+            if (col != row)
+            {
+                graph[row].insert(col);
+                graph[col].insert(row);
+            }
+    }
+
+    for (int row = 0; row < m_size; ++row)
+        queue.insert(std::make_pair((int)graph[row].size(), row));
+
+    // Eliminated node makes clique of its neighbours, which is fill of L.
+    for (int step = 0; step < m_size; ++step)
+    {
+        int node = queue.begin()->second;
+        queue.erase(queue.begin());
+
+        m_permutation[step] = node;
+        m_order[node] = step;
+        columns[step].assign(graph[node].begin(), graph[node].end());
+
+        for (int neighbour : columns[step])
+        {
+            queue.erase(std::make_pair((int)graph[neighbour].size(), neighbour));
+
+            graph[neighbour].erase(node);
+            for (int other : columns[step])
+                if (other != neighbour)
+                    graph[neighbour].insert(other);
+
+            queue.insert(std::make_pair((int)graph[neighbour].size(), neighbour));
+        }
+
+        graph[node].clear();
+    }
+
+    for (int col = 0; col < m_size; ++col)
+    {
+        for (int& row : columns[col])
+            row = m_order[row];
+        std::sort(columns[col].begin(), columns[col].end());
+
+        m_col_offsets[col + 1] = m_col_offsets[col] + columns[col].size() + 1;
+    }
+
+    m_row_indices.resize(m_col_offsets[m_size]);
+    m_values.resize(m_col_offsets[m_size]);
+
+    for (int col = 0; col < m_size; ++col)
+    {
+        int position = m_col_offsets[col];
+
+        m_row_indices[position++] = col;
+        for (int row : columns[col])
+        {
+            m_rows[row].push_back(std::make_pair(col, position));
+            m_row_indices[position++] = row;
+        }
+    }
+}
+
+/*
+ * Factorizes @a, which must have pattern given at construction.
+ * Returns true if diagonal of @a had to be increased.
+ */
+bool sparse_cholesky::factorize(const sparse_matrix& a)
+{
+    double machineEpsilon = std::numeric_limits<double>::epsilon();
+    double gamma = 0.0, xi = 0.0;
+
+    for (int row = 0; row < m_size; ++row)
+        for (int idx = a.m_row_offsets[row]; idx < a.m_row_offsets[row + 1]; ++idx)
+            if (a.m_col_indices[idx] == row)
+                gamma = std::max(gamma, fabs(a.m_values[idx]));
+            else
+                xi = std::max(xi, fabs(a.m_values[idx]));
+
+    // Bounds of Gill and Murray keep L and shift of diagonal moderate.
+    double betaSquared = std::max(std::max(gamma, machineEpsilon),
+            (m_size > 1) ? xi / sqrt((double)m_size * m_size - 1.0) : 0.0);
+    double delta = machineEpsilon * std::max(gamma + xi, 1.0);
+
+    m_is_modified = false;
+
+    for (int col = 0; col < m_size; ++col)
+    {
+        // Scatter lower part of column of A.
+        int original = m_permutation[col];
+        for (int idx = a.m_row_offsets[original];
+             idx < a.m_row_offsets[original + 1]; ++idx)
+        {
+            int row = m_order[a.m_col_indices[idx]];
+
+            if (row >= col)
+                m_work[row] = a.m_values[idx];
+        }
+
+        // Subtract contributions of previous columns with nonzero in this row.
+        for (const std::pair<int, int>& entry : m_rows[col])
+        {
+            double factor = m_values[entry.second];
+
+            for (int idx = entry.second; idx < m_col_offsets[entry.first + 1]; ++idx)
+                m_work[m_row_indices[idx]] -= m_values[idx] * factor;
+        }
+
+        double theta = 0.0;
+        for (int idx = m_col_offsets[col] + 1; idx < m_col_offsets[col + 1]; ++idx)
+            theta = std::max(theta, fabs(m_work[m_row_indices[idx]]));
+
+        double pivot = std::max(std::max(fabs(m_work[col]), delta),
+                                theta * theta / betaSquared);
+        if (pivot != m_work[col])
+            m_is_modified = true;
+
+        double diagonal = sqrt(pivot);
+        for (int idx = m_col_offsets[col]; idx < m_col_offsets[col + 1]; ++idx)
+        {
+            m_values[idx] = m_work[m_row_indices[idx]] / diagonal;
+            m_work[m_row_indices[idx]] = 0.0;
+        }
+        m_values[m_col_offsets[col]] = diagonal;
+    }
+
+    return m_is_modified;
+}
+
+/*
+ * Solves (A + E) @x = @b with last factorization.
+ */
+void sparse_cholesky::solve(const std::vector<double>& b, std::vector<double>& x)
+{
+    for (int idx = 0; idx < m_size; ++idx)
+        m_work[idx] = b[m_permutation[idx]];
+
+    // Forward substitution with L.
+    for (int col = 0; col < m_size; ++col)
+    {
+        m_work[col] /= m_values[m_col_offsets[col]];
+
+        for (int idx = m_col_offsets[col] + 1; idx < m_col_offsets[col + 1]; ++idx)
+            m_work[m_row_indices[idx]] -= m_values[idx] * m_work[col];
+    }
+
+    // Backward substitution with transposed L.
+    for (int col = m_size - 1; col >= 0; --col)
+    {
+        for (int idx = m_col_offsets[col] + 1; idx < m_col_offsets[col + 1]; ++idx)
+            m_work[col] -= m_values[idx] * m_work[m_row_indices[idx]];
+
+        m_work[col] /= m_values[m_col_offsets[col]];
+    }
+
+    for (int idx = 0; idx < m_size; ++idx)
+    {
+        x[m_permutation[idx]] = m_work[idx];
+        m_work[idx] = 0.0;
+    }
+}
+
+int sparse_cholesky::get_size() const
+{
+    return m_size;
+}
+
+int sparse_cholesky::get_nonzeros() const
+{
+    return m_values.size();
+}
+
+bool sparse_cholesky::is_modified() const
+{
+    return m_is_modified;
+}
+
+const std::vector<int>& sparse_cholesky::get_permutation() const
+{
+    return m_permutation;
+}
@@ -0,0 +1,145 @@
+#include <algorithm>
+
+#include "sparse_matrix.hpp"
+
+/*
+ * Creates empty matrix of @rows x @cols.
+ */
+sparse_matrix::sparse_matrix(int rows, int cols) :
+    m_rows(rows), m_cols(cols),
+    m_row_offsets(rows + 1, 0)
+{
+
+}
+
+/*
+ * Creates matrix with @cols columns and zero entries at positions of
+ * @pattern, where @pattern[r] lists sorted columns of row r.
+ */
+sparse_matrix::sparse_matrix(int cols,
+                             const std::vector<std::vector<int>>& pattern) :
+    m_rows(pattern.size()), m_cols(cols),
+    m_row_offsets(pattern.size() + 1, 0)
+{
+    for (int row = 0; row < m_rows; ++row)
+        m_row_offsets[row + 1] = m_row_offsets[row] + pattern[row].size();
+
+    m_col_indices.reserve(m_row_offsets[m_rows]);
+    for (int row = 0; row < m_rows; ++row)
+        m_col_indices.insert(m_col_indices.end(),
+                             pattern[row].begin(), pattern[row].end());
+
+    m_values.assign(m_row_offsets[m_rows], 0.0);
+}
+
+int sparse_matrix::get_rows() const
+{
+    return m_rows;
+}
+
+int sparse_matrix::get_cols() const
+{
+    return m_cols;
+}
+
+int sparse_matrix::get_nonzeros() const
+{
+    return m_values.size();
+}
+
+/*
+ * Returns entry at @row and @col or zero if it isn't stored.
+ */
+double sparse_matrix::get(int row, int col) const
+{
+    auto begin = m_col_indices.cbegin() + m_row_offsets[row];
+    auto end = m_col_indices.cbegin() + m_row_offsets[row + 1];
+    auto position = std::lower_bound(begin, end, col);
+
+    if (position == end || *position != col)
+        return 0.0;
+
+    return m_values[position - m_col_indices.cbegin()];
+}
+
+/*
+ * Returns pointer to stored entry at @row and @col or nullptr.
+ */
+double* sparse_matrix::find(int row, int col)
+{
+    auto begin = m_col_indices.begin() + m_row_offsets[row];
+    auto end = m_col_indices.begin() + m_row_offsets[row + 1];
+    auto position = std::lower_bound(begin, end, col);
+
+    if (position == end || *position != col)
+        return nullptr;
+
+    return &m_values[position - m_col_indices.begin()];
+}
+
+/*
+ * Returns transposed matrix, i.e. CSC form of this one.
+ */
+sparse_matrix sparse_matrix::transpose() const
+{
+    sparse_matrix trans(m_cols, m_rows);
+
+    for (int idx = 0; idx < get_nonzeros(); ++idx)
+        ++trans.m_row_offsets[m_col_indices[idx] + 1];
+    for (int row = 0; row < m_cols; ++row)
+        trans.m_row_offsets[row + 1] += trans.m_row_offsets[row];
+
+    trans.m_col_indices.resize(get_nonzeros());
+    trans.m_values.resize(get_nonzeros());
+
+    // Rows are visited in order, so columns of transposed rows stay sorted.
+    std::vector<int> next(trans.m_row_offsets.begin(),
+                          trans.m_row_offsets.end() - 1);
+    for (int row = 0; row < m_rows; ++row)
+        for (int idx = m_row_offsets[row]; idx < m_row_offsets[row + 1]; ++idx)
+        {
+            int position = next[m_col_indices[idx]]++;
+
+            trans.m_col_indices[position] = row;
+            trans.m_values[position] = m_values[idx];
+        }
+
+    return trans;
+}
+
+matrix sparse_matrix::to_dense() const
+{
+    matrix dense("DENSE", m_rows, m_cols);
+
+    for (int row = 0; row < m_rows; ++row)
+        for (int idx = m_row_offsets[row]; idx < m_row_offsets[row + 1]; ++idx)
+            dense.m_data[row][m_col_indices[idx]] = m_values[idx];
+
+    return dense;
+}
+
+/*
+ * Saves product of matrix and @vec to @dst. Takes time linear in nonzeros.
+ */
+void sparse_matrix::multiply(const std::vector<double>& vec,
+                             std::vector<double>& dst) const
+{
+    for (int row = 0; row < m_rows; ++row)
+    {
+        double sum = 0.0;
+
+        for (int idx = m_row_offsets[row]; idx < m_row_offsets[row + 1]; ++idx)
+            sum += m_values[idx] * vec[m_col_indices[idx]];
+
+        dst[row] = sum;
+    }
+}
+
+std::vector<double> sparse_matrix::operator*(const std::vector<double>& vec) const
+{
+    std::vector<double> result(m_rows);
+
+    multiply(vec, result);
+
+    return result;
+}
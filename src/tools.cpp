@@ -1,8 +1,13 @@
+#include <algorithm>
 #include <cmath>
+#include <limits>
 #include <vector>
 
 #include "tools.hpp"
 
+static Tools::DifferenceScheme sScheme = Tools::CENTRAL_DIFFERENCE;
+static double sNoise = std::numeric_limits<double>::epsilon();
+
 /*
  * Returns first partial derivative of function @f defined by @variableCount.
  * Checked: yes
@@ -10,14 +15,112 @@
 double Tools::first_derivative(double (*f)(const std::vector<double>&),
                                const std::vector<double>& x, int variableCount)
 {
-    std::vector<double> auxiliaryOne = std::vector<double>(x);
-    std::vector<double> auxiliaryTwo = std::vector<double>(x);
+    return first_derivative(f, x, variableCount, f(x));
+}
+
+/*
+ * Returns first partial derivative of function @f defined by @variableCount
+ * using already known value @fx of @f at @x.
+ */
+double Tools::first_derivative(double (*f)(const std::vector<double>&),
+                               const std::vector<double>& x, int variableCount,
+                               const double fx)
+{
+    std::vector<double> auxiliary = std::vector<double>(x);
+
+    return perturbed_derivative(f, auxiliary, variableCount, fx);
+}
+
+/*
+ * Returns first partial derivative of function @f defined by @variableCount
+ * at point @x, where @fx is value of @f at @x. Coordinate of @x is moved
+ * in place and restored before return. Formula and step are chosen by
+ * current difference scheme.
+ */
+double Tools::perturbed_derivative(double (*f)(const std::vector<double>&),
+                                   std::vector<double>& x, int variableCount,
+                                   const double fx)
+{
+    double value = x[variableCount];
+    double derivative;
+
+    switch (sScheme)
+    {
+    case FORWARD_DIFFERENCE:
+    {
+        double step = find_step(value, 1);
+
+        x[variableCount] = value + step;
+        derivative = (f(x) - fx) / step;
+
+        break;
+    }
+
+    case FOURTH_ORDER_DIFFERENCE:
+    {
+        double step = find_step(value, 4);
+        double leftFar, left, right, rightFar;
+
+        x[variableCount] = value - 2.0 * step;
+        leftFar = f(x);
+        x[variableCount] = value - step;
+        left = f(x);
+        x[variableCount] = value + step;
+        right = f(x);
+        x[variableCount] = value + 2.0 * step;
+        rightFar = f(x);
+
+        derivative = (leftFar - 8.0 * left + 8.0 * right - rightFar) /
+                (12.0 * step);
+
+        break;
+    }
+
+    case EXTRAPOLATED_DIFFERENCE:
+    {
+        double step = find_step(value, 6);
+        double table[3];
 
-    auxiliaryOne[variableCount] -= EPSILON;
-    auxiliaryTwo[variableCount] += EPSILON;
+        // Central differences with halved steps, combined by Richardson.
+        for (unsigned idx = 0; idx < 3; ++idx, step /= 2.0)
+        {
+            double left, right;
 
-    return (f(auxiliaryOne) - 4.0 * f(x) + 3.0 * f(auxiliaryTwo)) /
-            (2.0 * EPSILON);
+            x[variableCount] = value - step;
+            left = f(x);
+            x[variableCount] = value + step;
+            right = f(x);
+
+            table[idx] = (right - left) / (2.0 * step);
+        }
+
+        table[0] = (4.0 * table[1] - table[0]) / 3.0;
+        table[1] = (4.0 * table[2] - table[1]) / 3.0;
+        derivative = (16.0 * table[1] - table[0]) / 15.0;
+
+        break;
+    }
+
+    case CENTRAL_DIFFERENCE:
+    default:
+    {
+        double step = find_step(value, 2);
+        double left, right;
+
+        x[variableCount] = value - step;
+        left = f(x);
+        x[variableCount] = value + step;
+        right = f(x);
+
+        derivative = (right - left) / (2.0 * step);
+
+        break;
+    }
+    }
+
+    x[variableCount] = value;
+
+    return derivative;
 }
 
 /*
@@ -29,23 +132,157 @@ double Tools::second_derivative(double (*f)(const std::vector<double>&),
                                 const std::vector<double>& x,
                                 int alphaVariableCount, int betaVariableCount)
 {
-    std::vector<double> auxiliaryOne = std::vector<double>(x);
-    std::vector<double> auxiliaryTwo = std::vector<double>(x);
-    std::vector<double> auxiliaryThree = std::vector<double>(x);
-    std::vector<double> auxiliaryFour = std::vector<double>(x);
+    std::vector<double> auxiliary = std::vector<double>(x);
+
+    return perturbed_second_derivative(f, auxiliary,
+                                       alphaVariableCount, betaVariableCount);
+}
+
+/*
+ * Returns second partial derivative of function @f defined by
+ * @alphaVariableCount and @betaVariableCount at point @x. Coordinates of @x
+ * are moved in place and restored before return.
+ */
+double Tools::perturbed_second_derivative(
+        double (*f)(const std::vector<double>&), std::vector<double>& x,
+        int alphaVariableCount, int betaVariableCount)
+{
+    static const double SIGNS[4][2] =
+    {
+        { 1.0, 1.0 }, { 1.0, -1.0 }, { -1.0, 1.0 }, { -1.0, -1.0 }
+    };
+
+    double alphaValue = x[alphaVariableCount];
+    double betaValue = x[betaVariableCount];
+    double alphaStep = find_step(alphaValue, 3);
+    double betaStep = find_step(betaValue, 3);
+    double sum = 0.0;
+
+    // Steps add up on diagonal, as both coordinates are the same.
+    for (unsigned idx = 0; idx < 4; ++idx)
+    {
+        x[betaVariableCount] = betaValue;
+        x[alphaVariableCount] = alphaValue + SIGNS[idx][0] * alphaStep;
+        x[betaVariableCount] += SIGNS[idx][1] * betaStep;
+
+        sum += SIGNS[idx][0] * SIGNS[idx][1] * f(x);
+    }
+
+    x[alphaVariableCount] = alphaValue;
+    x[betaVariableCount] = betaValue;
+
+    return sum / (4.0 * alphaStep * betaStep);
+}
+
+/*
+ * Sets formula used by first derivatives.
+ */
+void Tools::set_difference_scheme(const DifferenceScheme scheme)
+{
+    sScheme = scheme;
+}
+
+Tools::DifferenceScheme Tools::get_difference_scheme()
+{
+    return sScheme;
+}
+
+/*
+ * Sets relative noise of function values which steps are derived from.
+ * Values below machine epsilon are raised to it.
+ */
+void Tools::set_function_noise(const double noise)
+{
+    sNoise = std::max(noise, std::numeric_limits<double>::epsilon());
+}
+
+double Tools::get_function_noise()
+{
+    return sNoise;
+}
+
+/*
+ * Returns count of function evaluations spent on gradient of @variablesCount
+ * variables by current scheme, besides value at the point itself.
+ */
+unsigned Tools::evaluations_per_gradient(unsigned variablesCount)
+{
+    switch (sScheme)
+    {
+    case FORWARD_DIFFERENCE:
+        return variablesCount;
+    case FOURTH_ORDER_DIFFERENCE:
+        return 4 * variablesCount;
+    case EXTRAPOLATED_DIFFERENCE:
+        return 6 * variablesCount;
+    case CENTRAL_DIFFERENCE:
+    default:
+        return 2 * variablesCount;
+    }
+}
 
-    // Add difference.
-    auxiliaryOne[alphaVariableCount]    += EPSILON;
-    auxiliaryOne[betaVariableCount]     += EPSILON;
-    auxiliaryTwo[alphaVariableCount]    += EPSILON;
-    auxiliaryTwo[betaVariableCount]     -= EPSILON;
-    auxiliaryThree[alphaVariableCount]  -= EPSILON;
-    auxiliaryThree[betaVariableCount]   += EPSILON;
-    auxiliaryFour[alphaVariableCount]   -= EPSILON;
-    auxiliaryFour[betaVariableCount]    -= EPSILON;
+/*
+ * Returns step for coordinate of @value and difference formula
+ * with error of @order: noise ^ (1 / (@order + 1)) scaled by magnitude of
+ * @value. Step is adjusted to be exactly representable near @value.
+ */
+double Tools::find_step(const double value, const unsigned order)
+{
+    double step = pow(sNoise, 1.0 / (order + 1.0)) *
+            std::max(fabs(value), 1.0);
+    double moved = value + step;
 
-    return (f(auxiliaryOne) - f(auxiliaryTwo) -
-            f(auxiliaryThree) + f(auxiliaryFour)) / (4.0 * EPSILON * EPSILON);
+    return moved - value;
+}
+
+/*
+ * Estimates relative noise of function @f near @x from high order
+ * differences of its values along a fixed direction.
+ */
+double Tools::estimate_noise(double (*f)(const std::vector<double>&),
+                             const std::vector<double>& x)
+{
+    unsigned variablesCount = x.size();
+    std::vector<double> auxiliary(x), values(NOISE_POINTS + 1);
+
+    for (unsigned point = 0; point <= NOISE_POINTS; ++point)
+    {
+        double shift = (point - NOISE_POINTS / 2.0) * NOISE_STEP /
+                sqrt(variablesCount);
+
+        for (unsigned idx = 0; idx < variablesCount; ++idx)
+            auxiliary[idx] = x[idx] + ((idx % 2 == 0) ? shift : -shift) *
+                    std::max(fabs(x[idx]), 1.0);
+
+        values[point] = f(auxiliary);
+    }
+
+    double center = fabs(values[NOISE_POINTS / 2]);
+    double noise = std::numeric_limits<double>::max();
+    double gamma = 1.0;
+
+    for (unsigned order = 1; order <= NOISE_POINTS; ++order)
+    {
+        double sum = 0.0;
+
+        for (unsigned idx = 0; idx <= NOISE_POINTS - order; ++idx)
+        {
+            values[idx] = values[idx + 1] - values[idx];
+            sum += values[idx] * values[idx];
+        }
+
+        // gamma = (order!)^2 / (2 * order)!
+        gamma *= order / (2.0 * (2.0 * order - 1.0));
+
+        if (order >= 3)
+            noise = std::min(noise,
+                             sqrt(gamma * sum / (NOISE_POINTS + 1 - order)));
+    }
+
+    if (center > 0.0)
+        noise /= center;
+
+    return std::max(noise, std::numeric_limits<double>::epsilon());
 }
 
 /*
@@ -80,6 +317,46 @@ std::vector<double> Tools::find_antigradient(double (*f)(const std::vector<doubl
     return std::move(auxiliary);
 }
 
+/*
+ * Saves gradient of function @f at @x to @gradient.
+ * Uses only preallocated vectors of @workspace.
+ */
+void Tools::find_gradient(double (*f)(const std::vector<double>&),
+    const std::vector<double>& x, std::vector<double>& gradient,
+    Workspace& workspace)
+{
+    find_gradient(f, x, f(x), gradient, workspace);
+}
+
+/*
+ * Saves gradient of function @f at @x to @gradient, where @fx is value of @f
+ * at @x. Uses only preallocated vectors of @workspace.
+ */
+void Tools::find_gradient(double (*f)(const std::vector<double>&),
+    const std::vector<double>& x, const double fx,
+    std::vector<double>& gradient, Workspace& workspace)
+{
+    std::vector<double>& auxiliary = workspace.auxiliary;
+
+    auxiliary = x;
+    for (unsigned idx = 0; idx < x.size(); ++idx)
+        gradient[idx] = perturbed_derivative(f, auxiliary, idx, fx);
+}
+
+/*
+ * Saves antigradient of function @f at @x to @antigradient.
+ * Uses only preallocated vectors of @workspace.
+ */
+void Tools::find_antigradient(double (*f)(const std::vector<double>&),
+    const std::vector<double>& x, std::vector<double>& antigradient,
+    Workspace& workspace)
+{
+    find_gradient(f, x, antigradient, workspace);
+
+    for (unsigned idx = 0; idx < antigradient.size(); ++idx)
+        antigradient[idx] = -antigradient[idx];
+}
+
 /*
  * Returns Hessian of function "f" of vector "x".
  * Checked: yes.
@@ -90,15 +367,197 @@ matrix Tools::find_hessian(double (*f)(const std::vector<double>&),
     int variablesCount = x.size();
 
     matrix hessian("HESSIAN", variablesCount, variablesCount);
+    Workspace workspace(variablesCount);
+
+    find_hessian(f, x, hessian, workspace);
+
+    return hessian;
+}
+
+/*
+ * Saves Hessian of function @f at @x to @hessian. Symmetric entries are
+ * computed once. Uses only preallocated vectors of @workspace.
+ */
+void Tools::find_hessian(double (*f)(const std::vector<double>&),
+                         const std::vector<double>& x, matrix& hessian,
+                         Workspace& workspace)
+{
+    int variablesCount = x.size();
+    std::vector<double>& auxiliary = workspace.auxiliary;
 
+    auxiliary = x;
     for (int alpha = 0; alpha < variablesCount; ++alpha)
-        for (int beta = 0; beta < variablesCount; ++beta)
-            hessian.m_data[alpha][beta] =
-                    Tools::second_derivative(f, x, alpha, beta);
+        for (int beta = alpha; beta < variablesCount; ++beta)
+            hessian.m_data[alpha][beta] = hessian.m_data[beta][alpha] =
+                    perturbed_second_derivative(f, auxiliary, alpha, beta);
+}
+
+/*
+ * Splits columns of symmetric @pattern into groups with no two columns
+ * having nonzero in the same row, so each group may be estimated by a
+ * single difference of gradients. Returns group of each column and saves
+ * groups count to @colorsCount.
+ */
+std::vector<int> Tools::color_columns(const std::vector<std::vector<int>>& pattern,
+                                      unsigned& colorsCount)
+{
+    unsigned variablesCount = pattern.size();
+    std::vector<int> colors(variablesCount, -1);
+    std::vector<unsigned> forbidden(variablesCount, variablesCount);
+
+    colorsCount = 0;
+
+    for (unsigned col = 0; col < variablesCount; ++col)
+    {
+        // Columns at distance of one or two share a row with current one.
+        for (int neighbour : pattern[col])
+            for (int other : pattern[neighbour])
+                if (colors[other] >= 0)
+                    forbidden[colors[other]] = col;
+
+        unsigned color = 0;
+        while (color < colorsCount && forbidden[color] == col)
+            ++color;
+
+        colors[col] = color;
+        if (color == colorsCount)
+            ++colorsCount;
+    }
+
+    return colors;
+}
+
+/*
+ * Returns Hessian of function @f at @x with nonzeros at @pattern,
+ * estimated by central differences of gradients along sums of columns
+ * sharing a color of @colors. Costs 2 * @colorsCount gradients instead of
+ * entry-wise second derivatives.
+ */
+sparse_matrix Tools::find_sparse_hessian(double (*f)(const std::vector<double>&),
+                                         const std::vector<double>& x,
+                                         const std::vector<std::vector<int>>& pattern,
+                                         const std::vector<int>& colors,
+                                         unsigned colorsCount)
+{
+    unsigned variablesCount = x.size();
+
+    sparse_matrix hessian(variablesCount, pattern);
+    Workspace workspace(variablesCount);
+
+    find_sparse_hessian(f, x, pattern, colors, colorsCount, hessian, workspace);
 
     return hessian;
 }
 
+/*
+ * Saves Hessian of function @f at @x to @hessian built from @pattern.
+ * Uses only preallocated vectors of @workspace.
+ */
+void Tools::find_sparse_hessian(double (*f)(const std::vector<double>&),
+                                const std::vector<double>& x,
+                                const std::vector<std::vector<int>>& pattern,
+                                const std::vector<int>& colors,
+                                unsigned colorsCount, sparse_matrix& hessian,
+                                Workspace& workspace)
+{
+    unsigned variablesCount = x.size();
+
+    // Gradients are taken through auxiliary, so other vectors are free.
+    std::vector<double>& shifted = workspace.product;
+    std::vector<double>& forward = workspace.gradient;
+    std::vector<double>& backward = workspace.antigradient;
+
+    shifted = x;
+    for (unsigned color = 0; color < colorsCount; ++color)
+    {
+        for (unsigned idx = 0; idx < variablesCount; ++idx)
+            if (colors[idx] == (int)color)
+                shifted[idx] = x[idx] + find_step(x[idx], 3);
+        find_gradient(f, shifted, forward, workspace);
+
+        for (unsigned idx = 0; idx < variablesCount; ++idx)
+            if (colors[idx] == (int)color)
+                shifted[idx] = x[idx] - find_step(x[idx], 3);
+        find_gradient(f, shifted, backward, workspace);
+
+        for (unsigned idx = 0; idx < variablesCount; ++idx)
+            if (colors[idx] == (int)color)
+                shifted[idx] = x[idx];
+
+        // Only column of this color in each row is pattern[row] & color.
+        for (unsigned col = 0; col < variablesCount; ++col)
+        {
+            if (colors[col] != (int)color)
+                continue;
+
+            for (int row : pattern[col])
+                *hessian.find(row, col) = (forward[row] - backward[row]) /
+                        (2.0 * find_step(x[col], 3));
+        }
+    }
+
+    // Estimates of symmetric entries differ slightly, average them.
+    for (unsigned row = 0; row < variablesCount; ++row)
+        for (int col : pattern[row])
+            if ((unsigned)col > row)
+            {
+                double* upper = hessian.find(row, col);
+                double* lower = hessian.find(col, row);
+
+                *upper = *lower = (*upper + *lower) / 2.0;
+            }
+}
+
+/*
+ * Saves residuals of @f at @x to @residuals and their Jacobian to @jacobian,
+ * which has a row for each residual. All perturbed points go to @f in one
+ * batch, so columns are estimated in parallel when @f evaluates in parallel.
+ * Forward scheme takes one point per column, other schemes take two.
+ */
+void Tools::find_jacobian(void (*f)(const std::vector<std::vector<double>>&,
+                                    std::vector<std::vector<double>>&),
+                          const std::vector<double>& x,
+                          std::vector<double>& residuals, matrix& jacobian)
+{
+    unsigned variablesCount = x.size(),
+            pointsPerColumn = sScheme == FORWARD_DIFFERENCE ? 1 : 2;
+
+    // Batch is kept between calls, so iterations reuse its storage.
+    static thread_local std::vector<std::vector<double>> points, values;
+    static thread_local std::vector<double> steps;
+
+    points.resize(1 + pointsPerColumn * variablesCount);
+    for (std::vector<double>& point : points)
+        point = x;
+    steps.resize(variablesCount);
+
+    for (unsigned col = 0; col < variablesCount; ++col)
+    {
+        steps[col] = find_step(x[col], pointsPerColumn);
+
+        points[1 + pointsPerColumn * col][col] += steps[col];
+        if (pointsPerColumn == 2)
+            points[2 + pointsPerColumn * col][col] -= steps[col];
+    }
+
+    f(points, values);
+    residuals = values[0];
+
+    for (unsigned row = 0; row < residuals.size(); ++row)
+        for (unsigned col = 0; col < variablesCount; ++col)
+        {
+            const std::vector<double>& forward = values[1 + pointsPerColumn * col];
+
+            if (pointsPerColumn == 1)
+                jacobian.m_data[row][col] =
+                        (forward[row] - residuals[row]) / steps[col];
+            else
+                jacobian.m_data[row][col] =
+                        (forward[row] - values[2 + pointsPerColumn * col][row]) /
+                        (2.0 * steps[col]);
+        }
+}
+
 /*
  * Returns norm of vector "x".
  * Checked: yes.
@@ -113,6 +572,20 @@ double Tools::find_norm(const std::vector<double>& x)
     return sqrt(result);
 }
 
+/*
+ * Returns dot product of vectors @x and @y of the same size.
+ */
+double Tools::find_dot_product(const std::vector<double>& x,
+                               const std::vector<double>& y)
+{
+    double result = 0.0;
+
+    for (unsigned idx = 0; idx < x.size(); ++idx)
+        result += x[idx] * y[idx];
+
+    return result;
+}
+
 /*
  * Normalizes vector @x.
  * Checked: yes.
@@ -125,6 +598,16 @@ void Tools::normalize(std::vector<double>& x)
         x[idx] /= norm;
 }
 
+/*
+ * Moves @x to the nearest point of box between @lower and @upper.
+ */
+void Tools::project(std::vector<double>& x, const std::vector<double>& lower,
+                    const std::vector<double>& upper)
+{
+    for (unsigned idx = 0; idx < x.size(); ++idx)
+        x[idx] = std::min(std::max(x[idx], lower[idx]), upper[idx]);
+}
+
 /*
  * Moves along @direction from point @initial with @alpha factor
  * and saves new point to @dst
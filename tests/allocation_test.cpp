@@ -0,0 +1,394 @@
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#include "methods.hpp"
+#include "parser.hpp"
+
+/*
+ * Allocation test of multidimensional methods. Each method is run twice,
+ * stopped after N and after 2N evaluations of function, and both runs must
+ * allocate the same count of blocks, so iterations between evaluation N
+ * and 2N allocate nothing. N is past setup of methods; runs finishing
+ * before 2N evaluations fail as well. Methods take no iterations limit, so
+ * evaluations stand in for iterations. Each method is warmed up by a run
+ * first, so per-thread scratch allocated on first use isn't counted.
+ * Augmented Lagrangian is exempt: each outer iteration runs inner method
+ * from scratch, which sets up its vectors again. Methods also run on
+ * function compiled by parser, as jobs do, with line degrees detected.
+ */
+
+static unsigned long sAllocations = 0;
+
+void* operator new(std::size_t size)
+{
+    ++sAllocations;
+
+    if (void* block = std::malloc(size ? size : 1))
+        return block;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* block) noexcept
+{
+    std::free(block);
+}
+
+void operator delete[](void* block) noexcept
+{
+    std::free(block);
+}
+
+void operator delete(void* block, std::size_t) noexcept
+{
+    std::free(block);
+}
+
+void operator delete[](void* block, std::size_t) noexcept
+{
+    std::free(block);
+}
+
+namespace
+{
+const unsigned VARIABLES_COUNT = 4;
+const double EPSILON = 1E-12;
+
+// Thrown by function to stop method after given count of evaluations.
+struct Stop {};
+
+unsigned long sEvaluations;
+unsigned long sEvaluationsLimit;
+std::vector<double> sPoint(VARIABLES_COUNT);
+const std::vector<double>* sPosition;
+const std::vector<double>* sDirection;
+
+void count_evaluation()
+{
+    if (++sEvaluations > sEvaluationsLimit)
+        throw Stop();
+}
+
+// Extended Rosenbrock's function, slow enough to keep methods iterating.
+double rosenbrock(const std::vector<double>& x)
+{
+    double value = 0.0;
+
+    for (unsigned idx = 0; idx + 1 < x.size(); ++idx)
+        value += 100.0 * (x[idx + 1] - x[idx] * x[idx]) *
+                (x[idx + 1] - x[idx] * x[idx]) +
+                (1.0 - x[idx]) * (1.0 - x[idx]);
+
+    return value;
+}
+
+double evaluate_multi(const std::vector<double>& x)
+{
+    count_evaluation();
+
+    return rosenbrock(x);
+}
+
+double evaluate_mono(const double alpha)
+{
+    count_evaluation();
+
+    for (unsigned idx = 0; idx < VARIABLES_COUNT; ++idx)
+        sPoint[idx] = (*sPosition)[idx] + alpha * (*sDirection)[idx];
+
+    return rosenbrock(sPoint);
+}
+
+void evaluate_batch(const std::vector<std::vector<double>>& points,
+                    std::vector<double>& values)
+{
+    values.resize(points.size());
+
+    for (unsigned idx = 0; idx < points.size(); ++idx)
+        values[idx] = evaluate_multi(points[idx]);
+}
+
+void evaluate_residuals(const std::vector<std::vector<double>>& points,
+                        std::vector<std::vector<double>>& values)
+{
+    values.resize(points.size());
+
+    for (unsigned point = 0; point < points.size(); ++point)
+    {
+        const std::vector<double>& x = points[point];
+        std::vector<double>& residuals = values[point];
+
+        count_evaluation();
+
+        residuals.resize(2 * (VARIABLES_COUNT - 1));
+        for (unsigned idx = 0; idx + 1 < VARIABLES_COUNT; ++idx)
+        {
+            residuals[2 * idx] = 10.0 * (x[idx + 1] - x[idx] * x[idx]);
+            residuals[2 * idx + 1] = 1.0 - x[idx];
+        }
+    }
+}
+
+// The same function as compiled by parser, with a term of sine to keep
+// it from being a polynomial along lines.
+const char* PARSED_EXPRESSION =
+        "100*(x1-x0^2)^2+(1-x0)^2+100*(x2-x1^2)^2+(1-x1)^2+"
+        "100*(x3-x2^2)^2+(1-x2)^2+sin(x0*x3)";
+
+double evaluate_parsed_mono(const double alpha)
+{
+    count_evaluation();
+
+    return Parser::evaluateFunctionMono(alpha);
+}
+
+double evaluate_parsed_multi(const std::vector<double>& x)
+{
+    count_evaluation();
+
+    return Parser::evaluateFunctionMulti(x);
+}
+
+void evaluate_parsed_batch(const std::vector<std::vector<double>>& points,
+                           std::vector<double>& values)
+{
+    for (unsigned idx = 0; idx < points.size(); ++idx)
+        count_evaluation();
+
+    Parser::evaluateFunctionBatch(points, values);
+}
+
+struct Problem
+{
+    std::vector<double> variables;
+    std::vector<double> initial;
+    std::vector<double> direction;
+    std::vector<double> lower;
+    std::vector<double> upper;
+    std::vector<std::vector<int>> pattern;
+};
+
+typedef void (*Runner)(Problem& problem);
+
+void run_partan_two(Problem& p)
+{
+    Methods::partan_two(evaluate_mono, evaluate_multi, p.variables,
+                        p.initial, p.direction, EPSILON);
+}
+
+void run_step_adjusting_newton(Problem& p)
+{
+    Methods::step_adjusting_newton(evaluate_mono, evaluate_multi, p.variables,
+                                   p.initial, p.direction, EPSILON);
+}
+
+void run_sparse_newton(Problem& p)
+{
+    Methods::sparse_newton(evaluate_mono, evaluate_multi, p.pattern,
+                           p.variables, p.initial, p.direction, EPSILON);
+}
+
+void run_trust_region_dogleg(Problem& p)
+{
+    Methods::trust_region_newton(evaluate_mono, evaluate_multi, p.variables,
+                                 p.initial, p.direction, EPSILON,
+                                 Methods::DOGLEG);
+}
+
+void run_trust_region_steihaug_cg(Problem& p)
+{
+    Methods::trust_region_newton(evaluate_mono, evaluate_multi, p.variables,
+                                 p.initial, p.direction, EPSILON,
+                                 Methods::STEIHAUG_CG);
+}
+
+void run_gauss_newton(Problem& p)
+{
+    Methods::gauss_newton(evaluate_mono, evaluate_multi, evaluate_residuals,
+                          p.variables, p.initial, p.direction, EPSILON);
+}
+
+void run_levenberg_marquardt(Problem& p)
+{
+    Methods::levenberg_marquardt(evaluate_mono, evaluate_multi,
+                                 evaluate_residuals, p.variables, p.initial,
+                                 p.direction, EPSILON);
+}
+
+void run_projected_lbfgs(Problem& p)
+{
+    Methods::projected_lbfgs(evaluate_mono, evaluate_multi, p.lower, p.upper,
+                             p.variables, p.initial, p.direction, EPSILON);
+}
+
+void run_quasinewton_pearson_two(Problem& p)
+{
+    Methods::quasinewton_pearson_two(evaluate_mono, evaluate_multi,
+                                     p.variables, p.initial, p.direction,
+                                     EPSILON);
+}
+
+void run_mcg_daniel(Problem& p)
+{
+    Methods::mcg_daniel(evaluate_mono, evaluate_multi, p.variables,
+                        p.initial, p.direction, EPSILON);
+}
+
+void run_nelder_mead(Problem& p)
+{
+    Methods::nelder_mead(evaluate_mono, evaluate_multi, evaluate_batch,
+                         p.variables, p.initial, p.direction, EPSILON);
+}
+
+void run_cma_es(Problem& p)
+{
+    Methods::cma_es(evaluate_mono, evaluate_multi, evaluate_batch,
+                    p.variables, p.initial, p.direction, EPSILON);
+}
+
+void run_powell_two(Problem& p)
+{
+    Methods::powell_two(evaluate_mono, evaluate_multi, p.variables,
+                        p.initial, p.direction, EPSILON);
+}
+
+void run_parsed_quasinewton_pearson_two(Problem& p)
+{
+    Parser::sPosition = p.initial;
+    Methods::set_line_degree(evaluate_parsed_mono, Parser::findLineDegree);
+
+    Methods::quasinewton_pearson_two(evaluate_parsed_mono,
+                                     evaluate_parsed_multi, Parser::sVariables,
+                                     Parser::sPosition, Parser::sDirection,
+                                     EPSILON);
+}
+
+void run_parsed_powell_two(Problem& p)
+{
+    Parser::sPosition = p.initial;
+    Methods::set_line_degree(evaluate_parsed_mono, Parser::findLineDegree);
+
+    Methods::powell_two(evaluate_parsed_mono, evaluate_parsed_multi,
+                        Parser::sVariables, Parser::sPosition,
+                        Parser::sDirection, EPSILON);
+}
+
+void run_parsed_nelder_mead(Problem& p)
+{
+    Parser::sPosition = p.initial;
+
+    Methods::nelder_mead(evaluate_parsed_mono, evaluate_parsed_multi,
+                         evaluate_parsed_batch, Parser::sVariables,
+                         Parser::sPosition, Parser::sDirection, EPSILON);
+}
+
+/*
+ * Runs @runner until @evaluationsLimit evaluations. Returns count of
+ * allocations, or sets @isFinished if method finished earlier.
+ */
+unsigned long count_allocations(Runner runner, unsigned long evaluationsLimit,
+                                bool& isFinished)
+{
+    Problem problem;
+
+    problem.variables.assign(VARIABLES_COUNT, 0.0);
+    problem.direction.assign(VARIABLES_COUNT, 0.0);
+    problem.lower.assign(VARIABLES_COUNT, -10.0);
+    problem.upper.assign(VARIABLES_COUNT, 10.0);
+    for (unsigned idx = 0; idx < VARIABLES_COUNT; ++idx)
+    {
+        problem.initial.push_back(idx % 2 == 0 ? -1.2 : 1.0);
+        problem.pattern.push_back(std::vector<int>());
+
+        for (unsigned col = idx > 0 ? idx - 1 : 0;
+             col <= idx + 1 && col < VARIABLES_COUNT; ++col)
+            problem.pattern[idx].push_back(col);
+    }
+
+    sPosition = &problem.initial;
+    sDirection = &problem.direction;
+    sEvaluations = 0;
+    sEvaluationsLimit = evaluationsLimit;
+
+    unsigned long allocations = sAllocations;
+    isFinished = true;
+
+    try
+    {
+        runner(problem);
+    }
+    catch (Stop&)
+    {
+        isFinished = false;
+    }
+
+    return sAllocations - allocations;
+}
+}
+
+int main()
+{
+    struct Case
+    {
+        const char* name;
+        Runner runner;
+        unsigned long evaluations;
+    };
+
+    const Case CASES[] =
+    {
+        { "partan_two", run_partan_two, 200 },
+        { "step_adjusting_newton", run_step_adjusting_newton, 200 },
+        { "sparse_newton", run_sparse_newton, 200 },
+        { "trust_region_newton (dogleg)", run_trust_region_dogleg, 200 },
+        { "trust_region_newton (Steihaug-CG)", run_trust_region_steihaug_cg, 200 },
+        { "gauss_newton", run_gauss_newton, 40 },
+        { "levenberg_marquardt", run_levenberg_marquardt, 40 },
+        { "projected_lbfgs", run_projected_lbfgs, 200 },
+        { "quasinewton_pearson_two", run_quasinewton_pearson_two, 200 },
+        { "mcg_daniel", run_mcg_daniel, 200 },
+        { "nelder_mead", run_nelder_mead, 100 },
+        { "cma_es", run_cma_es, 200 },
+        { "powell_two", run_powell_two, 200 },
+        { "quasinewton_pearson_two (parser)",
+          run_parsed_quasinewton_pearson_two, 200 },
+        { "powell_two (parser)", run_parsed_powell_two, 200 },
+        { "nelder_mead (parser)", run_parsed_nelder_mead, 100 }
+    };
+
+    Parser::configureParser(PARSED_EXPRESSION, VARIABLES_COUNT);
+
+    int failures = 0;
+
+    for (const Case& test : CASES)
+    {
+        bool isFinished, isFinishedTwice;
+        count_allocations(test.runner, 2 * test.evaluations, isFinished);
+
+        unsigned long once = count_allocations(test.runner, test.evaluations,
+                                               isFinished);
+        unsigned long twice = count_allocations(test.runner,
+                                                2 * test.evaluations,
+                                                isFinishedTwice);
+
+        bool isPassed = !isFinished && !isFinishedTwice && once == twice;
+
+        std::printf("%-36s %s: %lu allocations after %lu evaluations, "
+                    "%lu after %lu%s\n", test.name,
+                    isPassed ? "passed" : "FAILED", once, test.evaluations,
+                    twice, 2 * test.evaluations,
+                    isFinished || isFinishedTwice ? ", method finished" : "");
+
+        if (!isPassed)
+            ++failures;
+    }
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,89 @@
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "parser.hpp"
+
+/*
+ * Test of cache of compiled functions. Expressions differing in spacing
+ * which doesn't change their tokens share bytecode, others are compiled
+ * on their own, so an expression which fails to compile is never served
+ * bytecode of a valid one.
+ */
+
+namespace
+{
+const unsigned VARIABLES_COUNT = 2;
+
+/*
+ * Configures parser for @expression after @previous was configured and
+ * returns true if bytecode came from cache. Saves value of function at
+ * @x to @value, or sets @isFailed if it can't be evaluated.
+ */
+bool configure(const char* previous, const char* expression,
+               const std::vector<double>& x, double& value, bool& isFailed)
+{
+    Parser::configureParser(previous, VARIABLES_COUNT);
+
+    unsigned long hits = Parser::getCacheHits();
+    Parser::configureParser(expression, VARIABLES_COUNT);
+    bool isHit = Parser::getCacheHits() > hits;
+
+    isFailed = false;
+    try
+    {
+        value = Parser::evaluateFunctionMulti(x);
+    }
+    catch (mu::Parser::exception_type&)
+    {
+        isFailed = true;
+    }
+
+    return isHit;
+}
+}
+
+int main()
+{
+    struct Case
+    {
+        const char* previous;
+        const char* expression;
+        bool isHit;
+        bool isFailed;
+        double value;
+    };
+
+    const Case CASES[] =
+    {
+        { "x0<=1", "x0 < = 1", false, true, 0.0 },
+        { "x0 <= 1", "x0  <=\t1", true, false, 1.0 },
+        { "sum(x0,x1)", "sum( x0 , x1 )", true, false, 3.0 },
+        { "x0*x1+1", "x0 * x1 + 1", false, false, 3.0 }
+    };
+
+    const std::vector<double> x = { 1.0, 2.0 };
+    int failures = 0;
+
+    for (const Case& test : CASES)
+    {
+        double value = 0.0;
+        bool isFailed;
+        bool isHit = configure(test.previous, test.expression, x, value,
+                               isFailed);
+
+        bool isPassed = isHit == test.isHit && isFailed == test.isFailed &&
+                (isFailed || value == test.value);
+
+        std::printf("%-16s after %-12s %s: %s%s\n", test.expression,
+                    test.previous, isPassed ? "passed" : "FAILED",
+                    isHit ? "cached" : "compiled",
+                    isFailed ? ", fails to evaluate" : "");
+
+        if (!isPassed)
+            ++failures;
+    }
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}